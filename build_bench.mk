@@ -0,0 +1,52 @@
+ifndef VERBOSE
+.SILENT:
+endif
+
+.DEFAULT_GOAL := all
+
+include common.mk
+
+TARGET=bench/$(BENCH)
+
+BENCH_OBJ = $(BUILD_DIR)/bench_obj
+
+BENCH_PATH = tests/benchmarks/$(BENCH)
+
+OUTPUTS := $(BENCH_OBJ)/$(BENCH)
+
+LDFLAGS += -lstdc++ -shared-libgcc
+CREATE_MAP := no
+
+# Benchmarks measure the optimised pipeline, not the debug build used by the tests
+OPT = 2
+
+all: elf
+
+VPATH += $(COMMON_VPATH)
+PLATFORM:=TEST
+PLATFORM_KEY:=test
+
+include $(BENCH_PATH)/rules.mk
+
+include common_features.mk
+include $(TMK_PATH)/common.mk
+
+$(BENCH)_SRC= \
+	$(BENCH_PATH)/keymap.c \
+	$(TMK_COMMON_SRC) \
+	$(QUANTUM_SRC) \
+	$(SRC) \
+	tests/test_common/matrix.c
+$(BENCH)_SRC += $(patsubst $(ROOTDIR)/%,%,$(wildcard $(BENCH_PATH)/*.cpp))
+
+$(BENCH_OBJ)/$(BENCH)_SRC := $($(BENCH)_SRC)
+$(BENCH_OBJ)/$(BENCH)_INC := $(VPATH) tests/test_common
+$(BENCH_OBJ)/$(BENCH)_DEFS := $(TMK_COMMON_DEFS) $(OPT_DEFS)
+$(BENCH_OBJ)/$(BENCH)_CONFIG := $(BENCH_PATH)/config.h
+
+include $(TMK_PATH)/native.mk
+include $(TMK_PATH)/rules.mk
+
+
+$(shell mkdir -p $(BUILD_DIR)/bench 2>/dev/null)
+$(shell mkdir -p $(BENCH_OBJ) 2>/dev/null)
@@ -153,16 +153,22 @@ else
         SRC += $(PLATFORM_COMMON_DIR)/flash_stm32.c
         OPT_DEFS += -DEEPROM_EMU_STM32F303xC
         OPT_DEFS += -DSTM32_EEPROM_ENABLE
+        EEPROM_EMU_PAGE_SIZE = 0x800
+        FEE_DENSITY_PAGES ?= 10
       else ifeq ($(MCU_SERIES), STM32F1xx)
         SRC += $(PLATFORM_COMMON_DIR)/eeprom_stm32.c
         SRC += $(PLATFORM_COMMON_DIR)/flash_stm32.c
         OPT_DEFS += -DEEPROM_EMU_STM32F103xB
         OPT_DEFS += -DSTM32_EEPROM_ENABLE
+        EEPROM_EMU_PAGE_SIZE = 0x400
+        FEE_DENSITY_PAGES ?= 8
       else ifeq ($(MCU_SERIES)_$(MCU_LDSCRIPT), STM32F0xx_STM32F072xB)
         SRC += $(PLATFORM_COMMON_DIR)/eeprom_stm32.c
         SRC += $(PLATFORM_COMMON_DIR)/flash_stm32.c
         OPT_DEFS += -DEEPROM_EMU_STM32F072xB
         OPT_DEFS += -DSTM32_EEPROM_ENABLE
+        EEPROM_EMU_PAGE_SIZE = 0x800
+        FEE_DENSITY_PAGES ?= 10
       else ifeq ($(MCU_SERIES)_$(MCU_LDSCRIPT), STM32F0xx_STM32F042x6)
 
         # Stack sizes: Since this chip has limited RAM capacity, the stack area needs to be reduced.
@@ -174,6 +180,9 @@ else
         SRC += $(PLATFORM_COMMON_DIR)/flash_stm32.c
         OPT_DEFS += -DEEPROM_EMU_STM32F042x6
         OPT_DEFS += -DSTM32_EEPROM_ENABLE
+        EEPROM_EMU_PAGE_SIZE = 0x400
+        # 32kB of flash, keep the two pages the emulation always used
+        FEE_DENSITY_PAGES ?= 2
       else ifneq ($(filter $(MCU_SERIES),STM32L0xx STM32L1xx),)
         OPT_DEFS += -DEEPROM_DRIVER
         COMMON_VPATH += $(DRIVER_PATH)/eeprom
@@ -371,6 +380,7 @@ ifeq ($(strip $(BACKLIGHT_ENABLE)), yes)
         SRC += $(QUANTUM_DIR)/backlight/backlight_driver_common.c
         ifeq ($(strip $(BACKLIGHT_DRIVER)), pwm)
             SRC += $(QUANTUM_DIR)/backlight/backlight_$(PLATFORM_KEY).c
+            OPT_DEFS += -DBACKLIGHT_PWM_DRIVER
         else
             SRC += $(QUANTUM_DIR)/backlight/backlight_$(strip $(BACKLIGHT_DRIVER)).c
         endif
@@ -481,6 +491,7 @@ ifneq ($(strip $(CUSTOM_MATRIX)), yes)
     # if 'lite' then skip the actual matrix implementation
     ifneq ($(strip $(CUSTOM_MATRIX)), lite)
         # Include the standard or split matrix code if needed
+        QUANTUM_SRC += $(QUANTUM_DIR)/matrix_idle.c
         ifeq ($(strip $(SPLIT_KEYBOARD)), yes)
             QUANTUM_SRC += $(QUANTUM_DIR)/split_common/matrix.c
         else
@@ -41,6 +41,10 @@ void soft_serial_target_init(SSTD_t *sstd_table, int sstd_table_size);
 #define TRANSACTION_NO_RESPONSE 0x1
 #define TRANSACTION_DATA_ERROR 0x2
 #define TRANSACTION_TYPE_ERROR 0x4
+// Only returned by drivers that do not wait for the exchange: the data in
+// initiator2target_buffer has not been acknowledged yet, and
+// target2initiator_buffer still holds the last reply received.
+#define TRANSACTION_PENDING 0x10
 #ifndef SERIAL_USE_MULTI_TRANSACTION
 int soft_serial_transaction(void);
 #else
@@ -53,6 +57,7 @@ int soft_serial_transaction(int sstd_index);
 //       TRANSACTION_END
 //    or TRANSACTION_NO_RESPONSE
 //    or TRANSACTION_DATA_ERROR
+//    or TRANSACTION_PENDING
 //   target:
 //       TRANSACTION_DATA_ERROR
 //    or TRANSACTION_ACCEPTED
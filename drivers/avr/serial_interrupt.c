@@ -0,0 +1,571 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Interrupt driven soft serial
+ *
+ * Same single wire link and SSTD_t API as serial.c, but every bit is sent or
+ * sampled from a timer compare interrupt, so interrupts stay enabled for the
+ * whole transaction on both halves. Bytes are framed like a UART (start bit,
+ * 8 data bits LSB first, stop bit); the receiver lines up with each start bit
+ * through the pin's external interrupt and samples in the middle of the bits.
+ *
+ * A transaction is one packet from the initiator followed by one reply from
+ * the target, both ending with a CRC8:
+ *
+ *   initiator: [tid | ~tid] [initiator2target buffer] [crc]
+ *   target:    [ACK] [target2initiator buffer] [crc]
+ *
+ * Received data is only copied into the transaction buffers once its CRC
+ * matched, and the target snapshots its reply before sending it, so neither
+ * side ever sees half a transfer. The target does not reply to a packet that
+ * failed its CRC, the initiator reports that as TRANSACTION_NO_RESPONSE.
+ */
+
+#ifndef F_CPU
+#    define F_CPU 16000000
+#endif
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <util/crc16.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "gpio.h"
+#include "serial.h"
+
+#ifdef SOFT_SERIAL_PIN
+
+#    if !(defined(__AVR_AT90USB646__) || defined(__AVR_AT90USB647__) || defined(__AVR_AT90USB1286__) || defined(__AVR_AT90USB1287__) || defined(__AVR_AT90USB162__) || defined(__AVR_ATmega16U2__) || defined(__AVR_ATmega32U2__) || defined(__AVR_ATmega16U4__) || defined(__AVR_ATmega32U4__))
+#        error serial_interrupt.c is not supported for the currently selected MCU
+#    endif
+#    if defined(__AVR_ATmega16U4__) || defined(__AVR_ATmega32U4__) || defined(__AVR_AT90USB646__) || defined(__AVR_AT90USB647__) || defined(__AVR_AT90USB1286__) || defined(__AVR_AT90USB1287__)
+#        if defined(USE_AVR_I2C) && (SOFT_SERIAL_PIN == D0 || SOFT_SERIAL_PIN == D1)
+#            error Using I2C, so can not use PD0, PD1
+#        endif
+#    endif
+
+// external interrupt of the serial pin
+#    if SOFT_SERIAL_PIN == D0
+#        define SERIAL_INT 0
+#    elif SOFT_SERIAL_PIN == D1
+#        define SERIAL_INT 1
+#    elif SOFT_SERIAL_PIN == D2
+#        define SERIAL_INT 2
+#    elif SOFT_SERIAL_PIN == D3
+#        define SERIAL_INT 3
+#    elif defined(__AVR_ATmega16U2__) || defined(__AVR_ATmega32U2__) || defined(__AVR_AT90USB162__)
+#        if SOFT_SERIAL_PIN == C7
+#            define SERIAL_INT 4
+#        elif SOFT_SERIAL_PIN == D4
+#            define SERIAL_INT 5
+#        elif SOFT_SERIAL_PIN == D6
+#            define SERIAL_INT 6
+#        elif SOFT_SERIAL_PIN == D7
+#            define SERIAL_INT 7
+#        endif
+#    elif defined(__AVR_ATmega16U4__) || defined(__AVR_ATmega32U4__)
+#        if SOFT_SERIAL_PIN == E6
+#            define SERIAL_INT 6
+#        endif
+#    elif defined(__AVR_AT90USB646__) || defined(__AVR_AT90USB647__) || defined(__AVR_AT90USB1286__) || defined(__AVR_AT90USB1287__)
+#        if SOFT_SERIAL_PIN == E4
+#            define SERIAL_INT 4
+#        elif SOFT_SERIAL_PIN == E5
+#            define SERIAL_INT 5
+#        elif SOFT_SERIAL_PIN == E6
+#            define SERIAL_INT 6
+#        elif SOFT_SERIAL_PIN == E7
+#            define SERIAL_INT 7
+#        endif
+#    endif
+
+#    ifndef SERIAL_INT
+#        error invalid SOFT_SERIAL_PIN value
+#    endif
+
+#    define SERIAL_VECT_(n) INT##n##_vect
+#    define SERIAL_VECT(n) SERIAL_VECT_(n)
+#    define SERIAL_PIN_INTERRUPT SERIAL_VECT(SERIAL_INT)
+#    define EIMSK_BIT _BV(SERIAL_INT)
+#    if SERIAL_INT < 4
+#        define EICRx EICRA
+#    else
+#        define EICRx EICRB
+#    endif
+#    define EICRx_MASK (3 << ((SERIAL_INT & 3) * 2))
+#    define EICRx_FALLING (2 << ((SERIAL_INT & 3) * 2))
+
+#    ifndef SOFT_SERIAL_TIMER
+#        define SOFT_SERIAL_TIMER 1
+#    endif
+
+#    if SOFT_SERIAL_TIMER == 1
+#        define TCCRxA TCCR1A
+#        define TCCRxB TCCR1B
+#        define TCNTx TCNT1
+#        define OCRxA OCR1A
+#        define TIMSKx TIMSK1
+#        define OCIExA OCIE1A
+#        define TIFRx TIFR1
+#        define OCFxA OCF1A
+#        define TCCRxB_CTC (_BV(WGM12) | _BV(CS10))
+#        define TIMERx_COMPA_vect TIMER1_COMPA_vect
+#    elif SOFT_SERIAL_TIMER == 3
+#        define TCCRxA TCCR3A
+#        define TCCRxB TCCR3B
+#        define TCNTx TCNT3
+#        define OCRxA OCR3A
+#        define TIMSKx TIMSK3
+#        define OCIExA OCIE3A
+#        define TIFRx TIFR3
+#        define OCFxA OCF3A
+#        define TCCRxB_CTC (_BV(WGM32) | _BV(CS30))
+#        define TIMERx_COMPA_vect TIMER3_COMPA_vect
+#    else
+#        error invalid SOFT_SERIAL_TIMER value
+#    endif
+
+/* Timer of the AVR backlight driver, picked as in quantum/backlight/backlight_avr.c:
+ * hardware PWM on the timer behind BACKLIGHT_PIN, otherwise software PWM on
+ * timer 1, or on timer 3 when audio holds timer 1.
+ */
+#    if defined(BACKLIGHT_ENABLE) && defined(BACKLIGHT_PWM_DRIVER)
+#        if (defined(__AVR_AT90USB646__) || defined(__AVR_AT90USB647__) || defined(__AVR_AT90USB1286__) || defined(__AVR_AT90USB1287__) || defined(__AVR_ATmega16U4__) || defined(__AVR_ATmega32U4__)) && (BACKLIGHT_PIN == B5 || BACKLIGHT_PIN == B6 || BACKLIGHT_PIN == B7)
+#            define SERIAL_BACKLIGHT_TIMER 1
+#        elif (defined(__AVR_AT90USB646__) || defined(__AVR_AT90USB647__) || defined(__AVR_AT90USB1286__) || defined(__AVR_AT90USB1287__) || defined(__AVR_ATmega16U4__) || defined(__AVR_ATmega32U4__)) && (BACKLIGHT_PIN == C4 || BACKLIGHT_PIN == C5 || BACKLIGHT_PIN == C6)
+#            define SERIAL_BACKLIGHT_TIMER 3
+#        elif (defined(__AVR_AT90USB162__) || defined(__AVR_ATmega16U2__) || defined(__AVR_ATmega32U2__)) && (BACKLIGHT_PIN == B7 || BACKLIGHT_PIN == C5 || BACKLIGHT_PIN == C6)
+#            define SERIAL_BACKLIGHT_TIMER 1
+#        elif defined(__AVR_ATmega32A__) && (BACKLIGHT_PIN == D4 || BACKLIGHT_PIN == D5)
+#            define SERIAL_BACKLIGHT_TIMER 1
+#        elif (defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__)) && (BACKLIGHT_PIN == B1 || BACKLIGHT_PIN == B2)
+#            define SERIAL_BACKLIGHT_TIMER 1
+#        elif (AUDIO_PIN != B5) && (AUDIO_PIN != B6) && (AUDIO_PIN != B7) && (AUDIO_PIN_ALT != B5) && (AUDIO_PIN_ALT != B6) && (AUDIO_PIN_ALT != B7)
+#            define SERIAL_BACKLIGHT_TIMER 1
+#        elif (AUDIO_PIN != C4) && (AUDIO_PIN != C5) && (AUDIO_PIN != C6)
+#            define SERIAL_BACKLIGHT_TIMER 3
+#        endif
+#    endif
+#    ifndef SERIAL_BACKLIGHT_TIMER
+#        define SERIAL_BACKLIGHT_TIMER 0
+#    endif
+
+// The timer is reprogrammed for every transaction, so it can not have another owner
+#    if SOFT_SERIAL_TIMER == 1
+#        if SERIAL_BACKLIGHT_TIMER == 1
+#            error Backlight uses timer 1 with this pin and audio setup, set SOFT_SERIAL_TIMER to 3
+#        endif
+#        if defined(AUDIO_ENABLE) && (defined(B5_AUDIO) || defined(B6_AUDIO) || defined(B7_AUDIO) || (defined(AUDIO_PIN) && (AUDIO_PIN == B5 || AUDIO_PIN == B6 || AUDIO_PIN == B7)) || (defined(AUDIO_PIN_ALT) && (AUDIO_PIN_ALT == B5 || AUDIO_PIN_ALT == B6 || AUDIO_PIN_ALT == B7)))
+#            error Audio uses timer 1 on this pin, set SOFT_SERIAL_TIMER to 3
+#        endif
+#        if defined(SLEEP_LED_ENABLE) && (!defined(SLEEP_LED_TIMER) || SLEEP_LED_TIMER == 1)
+#            error The sleep LED uses timer 1, set SOFT_SERIAL_TIMER or SLEEP_LED_TIMER to 3
+#        endif
+#    elif SOFT_SERIAL_TIMER == 3
+#        if SERIAL_BACKLIGHT_TIMER == 3
+#            error Backlight uses timer 3 with this pin and audio setup, set SOFT_SERIAL_TIMER to 1
+#        endif
+#        if defined(AUDIO_ENABLE) && (defined(C4_AUDIO) || defined(C5_AUDIO) || defined(C6_AUDIO) || (defined(AUDIO_PIN) && (AUDIO_PIN == C4 || AUDIO_PIN == C5 || AUDIO_PIN == C6)))
+#            error Audio uses timer 3 on this pin, set SOFT_SERIAL_TIMER to 1
+#        endif
+#        if defined(SLEEP_LED_ENABLE) && defined(SLEEP_LED_TIMER) && SLEEP_LED_TIMER == 3
+#            error The sleep LED uses timer 3, set SOFT_SERIAL_TIMER or SLEEP_LED_TIMER to 1
+#        endif
+#    endif
+
+#    ifndef SELECT_SOFT_SERIAL_SPEED
+#        define SELECT_SOFT_SERIAL_SPEED 1
+//  0: 125000 baud (Experimental only)
+//  1: 62500 baud (default)
+//  2: 31250 baud
+//  3: 15625 baud
+//  4: 10417 baud
+//  5: 7813 baud
+#    endif
+
+#    if SELECT_SOFT_SERIAL_SPEED == 0
+#        define SERIAL_BIT_US 8
+#    elif SELECT_SOFT_SERIAL_SPEED == 1
+#        define SERIAL_BIT_US 16
+#    elif SELECT_SOFT_SERIAL_SPEED == 2
+#        define SERIAL_BIT_US 32
+#    elif SELECT_SOFT_SERIAL_SPEED == 3
+#        define SERIAL_BIT_US 64
+#    elif SELECT_SOFT_SERIAL_SPEED == 4
+#        define SERIAL_BIT_US 96
+#    elif SELECT_SOFT_SERIAL_SPEED == 5
+#        define SERIAL_BIT_US 128
+#    else
+#        error invalid SELECT_SOFT_SERIAL_SPEED value
+#    endif
+
+// timer runs at F_CPU
+#    define SERIAL_BIT_TICKS ((uint16_t)(F_CPU / 1000000 * SERIAL_BIT_US))
+// the first sample after a start bit edge is in the middle of the first data bit
+#    define SERIAL_FIRST_SAMPLE_TICKS (SERIAL_BIT_TICKS + SERIAL_BIT_TICKS / 2)
+
+// bit times a side waits before driving the line the other side just sent on
+#    define SERIAL_TURNAROUND_BITS 2
+// bit times the initiator waits for the reply to start
+#    ifndef SERIAL_RESPONSE_BITS
+#        define SERIAL_RESPONSE_BITS 16
+#    endif
+// bit times between two bytes of a packet after which the packet is dropped
+#    ifndef SERIAL_GAP_BITS
+#        define SERIAL_GAP_BITS 8
+#    endif
+
+#    define SERIAL_ACK 0xA5
+
+enum serial_state {
+    SERIAL_IDLE,
+    SERIAL_SEND,
+    SERIAL_RECEIVE,
+    SERIAL_TURNAROUND,
+};
+
+static SSTD_t *Transaction_table      = NULL;
+static uint8_t Transaction_table_size = 0;
+static bool    is_target              = false;
+
+// header, largest buffer and crc of the packet being sent or received
+static uint8_t *packet;
+static uint8_t  packet_length;
+static uint8_t  packet_index;
+
+static volatile uint8_t state = SERIAL_IDLE;
+static volatile uint8_t result;
+static SSTD_t *         current;
+static uint8_t          bit_index;
+static uint8_t          shifter;
+static uint8_t          idle_bits;
+
+inline static void serial_output(void) { setPinOutput(SOFT_SERIAL_PIN); }
+
+// make the serial pin an input with pull-up resistor
+inline static void serial_input_with_pullup(void) { setPinInputHigh(SOFT_SERIAL_PIN); }
+
+inline static void serial_write_bit(uint8_t level) {
+    if (level) {
+        writePinHigh(SOFT_SERIAL_PIN);
+    } else {
+        writePinLow(SOFT_SERIAL_PIN);
+    }
+}
+
+inline static void timer_start(uint16_t ticks) {
+    TCCRxB = 0;
+    TCCRxA = 0;
+    TCNTx  = 0;
+    OCRxA  = ticks;
+    TIFRx  = _BV(OCFxA);
+    TIMSKx |= _BV(OCIExA);
+    TCCRxB = TCCRxB_CTC;
+}
+
+inline static void timer_stop(void) {
+    TCCRxB = 0;
+    TIMSKx &= ~_BV(OCIExA);
+}
+
+inline static void edge_interrupt_enable(void) {
+    EIFR = EIMSK_BIT;
+    EIMSK |= EIMSK_BIT;
+}
+
+inline static void edge_interrupt_disable(void) { EIMSK &= ~EIMSK_BIT; }
+
+static uint8_t packet_crc(uint8_t length) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < length; i++) {
+        crc = _crc8_ccitt_update(crc, packet[i]);
+    }
+    return crc;
+}
+
+// fills in the crc and starts sending length bytes of packet
+static void send_packet(uint8_t length) {
+    packet[length - 1] = packet_crc(length - 1);
+    packet_length      = length;
+    packet_index       = 0;
+    serial_write_bit(1);
+    serial_output();
+    serial_write_bit(0);  // start bit
+    bit_index = 1;
+    state     = SERIAL_SEND;
+    timer_start(SERIAL_BIT_TICKS);
+}
+
+static void listen(void) {
+    packet_index = 0;
+    bit_index    = 0;
+    idle_bits    = 0;
+    state        = SERIAL_RECEIVE;
+    serial_input_with_pullup();
+    edge_interrupt_enable();
+}
+
+// the initiator is done with the transaction, the next one may start once the
+// target had time to let go of the line
+static void finish(uint8_t status) {
+    edge_interrupt_disable();
+    result    = status;
+    idle_bits = 0;
+    state     = SERIAL_TURNAROUND;
+    OCRxA     = SERIAL_BIT_TICKS;
+}
+
+// the target drops the current packet and waits for the next one
+static void restart(void) {
+    timer_stop();
+    listen();
+}
+
+static void packet_sent(void) {
+    if (is_target) {
+        restart();
+    } else {
+        // wait for the reply
+        packet_length = current->target2initiator_buffer_size + 2;
+        listen();
+        timer_start(SERIAL_BIT_TICKS);
+    }
+}
+
+static void target_reply(void) {
+    uint8_t size = current->target2initiator_buffer_size;
+    if (size > 0) {
+        memcpy(&packet[1], current->target2initiator_buffer, size);
+    }
+    send_packet(size + 2);
+}
+
+static void byte_received(uint8_t data) {
+    packet[packet_index++] = data;
+
+    if (is_target && packet_index == 1) {
+        uint8_t tid = data >> 4;
+        if ((uint8_t)(~data & 0xF) != tid || tid >= Transaction_table_size) {
+            restart();
+            return;
+        }
+        current       = &Transaction_table[tid];
+        packet_length = current->initiator2target_buffer_size + 2;
+    }
+
+    if (packet_index < packet_length) {
+        return;
+    }
+
+    bool    valid = packet_crc(packet_length - 1) == packet[packet_length - 1];
+    uint8_t size  = packet_length - 2;
+    if (is_target) {
+        if (!valid) {
+            // the packet may have ended early, replying could clash with the initiator
+            *current->status = TRANSACTION_DATA_ERROR;
+            restart();
+            return;
+        }
+        if (size > 0) {
+            memcpy(current->initiator2target_buffer, &packet[1], size);
+        }
+        *current->status = TRANSACTION_ACCEPTED;
+        packet[0]        = SERIAL_ACK;
+        edge_interrupt_disable();
+        idle_bits = 0;
+        state     = SERIAL_TURNAROUND;
+        OCRxA     = SERIAL_BIT_TICKS;
+    } else if (valid && packet[0] == SERIAL_ACK) {
+        if (size > 0) {
+            memcpy(current->target2initiator_buffer, &packet[1], size);
+        }
+        finish(TRANSACTION_END);
+    } else {
+        finish(TRANSACTION_DATA_ERROR);
+    }
+}
+
+// start bit of a byte
+ISR(SERIAL_PIN_INTERRUPT) {
+    edge_interrupt_disable();
+    if (packet_index == 0 && is_target) {
+        timer_start(SERIAL_FIRST_SAMPLE_TICKS);
+    } else {
+        TCNTx = 0;
+        OCRxA = SERIAL_FIRST_SAMPLE_TICKS;
+        TIFRx = _BV(OCFxA);
+    }
+    bit_index = 1;
+    shifter   = 0;
+}
+
+ISR(TIMERx_COMPA_vect) {
+    switch (state) {
+        case SERIAL_SEND:
+            if (bit_index <= 8) {
+                serial_write_bit(packet[packet_index] & _BV(bit_index - 1));
+                bit_index++;
+            } else if (bit_index == 9) {
+                serial_write_bit(1);  // stop bit
+                bit_index++;
+            } else if (++packet_index < packet_length) {
+                serial_write_bit(0);  // start bit
+                bit_index = 1;
+            } else {
+                packet_sent();
+            }
+            break;
+
+        case SERIAL_RECEIVE:
+            if (bit_index == 0) {
+                // waiting for a start bit
+                if (++idle_bits > (packet_index ? SERIAL_GAP_BITS : SERIAL_RESPONSE_BITS)) {
+                    if (is_target) {
+                        restart();
+                    } else {
+                        finish(packet_index ? TRANSACTION_DATA_ERROR : TRANSACTION_NO_RESPONSE);
+                    }
+                }
+            } else if (bit_index <= 8) {
+                OCRxA = SERIAL_BIT_TICKS;
+                shifter >>= 1;
+                if (readPin(SOFT_SERIAL_PIN)) {
+                    shifter |= 0x80;
+                }
+                bit_index++;
+            } else {
+                // middle of the stop bit
+                bit_index = 0;
+                idle_bits = 0;
+                if (!readPin(SOFT_SERIAL_PIN)) {
+                    if (is_target) {
+                        restart();
+                    } else {
+                        finish(TRANSACTION_DATA_ERROR);
+                    }
+                    break;
+                }
+                edge_interrupt_enable();
+                byte_received(shifter);
+            }
+            break;
+
+        case SERIAL_TURNAROUND:
+            if (++idle_bits < SERIAL_TURNAROUND_BITS) {
+                break;
+            }
+            if (is_target) {
+                target_reply();
+            } else {
+                timer_stop();
+                state = SERIAL_IDLE;
+            }
+            break;
+
+        default:
+            timer_stop();
+            break;
+    }
+}
+
+// the packet buffer has to hold the largest buffer of any transaction
+static bool packet_alloc(SSTD_t *sstd_table, int sstd_table_size) {
+    uint8_t size = 0;
+    for (int i = 0; i < sstd_table_size; i++) {
+        if (sstd_table[i].initiator2target_buffer_size > size) {
+            size = sstd_table[i].initiator2target_buffer_size;
+        }
+        if (sstd_table[i].target2initiator_buffer_size > size) {
+            size = sstd_table[i].target2initiator_buffer_size;
+        }
+    }
+    packet = (uint8_t *)malloc(size + 2);
+    return packet != NULL;
+}
+
+void soft_serial_initiator_init(SSTD_t *sstd_table, int sstd_table_size) {
+    Transaction_table      = sstd_table;
+    Transaction_table_size = (uint8_t)sstd_table_size;
+    is_target              = false;
+    if (!packet_alloc(sstd_table, sstd_table_size)) {
+        Transaction_table_size = 0;
+    }
+    // the line is only driven while sending, the pull-ups keep it high otherwise
+    serial_input_with_pullup();
+
+    EICRx = (EICRx & ~EICRx_MASK) | EICRx_FALLING;
+}
+
+void soft_serial_target_init(SSTD_t *sstd_table, int sstd_table_size) {
+    Transaction_table      = sstd_table;
+    Transaction_table_size = (uint8_t)sstd_table_size;
+    is_target              = true;
+    if (!packet_alloc(sstd_table, sstd_table_size)) {
+        Transaction_table_size = 0;
+    }
+
+    EICRx = (EICRx & ~EICRx_MASK) | EICRx_FALLING;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { listen(); }
+}
+
+/////////
+//  start transaction by initiator
+//
+// int  soft_serial_transaction(int sstd_index)
+//
+// Returns:
+//    TRANSACTION_END
+//    TRANSACTION_NO_RESPONSE
+//    TRANSACTION_DATA_ERROR
+// waits for the transaction to complete with interrupts enabled
+#    ifndef SERIAL_USE_MULTI_TRANSACTION
+int soft_serial_transaction(void) {
+    uint8_t sstd_index = 0;
+#    else
+int soft_serial_transaction(int sstd_index) {
+#    endif
+    if (sstd_index >= Transaction_table_size) return TRANSACTION_TYPE_ERROR;
+    current = &Transaction_table[sstd_index];
+
+    uint8_t size = current->initiator2target_buffer_size;
+    packet[0]    = (sstd_index << 4) | (~sstd_index & 0xF);
+    if (size > 0) {
+        memcpy(&packet[1], current->initiator2target_buffer, size);
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { send_packet(size + 2); }
+
+    while (state != SERIAL_IDLE) {
+    }
+
+    *current->status = result;
+    return result;
+}
+
+#    ifdef SERIAL_USE_MULTI_TRANSACTION
+int soft_serial_get_and_clean_status(int sstd_index) {
+    SSTD_t *trans = &Transaction_table[sstd_index];
+    int     retval;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        retval         = *trans->status;
+        *trans->status = 0;
+    }
+    return retval;
+}
+#    endif
+
+#endif
@@ -31,6 +31,16 @@
 
 static uint8_t i2c_address;
 
+// Serialise transfers when several threads share the bus, e.g. an
+// ISSI_ASYNC_FLUSH worker updating LED drivers.
+#if I2C_USE_MUTUAL_EXCLUSION == TRUE
+#    define i2c_acquire_bus() i2cAcquireBus(&I2C_DRIVER)
+#    define i2c_release_bus() i2cReleaseBus(&I2C_DRIVER)
+#else
+#    define i2c_acquire_bus()
+#    define i2c_release_bus()
+#endif
+
 static const I2CConfig i2cconfig = {
 #if defined(USE_I2CV1_CONTRIB)
     I2C1_CLOCK_SPEED,
@@ -84,37 +94,44 @@ i2c_status_t i2c_start(uint8_t address) {
 }
 
 i2c_status_t i2c_transmit(uint8_t address, const uint8_t* data, uint16_t length, uint16_t timeout) {
+    i2c_acquire_bus();
     i2c_address = address;
     i2cStart(&I2C_DRIVER, &i2cconfig);
     msg_t status = i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), data, length, 0, 0, TIME_MS2I(timeout));
+    i2c_release_bus();
     return chibios_to_qmk(&status);
 }
 
 i2c_status_t i2c_receive(uint8_t address, uint8_t* data, uint16_t length, uint16_t timeout) {
+    i2c_acquire_bus();
     i2c_address = address;
     i2cStart(&I2C_DRIVER, &i2cconfig);
     msg_t status = i2cMasterReceiveTimeout(&I2C_DRIVER, (i2c_address >> 1), data, length, TIME_MS2I(timeout));
+    i2c_release_bus();
     return chibios_to_qmk(&status);
 }
 
 i2c_status_t i2c_writeReg(uint8_t devaddr, uint8_t regaddr, const uint8_t* data, uint16_t length, uint16_t timeout) {
-    i2c_address = devaddr;
-    i2cStart(&I2C_DRIVER, &i2cconfig);
-
     uint8_t complete_packet[length + 1];
     for (uint8_t i = 0; i < length; i++) {
         complete_packet[i + 1] = data[i];
     }
     complete_packet[0] = regaddr;
 
+    i2c_acquire_bus();
+    i2c_address = devaddr;
+    i2cStart(&I2C_DRIVER, &i2cconfig);
     msg_t status = i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), complete_packet, length + 1, 0, 0, TIME_MS2I(timeout));
+    i2c_release_bus();
     return chibios_to_qmk(&status);
 }
 
 i2c_status_t i2c_readReg(uint8_t devaddr, uint8_t regaddr, uint8_t* data, uint16_t length, uint16_t timeout) {
+    i2c_acquire_bus();
     i2c_address = devaddr;
     i2cStart(&I2C_DRIVER, &i2cconfig);
     msg_t status = i2cMasterTransmitTimeout(&I2C_DRIVER, (i2c_address >> 1), &regaddr, 1, data, length, TIME_MS2I(timeout));
+    i2c_release_bus();
     return chibios_to_qmk(&status);
 }
 
@@ -0,0 +1,481 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Full duplex USART transport using the ChibiOS UART driver
+ *
+ * Frames are moved by DMA on both halves and handled in the driver callbacks,
+ * so neither side blocks. Every frame looks like
+ *
+ *   [sync] [transaction id] [sequence] [length] [payload] [crc16]
+ *
+ * The master sends the initiator2target buffer of a transaction, the slave
+ * answers with its target2initiator buffer and the same sequence number.
+ * Frames are received into two alternating buffers: as soon as one is
+ * complete the DMA is pointed at the other for the next header, then the
+ * complete one is checked. A frame that does not start with the sync byte or
+ * fails its CRC drops the receiver back to looking for a sync byte one
+ * character at a time.
+ *
+ * soft_serial_transaction() does not wait. It queues the current
+ * initiator2target data to be sent and hands back the last reply received.
+ * It returns TRANSACTION_END only once the slave acknowledged exactly that
+ * data, TRANSACTION_PENDING while it is still on its way, and the failure if
+ * the last exchange of the transaction got no reply. Exchanges run one at a
+ * time; a request that gets no reply within SERIAL_USART_TIMEOUT ms is sent
+ * again up to SERIAL_USART_RETRIES times.
+ */
+
+#include "quantum.h"
+#include "serial.h"
+#include "print.h"
+
+#include <ch.h>
+#include <hal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !HAL_USE_UART
+#    error The USART DMA split transport needs HAL_USE_UART set to TRUE in halconf.h
+#endif
+
+#ifndef USE_GPIOV1
+// The default PAL alternate modes are used to signal that the pins are used for USART
+#    ifndef SERIAL_USART_TX_PAL_MODE
+#        define SERIAL_USART_TX_PAL_MODE 7
+#    endif
+#    ifndef SERIAL_USART_RX_PAL_MODE
+#        define SERIAL_USART_RX_PAL_MODE 7
+#    endif
+#endif
+
+#ifndef SERIAL_USART_DRIVER
+#    define SERIAL_USART_DRIVER UARTD1
+#endif
+
+#ifndef SERIAL_USART_CR1
+#    define SERIAL_USART_CR1 0  // 8 bit length, no parity, frames carry a CRC
+#endif
+
+#ifndef SERIAL_USART_CR2
+#    define SERIAL_USART_CR2 0  // 1 stop bit
+#endif
+
+#ifndef SERIAL_USART_CR3
+#    define SERIAL_USART_CR3 0
+#endif
+
+#ifdef SOFT_SERIAL_PIN
+#    define SERIAL_USART_TX_PIN SOFT_SERIAL_PIN
+#endif
+
+#ifndef SERIAL_USART_RX_PIN
+#    error SERIAL_USART_RX_PIN has to be defined for the full duplex USART transport
+#endif
+
+#ifndef SELECT_SOFT_SERIAL_SPEED
+#    define SELECT_SOFT_SERIAL_SPEED 1
+#endif
+
+#ifdef SERIAL_USART_SPEED
+// Allow advanced users to directly set SERIAL_USART_SPEED
+#elif SELECT_SOFT_SERIAL_SPEED == 0
+#    define SERIAL_USART_SPEED 460800
+#elif SELECT_SOFT_SERIAL_SPEED == 1
+#    define SERIAL_USART_SPEED 230400
+#elif SELECT_SOFT_SERIAL_SPEED == 2
+#    define SERIAL_USART_SPEED 115200
+#elif SELECT_SOFT_SERIAL_SPEED == 3
+#    define SERIAL_USART_SPEED 57600
+#elif SELECT_SOFT_SERIAL_SPEED == 4
+#    define SERIAL_USART_SPEED 38400
+#elif SELECT_SOFT_SERIAL_SPEED == 5
+#    define SERIAL_USART_SPEED 19200
+#else
+#    error invalid SELECT_SOFT_SERIAL_SPEED value
+#endif
+
+// time in ms the master waits for a reply before sending the request again
+#ifndef SERIAL_USART_TIMEOUT
+#    define SERIAL_USART_TIMEOUT 5
+#endif
+
+#ifndef SERIAL_USART_RETRIES
+#    define SERIAL_USART_RETRIES 3
+#endif
+
+#define FRAME_SYNC 0xA5
+#define FRAME_HEADER_SIZE 4
+#define FRAME_OVERHEAD (FRAME_HEADER_SIZE + 2)
+#define NO_TRANSACTION 0xFF
+
+enum frame_field {
+    FRAME_FIELD_SYNC,
+    FRAME_FIELD_ID,
+    FRAME_FIELD_SEQUENCE,
+    FRAME_FIELD_LENGTH,
+    FRAME_FIELD_PAYLOAD,
+};
+
+enum receive_stage {
+    RECEIVE_SYNC,    // looking for a sync byte through rxchar_cb
+    RECEIVE_HEADER,  // DMA into the header
+    RECEIVE_BODY,    // DMA into the payload and CRC
+};
+
+typedef struct {
+    uint8_t *request;   // master: initiator2target data waiting to be sent
+    uint8_t *acked;     // master: initiator2target data of the last exchange the slave replied to
+    uint8_t *reply;     // master: target2initiator data of the last reply
+    uint8_t  sequence;  // master: of the request in flight, slave: of the last request accepted
+    bool     queued;    // master: request waiting for the line
+    bool     replied;   // master: reply not collected yet, slave: sequence is valid
+    uint8_t  result;    // master: result of the last exchange that completed
+} usart_channel_t;
+
+static SSTD_t *         Transaction_table      = NULL;
+static uint8_t          Transaction_table_size = 0;
+static usart_channel_t *channels;
+static bool             is_master;
+
+static uint8_t  max_payload;
+static uint8_t *tx_frame;
+static uint8_t *rx_frames[2];
+static uint8_t  rx_slot;
+static uint8_t  rx_stage;
+
+// master only
+static uint8_t        in_flight = NO_TRANSACTION;
+static uint8_t        last_sent = NO_TRANSACTION;
+static uint8_t        tries;
+static virtual_timer_t reply_timer;
+
+// CRC-16/CCITT-FALSE
+static uint16_t crc16(const uint8_t *data, uint8_t length) {
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static inline uint8_t frame_size(const uint8_t *frame) { return FRAME_OVERHEAD + frame[FRAME_FIELD_LENGTH]; }
+
+static void send_frame_I(uint8_t id, uint8_t sequence, const uint8_t *payload, uint8_t length) {
+    tx_frame[FRAME_FIELD_SYNC]     = FRAME_SYNC;
+    tx_frame[FRAME_FIELD_ID]       = id;
+    tx_frame[FRAME_FIELD_SEQUENCE] = sequence;
+    tx_frame[FRAME_FIELD_LENGTH]   = length;
+    if (length > 0) {
+        memcpy(&tx_frame[FRAME_FIELD_PAYLOAD], payload, length);
+    }
+    uint16_t crc                             = crc16(tx_frame, FRAME_HEADER_SIZE + length);
+    tx_frame[FRAME_HEADER_SIZE + length]     = crc >> 8;
+    tx_frame[FRAME_HEADER_SIZE + length + 1] = crc & 0xFF;
+    uartStartSendI(&SERIAL_USART_DRIVER, frame_size(tx_frame), tx_frame);
+}
+
+/* Master */
+
+static void reply_timeout(void *arg);
+
+static void resend_I(void) {
+    if (SERIAL_USART_DRIVER.txstate != UART_TX_ACTIVE) {
+        uartStartSendI(&SERIAL_USART_DRIVER, frame_size(tx_frame), tx_frame);
+    }
+    chVTSetI(&reply_timer, TIME_MS2I(SERIAL_USART_TIMEOUT), reply_timeout, NULL);
+}
+
+// sends the next queued request, taking turns between transactions
+static void start_next_I(void) {
+    in_flight = NO_TRANSACTION;
+    if (SERIAL_USART_DRIVER.txstate == UART_TX_ACTIVE) {
+        return;  // picked up by txend() once the line is free
+    }
+    for (uint8_t i = 1; i <= Transaction_table_size; i++) {
+        uint8_t          id      = (last_sent + i) % Transaction_table_size;
+        usart_channel_t *channel = &channels[id];
+        if (!channel->queued) {
+            continue;
+        }
+        channel->queued = false;
+        channel->sequence++;
+        in_flight = last_sent = id;
+        tries                 = 1;
+        send_frame_I(id, channel->sequence, channel->request, Transaction_table[id].initiator2target_buffer_size);
+        chVTSetI(&reply_timer, TIME_MS2I(SERIAL_USART_TIMEOUT), reply_timeout, NULL);
+        return;
+    }
+}
+
+static void reply_timeout(void *arg) {
+    (void)arg;
+    osalSysLockFromISR();
+    if (in_flight != NO_TRANSACTION) {
+        if (tries < SERIAL_USART_RETRIES) {
+            tries++;
+            resend_I();
+        } else {
+            channels[in_flight].result = TRANSACTION_NO_RESPONSE;
+            start_next_I();
+        }
+    }
+    osalSysUnlockFromISR();
+}
+
+static void master_receive_I(const uint8_t *frame) {
+    uint8_t id = frame[FRAME_FIELD_ID];
+    if (id != in_flight || frame[FRAME_FIELD_SEQUENCE] != channels[id].sequence || frame[FRAME_FIELD_LENGTH] != Transaction_table[id].target2initiator_buffer_size) {
+        return;  // late reply to a request that was given up on
+    }
+
+    usart_channel_t *channel = &channels[id];
+    if (frame[FRAME_FIELD_LENGTH] > 0) {
+        memcpy(channel->reply, &frame[FRAME_FIELD_PAYLOAD], frame[FRAME_FIELD_LENGTH]);
+    }
+    // tx_frame still holds the request this is the reply to
+    if (Transaction_table[id].initiator2target_buffer_size > 0) {
+        memcpy(channel->acked, &tx_frame[FRAME_FIELD_PAYLOAD], Transaction_table[id].initiator2target_buffer_size);
+    }
+    channel->replied = true;
+    channel->result  = TRANSACTION_END;
+    chVTResetI(&reply_timer);
+    start_next_I();
+}
+
+/* Slave */
+
+static void slave_receive_I(const uint8_t *frame) {
+    uint8_t id = frame[FRAME_FIELD_ID];
+    if (id >= Transaction_table_size || frame[FRAME_FIELD_LENGTH] != Transaction_table[id].initiator2target_buffer_size) {
+        return;
+    }
+
+    SSTD_t *         trans    = &Transaction_table[id];
+    usart_channel_t *channel  = &channels[id];
+    uint8_t          sequence = frame[FRAME_FIELD_SEQUENCE];
+    // a repeated sequence means our reply was lost, only the reply is sent again
+    if (!channel->replied || channel->sequence != sequence) {
+        if (trans->initiator2target_buffer_size > 0) {
+            memcpy(trans->initiator2target_buffer, &frame[FRAME_FIELD_PAYLOAD], trans->initiator2target_buffer_size);
+        }
+        channel->sequence = sequence;
+        channel->replied  = true;
+        if (trans->status) {
+            *trans->status = TRANSACTION_ACCEPTED;
+        }
+    }
+
+    if (SERIAL_USART_DRIVER.txstate != UART_TX_ACTIVE) {
+        send_frame_I(id, sequence, trans->target2initiator_buffer, trans->target2initiator_buffer_size);
+    }
+}
+
+/* Receiver */
+
+static void receive_header_I(uint8_t skip) {
+    rx_stage = RECEIVE_HEADER;
+    uartStartReceiveI(&SERIAL_USART_DRIVER, FRAME_HEADER_SIZE - skip, &rx_frames[rx_slot][skip]);
+}
+
+static void rxchar(UARTDriver *uartp, uint16_t c) {
+    (void)uartp;
+    if (rx_stage == RECEIVE_SYNC && (uint8_t)c == FRAME_SYNC) {
+        osalSysLockFromISR();
+        rx_frames[rx_slot][FRAME_FIELD_SYNC] = FRAME_SYNC;
+        receive_header_I(1);
+        osalSysUnlockFromISR();
+    }
+}
+
+static void rxend(UARTDriver *uartp) {
+    (void)uartp;
+    uint8_t *frame = rx_frames[rx_slot];
+
+    osalSysLockFromISR();
+    if (rx_stage == RECEIVE_HEADER) {
+        if (frame[FRAME_FIELD_SYNC] == FRAME_SYNC && frame[FRAME_FIELD_LENGTH] <= max_payload) {
+            rx_stage = RECEIVE_BODY;
+            uartStartReceiveI(&SERIAL_USART_DRIVER, frame[FRAME_FIELD_LENGTH] + 2, &frame[FRAME_FIELD_PAYLOAD]);
+        } else {
+            rx_stage = RECEIVE_SYNC;
+        }
+    } else if (rx_stage == RECEIVE_BODY) {
+        uint8_t length = FRAME_HEADER_SIZE + frame[FRAME_FIELD_LENGTH];
+        if (crc16(frame, length) == ((frame[length] << 8) | frame[length + 1])) {
+            // the next header goes into the other buffer while this frame is handled
+            rx_slot ^= 1;
+            receive_header_I(0);
+            if (is_master) {
+                master_receive_I(frame);
+            } else {
+                slave_receive_I(frame);
+            }
+        } else {
+            rx_stage = RECEIVE_SYNC;
+        }
+    }
+    osalSysUnlockFromISR();
+}
+
+static void txend(UARTDriver *uartp) {
+    (void)uartp;
+    osalSysLockFromISR();
+    if (is_master && in_flight == NO_TRANSACTION) {
+        start_next_I();
+    }
+    osalSysUnlockFromISR();
+}
+
+static void rxerr(UARTDriver *uartp, uartflags_t e) {
+    (void)e;
+    osalSysLockFromISR();
+    uartStopReceiveI(uartp);
+    rx_stage = RECEIVE_SYNC;
+    osalSysUnlockFromISR();
+}
+
+static UARTConfig uart_config = {
+    .txend1_cb = txend,
+    .txend2_cb = NULL,
+    .rxend_cb  = rxend,
+    .rxchar_cb = rxchar,
+    .rxerr_cb  = rxerr,
+    .speed     = SERIAL_USART_SPEED,
+    .cr1       = SERIAL_USART_CR1,
+    .cr2       = SERIAL_USART_CR2,
+    .cr3       = SERIAL_USART_CR3,
+};
+
+__attribute__((weak)) void usart_init(void) {
+#if defined(USE_GPIOV1)
+    palSetLineMode(SERIAL_USART_TX_PIN, PAL_MODE_STM32_ALTERNATE_PUSHPULL);
+    palSetLineMode(SERIAL_USART_RX_PIN, PAL_MODE_INPUT_PULLUP);
+#else
+    palSetLineMode(SERIAL_USART_TX_PIN, PAL_MODE_ALTERNATE(SERIAL_USART_TX_PAL_MODE) | PAL_STM32_OTYPE_PUSHPULL);
+    palSetLineMode(SERIAL_USART_RX_PIN, PAL_MODE_ALTERNATE(SERIAL_USART_RX_PAL_MODE) | PAL_STM32_PUPDR_PULLUP);
+#endif
+}
+
+// buffers are sized for the largest transaction
+static bool usart_alloc(void) {
+    channels = calloc(Transaction_table_size, sizeof(usart_channel_t));
+    if (channels == NULL) {
+        return false;
+    }
+
+    max_payload = 0;
+    for (uint8_t i = 0; i < Transaction_table_size; i++) {
+        SSTD_t *trans = &Transaction_table[i];
+        if (trans->initiator2target_buffer_size > max_payload) {
+            max_payload = trans->initiator2target_buffer_size;
+        }
+        if (trans->target2initiator_buffer_size > max_payload) {
+            max_payload = trans->target2initiator_buffer_size;
+        }
+        if (is_master) {
+            channels[i].request = malloc(trans->initiator2target_buffer_size);
+            channels[i].acked   = malloc(trans->initiator2target_buffer_size);
+            channels[i].reply   = malloc(trans->target2initiator_buffer_size);
+            channels[i].result  = TRANSACTION_NO_RESPONSE;
+            if ((trans->initiator2target_buffer_size && (!channels[i].request || !channels[i].acked)) || (trans->target2initiator_buffer_size && !channels[i].reply)) {
+                return false;
+            }
+        }
+    }
+
+    tx_frame     = malloc(FRAME_OVERHEAD + max_payload);
+    rx_frames[0] = malloc(FRAME_OVERHEAD + max_payload);
+    rx_frames[1] = malloc(FRAME_OVERHEAD + max_payload);
+    return tx_frame && rx_frames[0] && rx_frames[1];
+}
+
+static void usart_start(SSTD_t *sstd_table, int sstd_table_size) {
+    Transaction_table      = sstd_table;
+    Transaction_table_size = (uint8_t)sstd_table_size;
+    if (!usart_alloc()) {
+        dprintf("serial::usart_dma out of memory\n");
+        Transaction_table_size = 0;
+        return;
+    }
+
+    usart_init();
+    chVTObjectInit(&reply_timer);
+    rx_stage = RECEIVE_SYNC;
+    uartStart(&SERIAL_USART_DRIVER, &uart_config);
+}
+
+void soft_serial_initiator_init(SSTD_t *sstd_table, int sstd_table_size) {
+    is_master = true;
+    usart_start(sstd_table, sstd_table_size);
+}
+
+void soft_serial_target_init(SSTD_t *sstd_table, int sstd_table_size) {
+    is_master = false;
+#ifdef SERIAL_USART_PIN_SWAP
+    // lets both halves use the same pins with a straight through cable
+    uart_config.cr2 |= USART_CR2_SWAP;
+#endif
+    usart_start(sstd_table, sstd_table_size);
+}
+
+/////////
+//  start transaction by initiator
+//
+// int  soft_serial_transaction(int sstd_index)
+//
+// Returns:
+//    TRANSACTION_END          the slave acknowledged the current initiator2target data
+//    TRANSACTION_PENDING      the current data has not been acknowledged yet
+//    TRANSACTION_NO_RESPONSE  the last exchange of the transaction failed
+#ifndef SERIAL_USE_MULTI_TRANSACTION
+int soft_serial_transaction(void) {
+    uint8_t sstd_index = 0;
+#else
+int soft_serial_transaction(int index) {
+    uint8_t sstd_index = index;
+#endif
+
+    if (sstd_index >= Transaction_table_size) return TRANSACTION_TYPE_ERROR;
+    SSTD_t *         trans   = &Transaction_table[sstd_index];
+    usart_channel_t *channel = &channels[sstd_index];
+
+    osalSysLock();
+    if (channel->replied && trans->target2initiator_buffer_size) {
+        memcpy(trans->target2initiator_buffer, channel->reply, trans->target2initiator_buffer_size);
+    }
+    channel->replied = false;
+    int result       = channel->result;
+    if (result == TRANSACTION_END && trans->initiator2target_buffer_size && memcmp(channel->acked, trans->initiator2target_buffer, trans->initiator2target_buffer_size) != 0) {
+        result = TRANSACTION_PENDING;
+    }
+
+    if (trans->initiator2target_buffer_size) {
+        memcpy(channel->request, trans->initiator2target_buffer, trans->initiator2target_buffer_size);
+    }
+    channel->queued = true;
+    if (in_flight == NO_TRANSACTION) {
+        start_next_I();
+    }
+    osalSysUnlock();
+
+    if (trans->status) {
+        *trans->status = result;
+    }
+    return result;
+}
@@ -43,14 +43,53 @@ void eeprom_write_word(uint16_t *addr, uint16_t value) { eeprom_write_block(&val
 
 void eeprom_write_dword(uint32_t *addr, uint32_t value) { eeprom_write_block(&value, addr, 4); }
 
-void eeprom_update_block(const void *buf, void *addr, size_t len) {
-    uint8_t read_buf[len];
-    eeprom_read_block(read_buf, addr, len);
-    if (memcmp(buf, read_buf, len) != 0) {
-        eeprom_write_block(buf, addr, len);
+// Bytes read back per EEPROM access while looking for changes
+#ifndef EEPROM_UPDATE_COMPARE_SIZE
+#    define EEPROM_UPDATE_COMPARE_SIZE 32
+#endif
+
+void eeprom_update_block_paged(const void *buf, void *addr, size_t len, size_t page_size, eeprom_page_write_t page_write) {
+    uint8_t        read_buf[EEPROM_UPDATE_COMPARE_SIZE];
+    const uint8_t *src         = (const uint8_t *)buf;
+    uintptr_t      target_addr = (uintptr_t)addr;
+
+    while (len > 0) {
+        size_t chunk_length = page_size ? page_size - (target_addr % page_size) : len;
+        if (chunk_length > len) {
+            chunk_length = len;
+        }
+
+        // Rewrite the span from the first to the last changed byte with a single page write
+        size_t first = chunk_length;
+        size_t last  = 0;
+        for (size_t offset = 0; offset < chunk_length; offset += EEPROM_UPDATE_COMPARE_SIZE) {
+            size_t compare_length = chunk_length - offset;
+            if (compare_length > EEPROM_UPDATE_COMPARE_SIZE) {
+                compare_length = EEPROM_UPDATE_COMPARE_SIZE;
+            }
+            eeprom_read_block(read_buf, (const void *)(target_addr + offset), compare_length);
+            for (size_t i = 0; i < compare_length; i++) {
+                if (read_buf[i] != src[offset + i]) {
+                    if (first == chunk_length) {
+                        first = offset + i;
+                    }
+                    last = offset + i + 1;
+                }
+            }
+        }
+        if (first < last) {
+            page_write(&src[first], (void *)(target_addr + first), last - first);
+        }
+
+        src += chunk_length;
+        target_addr += chunk_length;
+        len -= chunk_length;
     }
 }
 
+// Drivers that know their page layout pass it to eeprom_update_block_paged() instead
+__attribute__((weak)) void eeprom_update_block(const void *buf, void *addr, size_t len) { eeprom_update_block_paged(buf, addr, len, 0, eeprom_write_block); }
+
 void eeprom_update_byte(uint8_t *addr, uint8_t value) {
     uint8_t orig = eeprom_read_byte(addr);
     if (orig != value) {
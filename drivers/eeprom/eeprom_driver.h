@@ -20,3 +20,10 @@
 
 void eeprom_driver_init(void);
 void eeprom_driver_erase(void);
+
+typedef void (*eeprom_page_write_t)(const void *buf, void *addr, size_t len);
+
+// Updates len bytes at addr, one page at a time. For each page, only the span between
+// the first and last changed byte is written, with a single call to page_write.
+// A page_size of 0 treats the whole range as one page.
+void eeprom_update_block_paged(const void *buf, void *addr, size_t len, size_t page_size, eeprom_page_write_t page_write);
@@ -33,6 +33,7 @@
 #include "wait.h"
 #include "i2c_master.h"
 #include "eeprom.h"
+#include "eeprom_driver.h"
 #include "eeprom_i2c.h"
 
 // #define DEBUG_EEPROM_OUTPUT
@@ -109,7 +110,7 @@ void eeprom_write_block(const void *buf, void *addr, size_t len) {
         dprintf("\n");
 #endif  // DEBUG_EEPROM_OUTPUT
 
-        i2c_transmit(EXTERNAL_EEPROM_I2C_ADDRESS((uintptr_t)addr), complete_packet, EXTERNAL_EEPROM_ADDRESS_SIZE + write_length, 100);
+        i2c_transmit(EXTERNAL_EEPROM_I2C_ADDRESS(target_addr), complete_packet, EXTERNAL_EEPROM_ADDRESS_SIZE + write_length, 100);
         wait_ms(EXTERNAL_EEPROM_WRITE_TIME);
 
         read_buf += write_length;
@@ -117,3 +118,5 @@ void eeprom_write_block(const void *buf, void *addr, size_t len) {
         len -= write_length;
     }
 }
+
+void eeprom_update_block(const void *buf, void *addr, size_t len) { eeprom_update_block_paged(buf, addr, len, EXTERNAL_EEPROM_PAGE_SIZE, eeprom_write_block); }
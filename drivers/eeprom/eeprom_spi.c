@@ -33,6 +33,7 @@
 #include "wait.h"
 #include "spi_master.h"
 #include "eeprom.h"
+#include "eeprom_driver.h"
 #include "eeprom_spi.h"
 
 #define CMD_WREN 6
@@ -218,3 +219,5 @@ void eeprom_write_block(const void *buf, void *addr, size_t len) {
     spi_write(CMD_WRDI);
     spi_stop();
 }
+
+void eeprom_update_block(const void *buf, void *addr, size_t len) { eeprom_update_block_paged(buf, addr, len, EXTERNAL_EEPROM_PAGE_SIZE, eeprom_write_block); }
@@ -0,0 +1,198 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <string.h>
+#include "eeprom_device_sim.h"
+#include "i2c_master.h"
+#include "spi_master.h"
+#include "timer.h"
+
+void advance_time(uint32_t ms);
+
+#define SPI_CMD_WREN 6
+#define SPI_CMD_WRDI 4
+#define SPI_CMD_RDSR 5
+#define SPI_CMD_READ 3
+#define SPI_CMD_WRITE 2
+
+uint8_t  eeprom_sim_memory[EXTERNAL_EEPROM_BYTE_COUNT];
+uint32_t eeprom_sim_write_cycles;
+uint32_t eeprom_sim_busy_violations;
+
+static uint32_t address_pointer;
+static uint32_t busy_until;
+
+void eeprom_sim_reset(void) {
+    memset(eeprom_sim_memory, 0xFF, sizeof(eeprom_sim_memory));
+    eeprom_sim_write_cycles    = 0;
+    eeprom_sim_busy_violations = 0;
+    address_pointer            = 0;
+    busy_until                 = timer_read32();
+}
+
+static bool device_busy(void) { return (int32_t)(busy_until - timer_read32()) > 0; }
+
+static void write_byte(uint32_t page_start, uint32_t *offset, uint8_t data) {
+    eeprom_sim_memory[(page_start + *offset) % EXTERNAL_EEPROM_BYTE_COUNT] = data;
+    *offset                                                               = (*offset + 1) % EXTERNAL_EEPROM_PAGE_SIZE;
+}
+
+static void start_write_cycle(void) {
+    eeprom_sim_write_cycles++;
+    busy_until = timer_read32() + EXTERNAL_EEPROM_WRITE_TIME;
+}
+
+/* I2C ---------------------------------------------------------------------- */
+
+void i2c_init(void) {}
+
+i2c_status_t i2c_transmit(uint8_t address, const uint8_t *data, uint16_t length, uint16_t timeout) {
+    if (device_busy()) {
+        // the device does not acknowledge while writing
+        eeprom_sim_busy_violations++;
+        return I2C_STATUS_ERROR;
+    }
+    if (length < EXTERNAL_EEPROM_ADDRESS_SIZE) {
+        return I2C_STATUS_ERROR;
+    }
+    address_pointer = 0;
+    for (int i = 0; i < EXTERNAL_EEPROM_ADDRESS_SIZE; i++) {
+        address_pointer = (address_pointer << 8) | data[i];
+    }
+    if (length > EXTERNAL_EEPROM_ADDRESS_SIZE) {
+        uint32_t page_start = address_pointer - address_pointer % EXTERNAL_EEPROM_PAGE_SIZE;
+        uint32_t offset     = address_pointer % EXTERNAL_EEPROM_PAGE_SIZE;
+        for (uint16_t i = EXTERNAL_EEPROM_ADDRESS_SIZE; i < length; i++) {
+            write_byte(page_start, &offset, data[i]);
+        }
+        start_write_cycle();
+    }
+    return I2C_STATUS_SUCCESS;
+}
+
+i2c_status_t i2c_receive(uint8_t address, uint8_t *data, uint16_t length, uint16_t timeout) {
+    if (device_busy()) {
+        eeprom_sim_busy_violations++;
+        return I2C_STATUS_ERROR;
+    }
+    for (uint16_t i = 0; i < length; i++) {
+        data[i]         = eeprom_sim_memory[address_pointer];
+        address_pointer = (address_pointer + 1) % EXTERNAL_EEPROM_BYTE_COUNT;
+    }
+    return I2C_STATUS_SUCCESS;
+}
+
+/* SPI ---------------------------------------------------------------------- */
+
+static bool     spi_selected;
+static bool     spi_write_enabled;
+static int16_t  spi_command;
+static uint8_t  spi_address_bytes;
+static uint32_t spi_page_start;
+static uint32_t spi_page_offset;
+static uint32_t spi_data_bytes;
+
+void spi_init(void) {}
+
+bool spi_start(pin_t slavePin, bool lsbFirst, uint8_t mode, uint16_t divisor) {
+    if (spi_selected) {
+        return false;
+    }
+    spi_selected      = true;
+    spi_command       = -1;
+    spi_address_bytes = 0;
+    spi_data_bytes    = 0;
+    address_pointer   = 0;
+    return true;
+}
+
+spi_status_t spi_write(uint8_t data) {
+    if (!spi_selected) {
+        return SPI_STATUS_ERROR;
+    }
+    if (spi_command < 0) {
+        spi_command = data;
+        if (spi_command != SPI_CMD_RDSR && device_busy()) {
+            // only the status register can be read during a write cycle, other commands are ignored
+            if (spi_command == SPI_CMD_READ || spi_command == SPI_CMD_WRITE) {
+                eeprom_sim_busy_violations++;
+            }
+        } else if (spi_command == SPI_CMD_WREN) {
+            spi_write_enabled = true;
+        } else if (spi_command == SPI_CMD_WRDI) {
+            spi_write_enabled = false;
+        }
+    } else if ((spi_command == SPI_CMD_READ || spi_command == SPI_CMD_WRITE) && spi_address_bytes < EXTERNAL_EEPROM_ADDRESS_SIZE) {
+        address_pointer = (address_pointer << 8) | data;
+        if (++spi_address_bytes == EXTERNAL_EEPROM_ADDRESS_SIZE) {
+            spi_page_start  = address_pointer - address_pointer % EXTERNAL_EEPROM_PAGE_SIZE;
+            spi_page_offset = address_pointer % EXTERNAL_EEPROM_PAGE_SIZE;
+        }
+    } else if (spi_command == SPI_CMD_WRITE && spi_write_enabled && !device_busy()) {
+        write_byte(spi_page_start, &spi_page_offset, data);
+        spi_data_bytes++;
+    }
+    return SPI_STATUS_SUCCESS;
+}
+
+spi_status_t spi_read(void) {
+    if (!spi_selected) {
+        return SPI_STATUS_ERROR;
+    }
+    if (spi_command == SPI_CMD_RDSR) {
+        bool busy = device_busy();
+        // polling the status register takes a while
+        advance_time(1);
+        return (busy ? 0x01 : 0x00) | (spi_write_enabled ? 0x02 : 0x00);
+    }
+    if (spi_command == SPI_CMD_READ && spi_address_bytes == EXTERNAL_EEPROM_ADDRESS_SIZE) {
+        uint8_t data    = eeprom_sim_memory[address_pointer];
+        address_pointer = (address_pointer + 1) % EXTERNAL_EEPROM_BYTE_COUNT;
+        return data;
+    }
+    return 0xFF;
+}
+
+spi_status_t spi_transmit(const uint8_t *data, uint16_t length) {
+    for (uint16_t i = 0; i < length; i++) {
+        spi_status_t status = spi_write(data[i]);
+        if (status < 0) {
+            return status;
+        }
+    }
+    return SPI_STATUS_SUCCESS;
+}
+
+spi_status_t spi_receive(uint8_t *data, uint16_t length) {
+    for (uint16_t i = 0; i < length; i++) {
+        spi_status_t status = spi_read();
+        if (status < 0) {
+            return status;
+        }
+        data[i] = (uint8_t)status;
+    }
+    return SPI_STATUS_SUCCESS;
+}
+
+void spi_stop(void) {
+    if (spi_command == SPI_CMD_WRITE && spi_data_bytes > 0) {
+        // the write cycle starts when chip select is released, and clears the write enable latch
+        start_write_cycle();
+        spi_write_enabled = false;
+    }
+    spi_selected = false;
+}
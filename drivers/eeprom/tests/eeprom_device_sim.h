@@ -0,0 +1,38 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Simulated 24xx (I2C) / 25xx (SPI) EEPROM. Page writes wrap around within
+// their page like the real parts do.
+extern uint8_t  eeprom_sim_memory[EXTERNAL_EEPROM_BYTE_COUNT];
+// Number of write cycles, i.e. page write transactions committed
+extern uint32_t eeprom_sim_write_cycles;
+// Transactions addressed to the device while it was still busy writing
+extern uint32_t eeprom_sim_busy_violations;
+
+void eeprom_sim_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,98 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "eeprom_driver.h"
+#include "eeprom_device_sim.h"
+#include "timer.h"
+}
+
+class EepromI2c : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        eeprom_driver_init();
+        eeprom_sim_reset();
+    }
+
+    void TearDown() override { EXPECT_EQ(eeprom_sim_busy_violations, 0u); }
+
+    void fill(uint8_t *buf, size_t len, uint8_t seed) {
+        for (size_t i = 0; i < len; i++) {
+            buf[i] = (uint8_t)(seed + i * 7);
+        }
+    }
+};
+
+TEST_F(EepromI2c, BlockWriteReadsBackAcrossPages) {
+    uint8_t data[EXTERNAL_EEPROM_PAGE_SIZE * 3];
+    uint8_t read[sizeof(data)];
+    fill(data, sizeof(data), 1);
+    eeprom_write_block(data, (void *)5, sizeof(data));
+    eeprom_read_block(read, (void *)5, sizeof(read));
+    EXPECT_EQ(memcmp(data, read, sizeof(data)), 0);
+    EXPECT_EQ(eeprom_sim_memory[4], 0xFF);
+    EXPECT_EQ(eeprom_sim_memory[5 + sizeof(data)], 0xFF);
+}
+
+TEST_F(EepromI2c, UpdateBlockWritesEachPageOnce) {
+    uint8_t data[EXTERNAL_EEPROM_PAGE_SIZE * 4];
+    fill(data, sizeof(data), 3);
+    // unaligned, so it touches five pages
+    eeprom_update_block(data, (void *)(EXTERNAL_EEPROM_PAGE_SIZE / 2), sizeof(data));
+    EXPECT_EQ(eeprom_sim_write_cycles, 5u);
+    EXPECT_EQ(memcmp(data, &eeprom_sim_memory[EXTERNAL_EEPROM_PAGE_SIZE / 2], sizeof(data)), 0);
+}
+
+TEST_F(EepromI2c, UpdateBlockSkipsUnchangedPages) {
+    uint8_t data[EXTERNAL_EEPROM_PAGE_SIZE * 4];
+    fill(data, sizeof(data), 9);
+    eeprom_update_block(data, (void *)0, sizeof(data));
+    uint32_t cycles = eeprom_sim_write_cycles;
+
+    eeprom_update_block(data, (void *)0, sizeof(data));
+    EXPECT_EQ(eeprom_sim_write_cycles, cycles);
+
+    // two changes in the same page are written together
+    data[EXTERNAL_EEPROM_PAGE_SIZE * 2 + 1] ^= 0xFF;
+    data[EXTERNAL_EEPROM_PAGE_SIZE * 2 + 9] ^= 0xFF;
+    eeprom_update_block(data, (void *)0, sizeof(data));
+    EXPECT_EQ(eeprom_sim_write_cycles, cycles + 1);
+    EXPECT_EQ(memcmp(data, eeprom_sim_memory, sizeof(data)), 0);
+}
+
+TEST_F(EepromI2c, UpdateByteOnlyWritesChanges) {
+    eeprom_update_byte((uint8_t *)10, 0x42);
+    eeprom_update_byte((uint8_t *)10, 0x42);
+    eeprom_update_dword((uint32_t *)20, 0x12345678);
+    eeprom_update_dword((uint32_t *)20, 0x12345678);
+    EXPECT_EQ(eeprom_sim_write_cycles, 2u);
+    EXPECT_EQ(eeprom_read_byte((uint8_t *)10), 0x42);
+    EXPECT_EQ(eeprom_read_dword((uint32_t *)20), 0x12345678u);
+}
+
+TEST_F(EepromI2c, KeymapUploadTakesOneWriteCyclePerPage) {
+    // 4 layers of a 6x16 matrix, as sent by VIA
+    uint8_t keymap[4 * 6 * 16 * 2];
+    fill(keymap, sizeof(keymap), 0);
+    uint32_t start = timer_read32();
+    eeprom_update_block(keymap, (void *)0, sizeof(keymap));
+    EXPECT_EQ(eeprom_sim_write_cycles, (sizeof(keymap) + EXTERNAL_EEPROM_PAGE_SIZE - 1) / EXTERNAL_EEPROM_PAGE_SIZE);
+    // a write cycle per page, plus the odd status poll
+    EXPECT_LE(timer_read32() - start, eeprom_sim_write_cycles * (EXTERNAL_EEPROM_WRITE_TIME + 2));
+    EXPECT_EQ(memcmp(keymap, eeprom_sim_memory, sizeof(keymap)), 0);
+}
@@ -0,0 +1,19 @@
+EEPROM_DRIVER_COMMON_DEFS := -DNO_DEBUG -DNO_PRINT -DEXTERNAL_EEPROM_BYTE_COUNT=8192 -DEXTERNAL_EEPROM_PAGE_SIZE=32 -DEXTERNAL_EEPROM_ADDRESS_SIZE=2 -DEXTERNAL_EEPROM_WRITE_TIME=5
+
+eeprom_i2c_DEFS := $(EEPROM_DRIVER_COMMON_DEFS)
+eeprom_i2c_INC := $(DRIVER_PATH)/eeprom/tests/mock $(DRIVER_PATH)/eeprom
+eeprom_i2c_SRC := \
+	$(DRIVER_PATH)/eeprom/tests/eeprom_i2c_tests.cpp \
+	$(DRIVER_PATH)/eeprom/tests/eeprom_device_sim.c \
+	$(DRIVER_PATH)/eeprom/eeprom_i2c.c \
+	$(DRIVER_PATH)/eeprom/eeprom_driver.c \
+	$(TMK_PATH)/common/test/timer.c
+
+eeprom_spi_DEFS := $(EEPROM_DRIVER_COMMON_DEFS) -DEXTERNAL_EEPROM_SPI_SLAVE_SELECT_PIN=0
+eeprom_spi_INC := $(eeprom_i2c_INC)
+eeprom_spi_SRC := \
+	$(DRIVER_PATH)/eeprom/tests/eeprom_spi_tests.cpp \
+	$(DRIVER_PATH)/eeprom/tests/eeprom_device_sim.c \
+	$(DRIVER_PATH)/eeprom/eeprom_spi.c \
+	$(DRIVER_PATH)/eeprom/eeprom_driver.c \
+	$(TMK_PATH)/common/test/timer.c
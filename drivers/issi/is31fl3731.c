@@ -61,8 +61,11 @@ uint8_t g_twi_transfer_buffer[20];
 // We could optimize this and take out the unused registers from these
 // buffers and the transfers in IS31FL3731_write_pwm_buffer() but it's
 // probably not worth the extra complexity.
-uint8_t g_pwm_buffer[DRIVER_COUNT][144];
-bool    g_pwm_buffer_update_required[DRIVER_COUNT] = {false};
+// Each bit of g_pwm_buffer_dirty marks a block of 16 registers that has
+// changed since it was last sent. Everything is sent on the first update.
+#define ISSI_PWM_BLOCKS_ALL 0x01FF
+uint8_t  g_pwm_buffer[DRIVER_COUNT][144];
+uint16_t g_pwm_buffer_dirty[DRIVER_COUNT] = {[0 ... DRIVER_COUNT - 1] = ISSI_PWM_BLOCKS_ALL};
 
 uint8_t g_led_control_registers[DRIVER_COUNT][18]             = {{0}};
 bool    g_led_control_registers_update_required[DRIVER_COUNT] = {false};
@@ -94,14 +97,17 @@ void IS31FL3731_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
 #endif
 }
 
-void IS31FL3731_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
+static void IS31FL3731_write_pwm_blocks(uint8_t addr, uint8_t *pwm_buffer, uint16_t blocks) {
     // assumes bank is already selected
 
-    // transmit PWM registers in 9 transfers of 16 bytes
+    // transmit each selected block of 16 PWM registers in one transfer
     // g_twi_transfer_buffer[] is 20 bytes
 
     // iterate over the pwm_buffer contents at 16 byte intervals
     for (int i = 0; i < 144; i += 16) {
+        if (!(blocks & (1 << (i / 16)))) {
+            continue;
+        }
         // set the first register, e.g. 0x24, 0x34, 0x44, etc.
         g_twi_transfer_buffer[0] = 0x24 + i;
         // copy the data from i to i+15
@@ -121,6 +127,8 @@ void IS31FL3731_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
     }
 }
 
+void IS31FL3731_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) { IS31FL3731_write_pwm_blocks(addr, pwm_buffer, ISSI_PWM_BLOCKS_ALL); }
+
 void IS31FL3731_init(uint8_t addr) {
     // In order to avoid the LEDs being driven with garbage data
     // in the LED driver's PWM registers, first enable software shutdown,
@@ -173,15 +181,22 @@ void IS31FL3731_init(uint8_t addr) {
     IS31FL3731_write_register(addr, ISSI_COMMANDREGISTER, 0);
 }
 
+static inline void IS31FL3731_set_pwm_register(uint8_t driver, uint8_t reg, uint8_t value) {
+    // Subtract 0x24 to get the second index of g_pwm_buffer
+    uint8_t offset = reg - 0x24;
+    if (g_pwm_buffer[driver][offset] != value) {
+        g_pwm_buffer[driver][offset] = value;
+        g_pwm_buffer_dirty[driver] |= 1 << (offset / 16);
+    }
+}
+
 void IS31FL3731_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
     if (index >= 0 && index < DRIVER_LED_TOTAL) {
         is31_led led = g_is31_leds[index];
 
-        // Subtract 0x24 to get the second index of g_pwm_buffer
-        g_pwm_buffer[led.driver][led.r - 0x24]   = red;
-        g_pwm_buffer[led.driver][led.g - 0x24]   = green;
-        g_pwm_buffer[led.driver][led.b - 0x24]   = blue;
-        g_pwm_buffer_update_required[led.driver] = true;
+        IS31FL3731_set_pwm_register(led.driver, led.r, red);
+        IS31FL3731_set_pwm_register(led.driver, led.g, green);
+        IS31FL3731_set_pwm_register(led.driver, led.b, blue);
     }
 }
 
@@ -221,10 +236,12 @@ void IS31FL3731_set_led_control_register(uint8_t index, bool red, bool green, bo
 }
 
 void IS31FL3731_update_pwm_buffers(uint8_t addr, uint8_t index) {
-    if (g_pwm_buffer_update_required[index]) {
-        IS31FL3731_write_pwm_buffer(addr, g_pwm_buffer[index]);
+    uint16_t blocks = g_pwm_buffer_dirty[index];
+    if (blocks) {
+        // clear first, so blocks changed while sending go out next time
+        g_pwm_buffer_dirty[index] = 0;
+        IS31FL3731_write_pwm_blocks(addr, g_pwm_buffer[index], blocks);
     }
-    g_pwm_buffer_update_required[index] = false;
 }
 
 void IS31FL3731_update_led_control_registers(uint8_t addr, uint8_t index) {
@@ -65,8 +65,11 @@ uint8_t g_twi_transfer_buffer[20];
 // We could optimize this and take out the unused registers from these
 // buffers and the transfers in IS31FL3737_write_pwm_buffer() but it's
 // probably not worth the extra complexity.
-uint8_t g_pwm_buffer[DRIVER_COUNT][192];
-bool    g_pwm_buffer_update_required = false;
+// Each bit of g_pwm_buffer_dirty marks a block of 16 registers that has
+// changed since it was last sent. Everything is sent on the first update.
+#define ISSI_PWM_BLOCKS_ALL 0x0FFF
+uint8_t  g_pwm_buffer[DRIVER_COUNT][192];
+uint16_t g_pwm_buffer_dirty[DRIVER_COUNT] = {[0 ... DRIVER_COUNT - 1] = ISSI_PWM_BLOCKS_ALL};
 
 uint8_t g_led_control_registers[DRIVER_COUNT][24] = {{0}};
 bool    g_led_control_registers_update_required   = false;
@@ -84,14 +87,17 @@ void IS31FL3737_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
 #endif
 }
 
-void IS31FL3737_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
+static void IS31FL3737_write_pwm_blocks(uint8_t addr, uint8_t *pwm_buffer, uint16_t blocks) {
     // assumes PG1 is already selected
 
-    // transmit PWM registers in 12 transfers of 16 bytes
+    // transmit each selected block of 16 PWM registers in one transfer
     // g_twi_transfer_buffer[] is 20 bytes
 
     // iterate over the pwm_buffer contents at 16 byte intervals
     for (int i = 0; i < 192; i += 16) {
+        if (!(blocks & (1 << (i / 16)))) {
+            continue;
+        }
         g_twi_transfer_buffer[0] = i;
         // copy the data from i to i+15
         // device will auto-increment register for data after the first byte
@@ -110,6 +116,8 @@ void IS31FL3737_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
     }
 }
 
+void IS31FL3737_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) { IS31FL3737_write_pwm_blocks(addr, pwm_buffer, ISSI_PWM_BLOCKS_ALL); }
+
 void IS31FL3737_init(uint8_t addr) {
     // In order to avoid the LEDs being driven with garbage data
     // in the LED driver's PWM registers, shutdown is enabled last.
@@ -151,14 +159,20 @@ void IS31FL3737_init(uint8_t addr) {
     wait_ms(10);
 }
 
+static inline void IS31FL3737_set_pwm_register(uint8_t driver, uint8_t reg, uint8_t value) {
+    if (g_pwm_buffer[driver][reg] != value) {
+        g_pwm_buffer[driver][reg] = value;
+        g_pwm_buffer_dirty[driver] |= 1 << (reg / 16);
+    }
+}
+
 void IS31FL3737_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
     if (index >= 0 && index < DRIVER_LED_TOTAL) {
         is31_led led = g_is31_leds[index];
 
-        g_pwm_buffer[led.driver][led.r] = red;
-        g_pwm_buffer[led.driver][led.g] = green;
-        g_pwm_buffer[led.driver][led.b] = blue;
-        g_pwm_buffer_update_required    = true;
+        IS31FL3737_set_pwm_register(led.driver, led.r, red);
+        IS31FL3737_set_pwm_register(led.driver, led.g, green);
+        IS31FL3737_set_pwm_register(led.driver, led.b, blue);
     }
 }
 
@@ -198,15 +212,18 @@ void IS31FL3737_set_led_control_register(uint8_t index, bool red, bool green, bo
 }
 
 void IS31FL3737_update_pwm_buffers(uint8_t addr1, uint8_t addr2) {
-    if (g_pwm_buffer_update_required) {
+    uint16_t blocks = g_pwm_buffer_dirty[0];
+    if (blocks) {
+        // clear first, so blocks changed while sending go out next time
+        g_pwm_buffer_dirty[0] = 0;
+
         // Firstly we need to unlock the command register and select PG1
         IS31FL3737_write_register(addr1, ISSI_COMMANDREGISTER_WRITELOCK, 0xC5);
         IS31FL3737_write_register(addr1, ISSI_COMMANDREGISTER, ISSI_PAGE_PWM);
 
-        IS31FL3737_write_pwm_buffer(addr1, g_pwm_buffer[0]);
-        // IS31FL3737_write_pwm_buffer(addr2, g_pwm_buffer[1]);
+        IS31FL3737_write_pwm_blocks(addr1, g_pwm_buffer[0], blocks);
+        // IS31FL3737_write_pwm_blocks(addr2, g_pwm_buffer[1], g_pwm_buffer_dirty[1]);
     }
-    g_pwm_buffer_update_required = false;
 }
 
 void IS31FL3737_update_led_control_registers(uint8_t addr1, uint8_t addr2) {
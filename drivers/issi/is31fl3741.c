@@ -63,6 +63,13 @@
 
 #define ISSI_MAX_LEDS 351
 
+// PWM registers are sent in blocks of 18, the last block holds the left 9.
+// Blocks from 180 onwards live on PG1.
+#define ISSI_PWM_BLOCK_SIZE 18
+#define ISSI_PWM_BLOCK_COUNT ((ISSI_MAX_LEDS + ISSI_PWM_BLOCK_SIZE - 1) / ISSI_PWM_BLOCK_SIZE)
+#define ISSI_PWM_BLOCKS_ALL ((1UL << ISSI_PWM_BLOCK_COUNT) - 1)
+#define ISSI_PWM_PAGE_SIZE 180
+
 // Transfer buffer for TWITransmitData()
 uint8_t g_twi_transfer_buffer[20] = {0xFF};
 
@@ -72,9 +79,11 @@ uint8_t g_twi_transfer_buffer[20] = {0xFF};
 // We could optimize this and take out the unused registers from these
 // buffers and the transfers in IS31FL3741_write_pwm_buffer() but it's
 // probably not worth the extra complexity.
-uint8_t g_pwm_buffer[DRIVER_COUNT][ISSI_MAX_LEDS];
-bool    g_pwm_buffer_update_required                      = false;
-bool    g_scaling_registers_update_required[DRIVER_COUNT] = {false};
+// Each bit of g_pwm_buffer_dirty marks a block that has changed since it
+// was last sent. Everything is sent on the first update.
+uint8_t  g_pwm_buffer[DRIVER_COUNT][ISSI_MAX_LEDS];
+uint32_t g_pwm_buffer_dirty[DRIVER_COUNT]                  = {[0 ... DRIVER_COUNT - 1] = ISSI_PWM_BLOCKS_ALL};
+bool     g_scaling_registers_update_required[DRIVER_COUNT] = {false};
 
 uint8_t g_scaling_registers[DRIVER_COUNT][ISSI_MAX_LEDS];
 
@@ -91,53 +100,45 @@ void IS31FL3741_write_register(uint8_t addr, uint8_t reg, uint8_t data) {
 #endif
 }
 
-bool IS31FL3741_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) {
-    // unlock the command register and select PG2
-    IS31FL3741_write_register(addr, ISSI_COMMANDREGISTER_WRITELOCK, 0xC5);
-    IS31FL3741_write_register(addr, ISSI_COMMANDREGISTER, ISSI_PAGE_PWM0);
+static bool IS31FL3741_write_pwm_blocks(uint8_t addr, uint8_t *pwm_buffer, uint32_t blocks) {
+    int8_t page = -1;
+
+    for (uint8_t b = 0; b < ISSI_PWM_BLOCK_COUNT; b++) {
+        if (!(blocks & (1UL << b))) {
+            continue;
+        }
+
+        uint16_t i   = b * ISSI_PWM_BLOCK_SIZE;
+        uint8_t  len = (ISSI_MAX_LEDS - i < ISSI_PWM_BLOCK_SIZE) ? ISSI_MAX_LEDS - i : ISSI_PWM_BLOCK_SIZE;
 
-    for (int i = 0; i < 342; i += 18) {
-        if (i == 180) {
-            // unlock the command register and select PG2
+        // only select a page once a block on it needs sending
+        if (page != i / ISSI_PWM_PAGE_SIZE) {
+            page = i / ISSI_PWM_PAGE_SIZE;
             IS31FL3741_write_register(addr, ISSI_COMMANDREGISTER_WRITELOCK, 0xC5);
-            IS31FL3741_write_register(addr, ISSI_COMMANDREGISTER, ISSI_PAGE_PWM1);
+            IS31FL3741_write_register(addr, ISSI_COMMANDREGISTER, page ? ISSI_PAGE_PWM1 : ISSI_PAGE_PWM0);
         }
 
-        g_twi_transfer_buffer[0] = i % 180;
-        memcpy(g_twi_transfer_buffer + 1, pwm_buffer + i, 18);
+        g_twi_transfer_buffer[0] = i % ISSI_PWM_PAGE_SIZE;
+        memcpy(g_twi_transfer_buffer + 1, pwm_buffer + i, len);
 
 #if ISSI_PERSISTENCE > 0
         for (uint8_t i = 0; i < ISSI_PERSISTENCE; i++) {
-            if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 19, ISSI_TIMEOUT) != 0) {
+            if (i2c_transmit(addr << 1, g_twi_transfer_buffer, len + 1, ISSI_TIMEOUT) != 0) {
                 return false;
             }
         }
 #else
-        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 19, ISSI_TIMEOUT) != 0) {
+        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, len + 1, ISSI_TIMEOUT) != 0) {
             return false;
         }
 #endif
     }
 
-    // transfer the left cause the total number is 351
-    g_twi_transfer_buffer[0] = 162;
-    memcpy(g_twi_transfer_buffer + 1, pwm_buffer + 342, 9);
-
-#if ISSI_PERSISTENCE > 0
-    for (uint8_t i = 0; i < ISSI_PERSISTENCE; i++) {
-        if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 10, ISSI_TIMEOUT) != 0) {
-            return false;
-        }
-    }
-#else
-    if (i2c_transmit(addr << 1, g_twi_transfer_buffer, 10, ISSI_TIMEOUT) != 0) {
-        return false;
-    }
-#endif
-
     return true;
 }
 
+bool IS31FL3741_write_pwm_buffer(uint8_t addr, uint8_t *pwm_buffer) { return IS31FL3741_write_pwm_blocks(addr, pwm_buffer, ISSI_PWM_BLOCKS_ALL); }
+
 void IS31FL3741_init(uint8_t addr) {
     // In order to avoid the LEDs being driven with garbage data
     // in the LED driver's PWM registers, shutdown is enabled last.
@@ -165,14 +166,20 @@ void IS31FL3741_init(uint8_t addr) {
     wait_ms(10);
 }
 
+static inline void IS31FL3741_set_pwm_register(uint8_t driver, uint16_t reg, uint8_t value) {
+    if (g_pwm_buffer[driver][reg] != value) {
+        g_pwm_buffer[driver][reg] = value;
+        g_pwm_buffer_dirty[driver] |= 1UL << (reg / ISSI_PWM_BLOCK_SIZE);
+    }
+}
+
 void IS31FL3741_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
     if (index >= 0 && index < DRIVER_LED_TOTAL) {
         is31_led led = g_is31_leds[index];
 
-        g_pwm_buffer[led.driver][led.r] = red;
-        g_pwm_buffer[led.driver][led.g] = green;
-        g_pwm_buffer[led.driver][led.b] = blue;
-        g_pwm_buffer_update_required    = true;
+        IS31FL3741_set_pwm_register(led.driver, led.r, red);
+        IS31FL3741_set_pwm_register(led.driver, led.g, green);
+        IS31FL3741_set_pwm_register(led.driver, led.b, blue);
     }
 }
 
@@ -207,19 +214,18 @@ void IS31FL3741_set_led_control_register(uint8_t index, bool red, bool green, bo
 }
 
 void IS31FL3741_update_pwm_buffers(uint8_t addr1, uint8_t addr2) {
-    if (g_pwm_buffer_update_required) {
-        IS31FL3741_write_pwm_buffer(addr1, g_pwm_buffer[0]);
+    uint32_t blocks = g_pwm_buffer_dirty[0];
+    if (blocks) {
+        // clear first, so blocks changed while sending go out next time
+        g_pwm_buffer_dirty[0] = 0;
+        IS31FL3741_write_pwm_blocks(addr1, g_pwm_buffer[0], blocks);
     }
-
-    g_pwm_buffer_update_required = false;
 }
 
 void IS31FL3741_set_pwm_buffer(const is31_led *pled, uint8_t red, uint8_t green, uint8_t blue) {
-    g_pwm_buffer[pled->driver][pled->r] = red;
-    g_pwm_buffer[pled->driver][pled->g] = green;
-    g_pwm_buffer[pled->driver][pled->b] = blue;
-
-    g_pwm_buffer_update_required = true;
+    IS31FL3741_set_pwm_register(pled->driver, pled->r, red);
+    IS31FL3741_set_pwm_register(pled->driver, pled->g, green);
+    IS31FL3741_set_pwm_register(pled->driver, pled->b, blue);
 }
 
 void IS31FL3741_update_led_control_registers(uint8_t addr, uint8_t index) {
@@ -1 +1,3 @@
-VIA_ENABLE = yes
\ No newline at end of file
+VIA_ENABLE = yes
+# Room for the dynamic keymap in the emulated EEPROM
+FEE_DENSITY_PAGES = 6
@@ -0,0 +1,121 @@
+/*
+Copyright 2021 QMK
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/*
+Asymmetric per-key algorithm. Uses an 8-bit counter per key.
+Key-down is eager: a press is reported on the first edge.
+Key-up is deferred: a release is only reported once the key has read as
+released for DEBOUNCE milliseconds. Bouncing back to pressed cancels the timer.
+Define DEBOUNCE_16BIT_TIMESTAMPS (implied when DEBOUNCE > 250) to use 16-bit counters.
+*/
+
+#include "matrix.h"
+#include "timer.h"
+#include "quantum.h"
+#include <stdlib.h>
+
+#ifdef PROTOCOL_CHIBIOS
+#    if CH_CFG_USE_MEMCORE == FALSE
+#        error ChibiOS is configured without a memory allocator. Your keyboard may have set `#define CH_CFG_USE_MEMCORE FALSE`, which is incompatible with this debounce algorithm.
+#    endif
+#endif
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+#define ROW_SHIFTER ((matrix_row_t)1)
+
+#if DEBOUNCE > 250 && !defined(DEBOUNCE_16BIT_TIMESTAMPS)
+#    define DEBOUNCE_16BIT_TIMESTAMPS
+#endif
+
+#ifdef DEBOUNCE_16BIT_TIMESTAMPS
+#    define debounce_counter_t uint16_t
+#    define debounce_timer_read() timer_read()
+#    define DEBOUNCE_TIMER_DIFF(a, b) TIMER_DIFF_16(a, b)
+#else
+#    define debounce_counter_t uint8_t
+#    define debounce_timer_read() wrapping_timer_read()
+#    define MAX_DEBOUNCE 250
+#    define DEBOUNCE_TIMER_DIFF(a, b) TIMER_DIFF(a, b, MAX_DEBOUNCE)
+
+static uint8_t wrapping_timer_read(void) {
+    static uint16_t time        = 0;
+    static uint8_t  last_result = 0;
+    uint16_t        new_time    = timer_read();
+    uint16_t        diff        = new_time - time;
+    time                        = new_time;
+    last_result                 = (last_result + diff) % (MAX_DEBOUNCE + 1);
+    return last_result;
+}
+#endif
+
+static debounce_counter_t *debounce_counters;
+static matrix_row_t *      releases_pending;
+static bool                counters_need_update;
+
+void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, debounce_counter_t current_time);
+
+// we use num_rows rather than MATRIX_ROWS to support split keyboards
+void debounce_init(uint8_t num_rows) {
+    debounce_counters = (debounce_counter_t *)malloc(num_rows * MATRIX_COLS * sizeof(debounce_counter_t));
+    releases_pending  = (matrix_row_t *)calloc(num_rows, sizeof(matrix_row_t));
+}
+
+void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    if (changed || counters_need_update) {
+        transfer_matrix_values(raw, cooked, num_rows, debounce_timer_read());
+    }
+}
+
+// upload from raw_matrix to final matrix;
+void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, debounce_counter_t current_time) {
+    counters_need_update = false;
+    for (uint8_t row = 0; row < num_rows; row++) {
+        matrix_row_t delta = raw[row] ^ cooked[row];
+
+        // presses are reported straight away
+        cooked[row] |= delta & raw[row];
+
+        // keys that read as pressed again are no longer being released
+        matrix_row_t released = delta & ~raw[row];
+        matrix_row_t started  = released & ~releases_pending[row];
+        releases_pending[row] &= released;
+        if (!released) {
+            continue;
+        }
+
+        debounce_counter_t *debounce_pointer = &debounce_counters[row * MATRIX_COLS];
+        for (uint8_t col = 0; released; col++) {
+            matrix_row_t col_mask = (ROW_SHIFTER << col);
+            if (!(released & col_mask)) {
+                continue;
+            }
+            released &= ~col_mask;
+            if (started & col_mask) {
+                debounce_pointer[col] = current_time;
+                releases_pending[row] |= col_mask;
+                counters_need_update = true;
+            } else if (DEBOUNCE_TIMER_DIFF(current_time, debounce_pointer[col]) >= DEBOUNCE) {
+                cooked[row] &= ~col_mask;
+                releases_pending[row] &= ~col_mask;
+            } else {
+                counters_need_update = true;
+            }
+        }
+    }
+}
+
+bool debounce_active(void) { return true; }
@@ -16,6 +16,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 Basic per-key algorithm. Uses an 8-bit counter per key.
 After pressing a key, it immediately changes state, and sets a counter.
 No further inputs are accepted until DEBOUNCE milliseconds have occurred.
+Rows keep a bitmask of keys with a running counter, so only bouncing keys are visited.
+Define DEBOUNCE_16BIT_TIMESTAMPS (implied when DEBOUNCE > 250) to use 16-bit counters.
 */
 
 #include "matrix.h"
@@ -35,14 +37,19 @@ No further inputs are accepted until DEBOUNCE milliseconds have occurred.
 
 #define ROW_SHIFTER ((matrix_row_t)1)
 
-#define debounce_counter_t uint8_t
-
-static debounce_counter_t *debounce_counters;
-static bool                counters_need_update;
-static bool                matrix_need_update;
+#if DEBOUNCE > 250 && !defined(DEBOUNCE_16BIT_TIMESTAMPS)
+#    define DEBOUNCE_16BIT_TIMESTAMPS
+#endif
 
-#define DEBOUNCE_ELAPSED 251
-#define MAX_DEBOUNCE (DEBOUNCE_ELAPSED - 1)
+#ifdef DEBOUNCE_16BIT_TIMESTAMPS
+#    define debounce_counter_t uint16_t
+#    define debounce_timer_read() timer_read()
+#    define DEBOUNCE_TIMER_DIFF(a, b) TIMER_DIFF_16(a, b)
+#else
+#    define debounce_counter_t uint8_t
+#    define debounce_timer_read() wrapping_timer_read()
+#    define MAX_DEBOUNCE 250
+#    define DEBOUNCE_TIMER_DIFF(a, b) TIMER_DIFF(a, b, MAX_DEBOUNCE)
 
 static uint8_t wrapping_timer_read(void) {
     static uint16_t time        = 0;
@@ -53,23 +60,24 @@ static uint8_t wrapping_timer_read(void) {
     last_result                 = (last_result + diff) % (MAX_DEBOUNCE + 1);
     return last_result;
 }
+#endif
 
-void update_debounce_counters(uint8_t num_rows, uint8_t current_time);
-void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, uint8_t current_time);
+static debounce_counter_t *debounce_counters;
+static matrix_row_t *      counters_active;
+static bool                counters_need_update;
+static bool                matrix_need_update;
+
+void update_debounce_counters(uint8_t num_rows, debounce_counter_t current_time);
+void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, debounce_counter_t current_time);
 
 // we use num_rows rather than MATRIX_ROWS to support split keyboards
 void debounce_init(uint8_t num_rows) {
     debounce_counters = (debounce_counter_t *)malloc(num_rows * MATRIX_COLS * sizeof(debounce_counter_t));
-    int i             = 0;
-    for (uint8_t r = 0; r < num_rows; r++) {
-        for (uint8_t c = 0; c < MATRIX_COLS; c++) {
-            debounce_counters[i++] = DEBOUNCE_ELAPSED;
-        }
-    }
+    counters_active   = (matrix_row_t *)calloc(num_rows, sizeof(matrix_row_t));
 }
 
 void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
-    uint8_t current_time = wrapping_timer_read();
+    debounce_counter_t current_time = debounce_timer_read();
     if (counters_need_update) {
         update_debounce_counters(num_rows, current_time);
     }
@@ -80,44 +88,56 @@ void debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool
 }
 
 // If the current time is > debounce counter, set the counter to enable input.
-void update_debounce_counters(uint8_t num_rows, uint8_t current_time) {
-    counters_need_update                 = false;
-    debounce_counter_t *debounce_pointer = debounce_counters;
+void update_debounce_counters(uint8_t num_rows, debounce_counter_t current_time) {
+    counters_need_update = false;
     for (uint8_t row = 0; row < num_rows; row++) {
-        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
-            if (*debounce_pointer != DEBOUNCE_ELAPSED) {
-                if (TIMER_DIFF(current_time, *debounce_pointer, MAX_DEBOUNCE) >= DEBOUNCE) {
-                    *debounce_pointer = DEBOUNCE_ELAPSED;
+        matrix_row_t pending = counters_active[row];
+        if (!pending) {
+            continue;
+        }
+        debounce_counter_t *debounce_pointer = &debounce_counters[row * MATRIX_COLS];
+        for (uint8_t col = 0; pending; col++) {
+            matrix_row_t col_mask = (ROW_SHIFTER << col);
+            if (pending & col_mask) {
+                pending &= ~col_mask;
+                if (DEBOUNCE_TIMER_DIFF(current_time, debounce_pointer[col]) >= DEBOUNCE) {
+                    counters_active[row] &= ~col_mask;
                 } else {
                     counters_need_update = true;
                 }
             }
-            debounce_pointer++;
         }
     }
 }
 
 // upload from raw_matrix to final matrix;
-void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, uint8_t current_time) {
-    matrix_need_update                   = false;
-    debounce_counter_t *debounce_pointer = debounce_counters;
+void transfer_matrix_values(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, debounce_counter_t current_time) {
+    matrix_need_update = false;
     for (uint8_t row = 0; row < num_rows; row++) {
-        matrix_row_t delta        = raw[row] ^ cooked[row];
-        matrix_row_t existing_row = cooked[row];
-        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+        matrix_row_t delta = raw[row] ^ cooked[row];
+        if (!delta) {
+            continue;
+        }
+        // keys still within their debounce time have to wait for a later call
+        if (delta & counters_active[row]) {
+            matrix_need_update = true;
+        }
+        matrix_row_t accepted = delta & ~counters_active[row];
+        if (!accepted) {
+            continue;
+        }
+        cooked[row] ^= accepted;  // flip the bits.
+        counters_active[row] |= accepted;
+        counters_need_update = true;
+
+        debounce_counter_t *debounce_pointer = &debounce_counters[row * MATRIX_COLS];
+        for (uint8_t col = 0; accepted; col++) {
             matrix_row_t col_mask = (ROW_SHIFTER << col);
-            if (delta & col_mask) {
-                if (*debounce_pointer == DEBOUNCE_ELAPSED) {
-                    *debounce_pointer    = current_time;
-                    counters_need_update = true;
-                    existing_row ^= col_mask;  // flip the bit.
-                } else {
-                    matrix_need_update = true;
-                }
+            if (accepted & col_mask) {
+                accepted &= ~col_mask;
+                debounce_pointer[col] = current_time;
             }
-            debounce_pointer++;
         }
-        cooked[row] = existing_row;
     }
 }
 
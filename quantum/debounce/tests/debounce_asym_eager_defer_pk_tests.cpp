@@ -0,0 +1,111 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "matrix.h"
+#include "debounce.h"
+
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+class DebounceAsymEagerDeferPk : public ::testing::Test {
+   protected:
+    static void SetUpTestCase() { debounce_init(MATRIX_ROWS); }
+
+    void SetUp() override {
+        memset(raw, 0, sizeof(raw));
+        // release whatever the previous test left pressed
+        run(true);
+        run_for(DEBOUNCE + 1);
+        memset(cooked, 0, sizeof(cooked));
+    }
+
+    void run(bool changed) { debounce(raw, cooked, MATRIX_ROWS, changed); }
+
+    // scan once per millisecond for the given time
+    void run_for(uint32_t ms) {
+        for (uint32_t i = 0; i < ms; i++) {
+            advance_time(1);
+            run(false);
+        }
+    }
+
+    matrix_row_t raw[MATRIX_ROWS];
+    matrix_row_t cooked[MATRIX_ROWS];
+};
+
+TEST_F(DebounceAsymEagerDeferPk, PressIsReportedImmediately) {
+    raw[1] = 0b100;
+    run(true);
+    EXPECT_EQ(cooked[1], 0b100);
+}
+
+TEST_F(DebounceAsymEagerDeferPk, ReleaseIsReportedAfterDebounce) {
+    raw[0] = 0b1;
+    run(true);
+    run_for(20);
+
+    raw[0] = 0;
+    run(true);
+    EXPECT_EQ(cooked[0], 0b1);
+
+    run_for(DEBOUNCE - 1);
+    EXPECT_EQ(cooked[0], 0b1);
+
+    run_for(1);
+    EXPECT_EQ(cooked[0], 0);
+}
+
+TEST_F(DebounceAsymEagerDeferPk, ReleaseChatterIsIgnored) {
+    raw[2] = 0b10;
+    run(true);
+    run_for(20);
+
+    // a worn switch chattering while it is held down
+    for (int i = 0; i < 10; i++) {
+        raw[2] = 0;
+        run(true);
+        run_for(DEBOUNCE - 2);
+        EXPECT_EQ(cooked[2], 0b10);
+
+        raw[2] = 0b10;
+        run(true);
+        run_for(1);
+        EXPECT_EQ(cooked[2], 0b10);
+    }
+
+    raw[2] = 0;
+    run(true);
+    run_for(DEBOUNCE);
+    EXPECT_EQ(cooked[2], 0);
+}
+
+TEST_F(DebounceAsymEagerDeferPk, PressIsNotDelayedByPendingRelease) {
+    raw[3] = 0b1;
+    run(true);
+    run_for(20);
+
+    raw[3] = 0b10;
+    run(true);
+    // the new key is reported while the release of the old one is deferred
+    EXPECT_EQ(cooked[3], 0b11);
+
+    run_for(DEBOUNCE);
+    EXPECT_EQ(cooked[3], 0b10);
+}
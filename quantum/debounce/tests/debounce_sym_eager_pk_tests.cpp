@@ -0,0 +1,108 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "matrix.h"
+#include "debounce.h"
+
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+class DebounceSymEagerPk : public ::testing::Test {
+   protected:
+    static void SetUpTestCase() { debounce_init(MATRIX_ROWS); }
+
+    void SetUp() override {
+        memset(raw, 0, sizeof(raw));
+        memset(cooked, 0, sizeof(cooked));
+        // let every counter left over from the previous test expire
+        advance_time(DEBOUNCE + 1);
+        run(true);
+    }
+
+    void run(bool changed) { debounce(raw, cooked, MATRIX_ROWS, changed); }
+
+    // scan once per millisecond for the given time
+    void run_for(uint32_t ms) {
+        for (uint32_t i = 0; i < ms; i++) {
+            advance_time(1);
+            run(false);
+        }
+    }
+
+    matrix_row_t raw[MATRIX_ROWS];
+    matrix_row_t cooked[MATRIX_ROWS];
+};
+
+TEST_F(DebounceSymEagerPk, PressIsReportedImmediately) {
+    raw[1] = 0b100;
+    run(true);
+    EXPECT_EQ(cooked[1], 0b100);
+}
+
+TEST_F(DebounceSymEagerPk, BounceIsIgnoredUntilDebounceElapsed) {
+    raw[0] = 0b1;
+    run(true);
+    EXPECT_EQ(cooked[0], 0b1);
+
+    advance_time(1);
+    raw[0] = 0;
+    run(true);
+    EXPECT_EQ(cooked[0], 0b1);
+
+    run_for(DEBOUNCE - 2);
+    EXPECT_EQ(cooked[0], 0b1);
+
+    run_for(1);
+    EXPECT_EQ(cooked[0], 0);
+}
+
+TEST_F(DebounceSymEagerPk, OtherKeysInRowAreNotBlocked) {
+    raw[2] = 0b1;
+    run(true);
+
+    advance_time(1);
+    raw[2] = 0b10;
+    run(true);
+    // the second key goes through while the first one is still locked
+    EXPECT_EQ(cooked[2], 0b11);
+
+    run_for(DEBOUNCE);
+    EXPECT_EQ(cooked[2], 0b10);
+}
+
+TEST_F(DebounceSymEagerPk, KeysInDifferentRowsDebounceIndependently) {
+    raw[0] = 0b1000;
+    run(true);
+    run_for(DEBOUNCE / 2);
+
+    raw[3] = 0b1;
+    run(true);
+    EXPECT_EQ(cooked[3], 0b1);
+
+    raw[0] = 0;
+    raw[3] = 0;
+    run(true);
+    run_for(DEBOUNCE - DEBOUNCE / 2);
+    EXPECT_EQ(cooked[0], 0);
+    EXPECT_EQ(cooked[3], 0b1);
+
+    run_for(DEBOUNCE / 2);
+    EXPECT_EQ(cooked[3], 0);
+}
@@ -0,0 +1,16 @@
+DEBOUNCE_COMMON_DEFS := -DMATRIX_ROWS=4 -DMATRIX_COLS=10 -DNO_DEBUG
+
+debounce_sym_eager_pk_DEFS := $(DEBOUNCE_COMMON_DEFS) -DDEBOUNCE=5
+debounce_sym_eager_pk_SRC := \
+	$(QUANTUM_PATH)/debounce/tests/debounce_sym_eager_pk_tests.cpp \
+	$(QUANTUM_PATH)/debounce/sym_eager_pk.c \
+	$(TMK_PATH)/common/test/timer.c
+
+debounce_sym_eager_pk_16bit_DEFS := $(DEBOUNCE_COMMON_DEFS) -DDEBOUNCE=300
+debounce_sym_eager_pk_16bit_SRC := $(debounce_sym_eager_pk_SRC)
+
+debounce_asym_eager_defer_pk_DEFS := $(DEBOUNCE_COMMON_DEFS) -DDEBOUNCE=5
+debounce_asym_eager_defer_pk_SRC := \
+	$(QUANTUM_PATH)/debounce/tests/debounce_asym_eager_defer_pk_tests.cpp \
+	$(QUANTUM_PATH)/debounce/asym_eager_defer_pk.c \
+	$(TMK_PATH)/common/test/timer.c
@@ -0,0 +1,4 @@
+TEST_LIST += \
+	debounce_asym_eager_defer_pk \
+	debounce_sym_eager_pk \
+	debounce_sym_eager_pk_16bit
@@ -21,10 +21,7 @@
 #include "quantum.h"  // for send_string()
 #include "dynamic_keymap.h"
 #include "via.h"  // for default VIA_EEPROM_ADDR_END
-
-#ifndef DYNAMIC_KEYMAP_LAYER_COUNT
-#    define DYNAMIC_KEYMAP_LAYER_COUNT 4
-#endif
+#include <string.h>
 
 #ifndef DYNAMIC_KEYMAP_MACRO_COUNT
 #    define DYNAMIC_KEYMAP_MACRO_COUNT 16
@@ -49,6 +46,14 @@
 #    error DYNAMIC_KEYMAP_EEPROM_MAX_ADDR must be less than 65536
 #endif
 
+// The STM32 EEPROM emulation only stores FEE_DENSITY_BYTES, writes above it are dropped
+#ifdef STM32_EEPROM_ENABLE
+#    include "eeprom_stm32.h"
+#    if DYNAMIC_KEYMAP_EEPROM_MAX_ADDR >= FEE_DENSITY_BYTES
+#        error DYNAMIC_KEYMAP_EEPROM_MAX_ADDR is beyond the emulated EEPROM, increase FEE_DENSITY_PAGES in rules.mk and FEE_DENSITY_BYTES
+#    endif
+#endif
+
 // If DYNAMIC_KEYMAP_EEPROM_ADDR not explicitly defined in config.h,
 // default it start after VIA_EEPROM_CUSTOM_ADDR+VIA_EEPROM_CUSTOM_SIZE
 #ifndef DYNAMIC_KEYMAP_EEPROM_ADDR
@@ -79,6 +84,114 @@
 #    define DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE (DYNAMIC_KEYMAP_EEPROM_MAX_ADDR - DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + 1)
 #endif
 
+#ifdef DYNAMIC_KEYMAP_RAM_CACHE
+#    define DYNAMIC_KEYMAP_EEPROM_SIZE (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2)
+
+// How long the keymap has to stay unchanged before edits are written back to EEPROM
+#    ifndef DYNAMIC_KEYMAP_WRITE_BACK_DELAY
+#        define DYNAMIC_KEYMAP_WRITE_BACK_DELAY 500
+#    endif
+
+// How long a hold can go without being renewed before its edits are dropped
+#    ifndef DYNAMIC_KEYMAP_HOLD_TIMEOUT
+#        define DYNAMIC_KEYMAP_HOLD_TIMEOUT 2000
+#    endif
+
+// Mirror of the keymap area in EEPROM, same big-endian layout
+static uint8_t  dynamic_keymap_cache[DYNAMIC_KEYMAP_EEPROM_SIZE];
+static uint8_t  dynamic_keymap_dirty[(DYNAMIC_KEYMAP_EEPROM_SIZE / 2 + 7) / 8];
+static bool     dynamic_keymap_cache_loaded = false;
+static bool     dynamic_keymap_cache_dirty  = false;
+static uint16_t dynamic_keymap_last_write   = 0;
+static bool     dynamic_keymap_held         = false;
+static uint16_t dynamic_keymap_hold_time    = 0;
+
+void dynamic_keymap_cache_load(void) {
+    eeprom_read_block(dynamic_keymap_cache, (void *)DYNAMIC_KEYMAP_EEPROM_ADDR, DYNAMIC_KEYMAP_EEPROM_SIZE);
+    memset(dynamic_keymap_dirty, 0, sizeof(dynamic_keymap_dirty));
+    dynamic_keymap_cache_dirty  = false;
+    dynamic_keymap_cache_loaded = true;
+}
+
+static inline bool dynamic_keymap_key_is_valid(uint8_t layer, uint8_t row, uint8_t column) { return layer < DYNAMIC_KEYMAP_LAYER_COUNT && row < MATRIX_ROWS && column < MATRIX_COLS; }
+
+static inline uint16_t dynamic_keymap_key_to_offset(uint8_t layer, uint8_t row, uint8_t column) { return (layer * MATRIX_ROWS * MATRIX_COLS * 2) + (row * MATRIX_COLS * 2) + (column * 2); }
+
+static inline void dynamic_keymap_cache_ensure_loaded(void) {
+    if (!dynamic_keymap_cache_loaded) {
+        dynamic_keymap_cache_load();
+    }
+}
+
+static void dynamic_keymap_cache_write(uint16_t offset, uint8_t value) {
+    if (dynamic_keymap_cache[offset] == value) {
+        return;
+    }
+    dynamic_keymap_cache[offset] = value;
+    dynamic_keymap_dirty[offset / 16] |= 1 << ((offset / 2) % 8);
+    dynamic_keymap_cache_dirty = true;
+    dynamic_keymap_last_write  = timer_read();
+}
+
+void dynamic_keymap_flush(void) {
+    if (!dynamic_keymap_cache_dirty) {
+        return;
+    }
+    // Write each run of consecutive dirty keycodes as one block
+    uint16_t key_count = DYNAMIC_KEYMAP_EEPROM_SIZE / 2;
+    for (uint16_t key = 0; key < key_count; key++) {
+        if (!(dynamic_keymap_dirty[key / 8] & (1 << (key % 8)))) {
+            continue;
+        }
+        uint16_t first = key;
+        while (key < key_count && (dynamic_keymap_dirty[key / 8] & (1 << (key % 8)))) {
+            dynamic_keymap_dirty[key / 8] &= ~(1 << (key % 8));
+            key++;
+        }
+        eeprom_update_block(&dynamic_keymap_cache[first * 2], (void *)(uintptr_t)(DYNAMIC_KEYMAP_EEPROM_ADDR + first * 2), (key - first) * 2);
+    }
+    dynamic_keymap_cache_dirty = false;
+}
+
+void dynamic_keymap_hold(void) {
+    dynamic_keymap_cache_ensure_loaded();
+    if (!dynamic_keymap_held) {
+        // Only what is edited while held may be dropped, not what came before
+        dynamic_keymap_flush();
+    }
+    dynamic_keymap_held      = true;
+    dynamic_keymap_hold_time = timer_read();
+}
+
+void dynamic_keymap_release(bool commit) {
+    if (!dynamic_keymap_held) {
+        return;
+    }
+    dynamic_keymap_held = false;
+    if (commit) {
+        dynamic_keymap_flush();
+    } else {
+        // Drop the edits made while held, everything older was flushed by the hold
+        dynamic_keymap_cache_load();
+#    ifdef LAYER_RESOLUTION_CACHE
+        layer_resolution_cache_clear();
+#    endif
+    }
+}
+
+void dynamic_keymap_task(void) {
+    if (dynamic_keymap_held) {
+        if (timer_elapsed(dynamic_keymap_hold_time) >= DYNAMIC_KEYMAP_HOLD_TIMEOUT) {
+            dynamic_keymap_release(false);
+        }
+        return;
+    }
+    if (dynamic_keymap_cache_dirty && timer_elapsed(dynamic_keymap_last_write) >= DYNAMIC_KEYMAP_WRITE_BACK_DELAY) {
+        dynamic_keymap_flush();
+    }
+}
+#endif
+
 uint8_t dynamic_keymap_get_layer_count(void) { return DYNAMIC_KEYMAP_LAYER_COUNT; }
 
 void *dynamic_keymap_key_to_eeprom_address(uint8_t layer, uint8_t row, uint8_t column) {
@@ -87,21 +200,48 @@ void *dynamic_keymap_key_to_eeprom_address(uint8_t layer, uint8_t row, uint8_t c
 }
 
 uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column) {
+#ifdef DYNAMIC_KEYMAP_RAM_CACHE
+    if (!dynamic_keymap_key_is_valid(layer, row, column)) {
+        return KC_NO;
+    }
+    dynamic_keymap_cache_ensure_loaded();
+    uint16_t offset = dynamic_keymap_key_to_offset(layer, row, column);
+    // Big endian, same as in EEPROM
+    return (dynamic_keymap_cache[offset] << 8) | dynamic_keymap_cache[offset + 1];
+#else
     void *address = dynamic_keymap_key_to_eeprom_address(layer, row, column);
     // Big endian, so we can read/write EEPROM directly from host if we want
     uint16_t keycode = eeprom_read_byte(address) << 8;
     keycode |= eeprom_read_byte(address + 1);
     return keycode;
+#endif
 }
 
 void dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t column, uint16_t keycode) {
+#ifdef DYNAMIC_KEYMAP_RAM_CACHE
+    if (!dynamic_keymap_key_is_valid(layer, row, column)) {
+        return;
+    }
+    dynamic_keymap_cache_ensure_loaded();
+    uint16_t offset = dynamic_keymap_key_to_offset(layer, row, column);
+    dynamic_keymap_cache_write(offset, (uint8_t)(keycode >> 8));
+    dynamic_keymap_cache_write(offset + 1, (uint8_t)(keycode & 0xFF));
+#else
     void *address = dynamic_keymap_key_to_eeprom_address(layer, row, column);
     // Big endian, so we can read/write EEPROM directly from host if we want
     eeprom_update_byte(address, (uint8_t)(keycode >> 8));
     eeprom_update_byte(address + 1, (uint8_t)(keycode & 0xFF));
+#endif
+#ifdef LAYER_RESOLUTION_CACHE
+    layer_resolution_cache_clear();
+#endif
 }
 
 void dynamic_keymap_reset(void) {
+#ifdef DYNAMIC_KEYMAP_RAM_CACHE
+    // Start from what EEPROM holds, so unchanged keycodes are not rewritten
+    dynamic_keymap_cache_load();
+#endif
     // Reset the keymaps in EEPROM to what is in flash.
     // All keyboards using dynamic keymaps should define a layout
     // for the same number of layers as DYNAMIC_KEYMAP_LAYER_COUNT.
@@ -112,11 +252,21 @@ void dynamic_keymap_reset(void) {
             }
         }
     }
+#ifdef DYNAMIC_KEYMAP_RAM_CACHE
+    // via_init() marks the EEPROM valid right after this, so write it out now
+    dynamic_keymap_flush();
+#endif
 }
 
 void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
+#ifdef DYNAMIC_KEYMAP_RAM_CACHE
+    dynamic_keymap_cache_ensure_loaded();
+    for (uint16_t i = 0; i < size; i++) {
+        data[i] = (offset + i < DYNAMIC_KEYMAP_EEPROM_SIZE) ? dynamic_keymap_cache[offset + i] : 0x00;
+    }
+#else
     uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-    void *   source                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
+    void *   source                     = (void *)(uintptr_t)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
     uint8_t *target                     = data;
     for (uint16_t i = 0; i < size; i++) {
         if (offset + i < dynamic_keymap_eeprom_size) {
@@ -127,19 +277,28 @@ void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
         source++;
         target++;
     }
+#endif
 }
 
 void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
+#ifdef DYNAMIC_KEYMAP_RAM_CACHE
+    dynamic_keymap_cache_ensure_loaded();
+    for (uint16_t i = 0; i < size && offset + i < DYNAMIC_KEYMAP_EEPROM_SIZE; i++) {
+        dynamic_keymap_cache_write(offset + i, data[i]);
+    }
+#else
     uint16_t dynamic_keymap_eeprom_size = DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2;
-    void *   target                     = (void *)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset);
-    uint8_t *source                     = data;
-    for (uint16_t i = 0; i < size; i++) {
-        if (offset + i < dynamic_keymap_eeprom_size) {
-            eeprom_update_byte(target, *source);
+    if (offset < dynamic_keymap_eeprom_size) {
+        if (size > dynamic_keymap_eeprom_size - offset) {
+            size = dynamic_keymap_eeprom_size - offset;
         }
-        source++;
-        target++;
+        // One block update lets the EEPROM driver batch the writes
+        eeprom_update_block(data, (void *)(uintptr_t)(DYNAMIC_KEYMAP_EEPROM_ADDR + offset), size);
     }
+#endif
+#ifdef LAYER_RESOLUTION_CACHE
+    layer_resolution_cache_clear();
+#endif
 }
 
 // This overrides the one in quantum/keymap_common.c
@@ -156,7 +315,7 @@ uint8_t dynamic_keymap_macro_get_count(void) { return DYNAMIC_KEYMAP_MACRO_COUNT
 uint16_t dynamic_keymap_macro_get_buffer_size(void) { return DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE; }
 
 void dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    void *   source = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
+    void *   source = (void *)(uintptr_t)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
     uint8_t *target = data;
     for (uint16_t i = 0; i < size; i++) {
         if (offset + i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
@@ -170,26 +329,27 @@ void dynamic_keymap_macro_get_buffer(uint16_t offset, uint16_t size, uint8_t *da
 }
 
 void dynamic_keymap_macro_set_buffer(uint16_t offset, uint16_t size, uint8_t *data) {
-    void *   target = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset);
-    uint8_t *source = data;
-    for (uint16_t i = 0; i < size; i++) {
-        if (offset + i < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
-            eeprom_update_byte(target, *source);
+    if (offset < DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE) {
+        if (size > DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - offset) {
+            size = DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - offset;
         }
-        source++;
-        target++;
+        eeprom_update_block(data, (void *)(uintptr_t)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + offset), size);
     }
 }
 
 void dynamic_keymap_macro_reset(void) {
-    void *p   = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR);
-    void *end = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE);
+    void *p   = (void *)(uintptr_t)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR);
+    void *end = (void *)(uintptr_t)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE);
     while (p != end) {
         eeprom_update_byte(p, 0);
         ++p;
     }
 }
 
+#ifdef SEND_STRING_ASYNC
+static char dynamic_keymap_macro_read(const char *str) { return eeprom_read_byte((const uint8_t *)str); }
+#endif
+
 void dynamic_keymap_macro_send(uint8_t id) {
     if (id >= DYNAMIC_KEYMAP_MACRO_COUNT) {
         return;
@@ -199,15 +359,15 @@ void dynamic_keymap_macro_send(uint8_t id) {
     // If it's not zero, then we are in the middle
     // of buffer writing, possibly an aborted buffer
     // write. So do nothing.
-    void *p = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - 1);
+    void *p = (void *)(uintptr_t)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE - 1);
     if (eeprom_read_byte(p) != 0) {
         return;
     }
 
     // Skip N null characters
     // p will then point to the Nth macro
-    p         = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR);
-    void *end = (void *)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE);
+    p         = (void *)(uintptr_t)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR);
+    void *end = (void *)(uintptr_t)(DYNAMIC_KEYMAP_MACRO_EEPROM_ADDR + DYNAMIC_KEYMAP_MACRO_EEPROM_SIZE);
     while (id > 0) {
         // If we are past the end of the buffer, then the buffer
         // contents are garbage, i.e. there were not DYNAMIC_KEYMAP_MACRO_COUNT
@@ -221,6 +381,10 @@ void dynamic_keymap_macro_send(uint8_t id) {
         ++p;
     }
 
+#ifdef SEND_STRING_ASYNC
+    // The macro is read straight from EEPROM as it is sent
+    send_string_async((const char *)p, dynamic_keymap_macro_read, 0, true);
+#else
     // Send the macro string one or three chars at a time
     // by making temporary 1 or 3 char strings
     char data[4] = {0, 0, 0, 0};
@@ -245,4 +409,5 @@ void dynamic_keymap_macro_send(uint8_t id) {
         }
         send_string(data);
     }
+#endif
 }
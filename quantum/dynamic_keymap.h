@@ -18,6 +18,10 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#ifndef DYNAMIC_KEYMAP_LAYER_COUNT
+#    define DYNAMIC_KEYMAP_LAYER_COUNT 4
+#endif
+
 uint8_t  dynamic_keymap_get_layer_count(void);
 void *   dynamic_keymap_key_to_eeprom_address(uint8_t layer, uint8_t row, uint8_t column);
 uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t column);
@@ -34,6 +38,20 @@ void     dynamic_keymap_reset(void);
 void dynamic_keymap_get_buffer(uint16_t offset, uint16_t size, uint8_t *data);
 void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, uint8_t *data);
 
+#ifdef DYNAMIC_KEYMAP_RAM_CACHE
+// With DYNAMIC_KEYMAP_RAM_CACHE, lookups and edits go through a RAM copy of the keymap.
+// Edits are written back to EEPROM by dynamic_keymap_task() once the keymap has been
+// left alone for DYNAMIC_KEYMAP_WRITE_BACK_DELAY ms, or right away by dynamic_keymap_flush().
+void dynamic_keymap_cache_load(void);
+void dynamic_keymap_flush(void);
+void dynamic_keymap_task(void);
+// dynamic_keymap_hold() writes back pending edits, then keeps further edits in RAM only
+// until dynamic_keymap_release() either writes them back or drops them. Call it again to
+// renew the hold, a hold that is left alone for DYNAMIC_KEYMAP_HOLD_TIMEOUT ms is dropped.
+void dynamic_keymap_hold(void);
+void dynamic_keymap_release(bool commit);
+#endif
+
 // This overrides the one in quantum/keymap_common.c
 // uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
 
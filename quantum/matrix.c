@@ -19,7 +19,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "util.h"
 #include "matrix.h"
 #include "debounce.h"
+#include "task_profile.h"
 #include "quantum.h"
+#include "matrix_port_group.h"
+#include "matrix_idle.h"
 
 #ifdef DIRECT_PINS
 static pin_t direct_pins[MATRIX_ROWS][MATRIX_COLS] = DIRECT_PINS;
@@ -90,11 +93,15 @@ static void unselect_rows(void) {
     }
 }
 
+// Column pins grouped by GPIO port, built from col_pins by init_pins()
+static matrix_port_group_t col_ports;
+
 static void init_pins(void) {
     unselect_rows();
     for (uint8_t x = 0; x < MATRIX_COLS; x++) {
         setPinInputHigh_atomic(col_pins[x]);
     }
+    matrix_port_group_init(&col_ports, col_pins, MATRIX_COLS);
 }
 
 static bool read_cols_on_row(matrix_row_t current_matrix[], uint8_t current_row) {
@@ -105,13 +112,18 @@ static bool read_cols_on_row(matrix_row_t current_matrix[], uint8_t current_row)
     select_row(current_row);
     matrix_output_select_delay();
 
+    // Sample every port the cols live on
+    port_data_t port_state[MATRIX_COLS];
+    matrix_port_group_read(&col_ports, port_state);
+
     // For each col...
     for (uint8_t col_index = 0; col_index < MATRIX_COLS; col_index++) {
-        // Select the col pin to read (active low)
-        uint8_t pin_state = readPin(col_pins[col_index]);
+        if (col_pins[col_index] == NO_PIN) {
+            continue;
+        }
 
-        // Populate the matrix row with the state of the col pin
-        current_row_value |= pin_state ? 0 : (MATRIX_ROW_SHIFTER << col_index);
+        // Populate the matrix row with the state of the col pin (active low)
+        current_row_value |= matrix_port_group_pin_high(&col_ports, port_state, col_index) ? 0 : (MATRIX_ROW_SHIFTER << col_index);
     }
 
     // Unselect row
@@ -128,6 +140,24 @@ static bool read_cols_on_row(matrix_row_t current_matrix[], uint8_t current_row)
     return false;
 }
 
+#        ifdef MATRIX_IDLE_TIMEOUT
+#            define IDLE_SENSE_PINS col_pins
+#            define IDLE_SENSE_COUNT MATRIX_COLS
+
+static void idle_select_all(void) {
+    for (uint8_t x = 0; x < MATRIX_ROWS; x++) {
+        if (row_pins[x] != NO_PIN) {
+            select_row(x);
+        }
+    }
+}
+
+static void idle_unselect_all(void) { unselect_rows(); }
+
+// With every row selected, any pressed key pulls its col low
+static bool idle_sense_any(void) { return matrix_port_group_any_low(&col_ports); }
+#        endif
+
 #    elif (DIODE_DIRECTION == ROW2COL)
 
 static void select_col(uint8_t col) { setPinOutput_writeLow(col_pins[col]); }
@@ -185,6 +215,31 @@ static bool read_rows_on_col(matrix_row_t current_matrix[], uint8_t current_col)
     return matrix_changed;
 }
 
+#        ifdef MATRIX_IDLE_TIMEOUT
+#            define IDLE_SENSE_PINS row_pins
+#            define IDLE_SENSE_COUNT MATRIX_ROWS
+
+static void idle_select_all(void) {
+    for (uint8_t x = 0; x < MATRIX_COLS; x++) {
+        if (col_pins[x] != NO_PIN) {
+            select_col(x);
+        }
+    }
+}
+
+static void idle_unselect_all(void) { unselect_cols(); }
+
+// With every col selected, any pressed key pulls its row low
+static bool idle_sense_any(void) {
+    for (uint8_t x = 0; x < MATRIX_ROWS; x++) {
+        if (row_pins[x] != NO_PIN && readPin(row_pins[x]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+#        endif
+
 #    else
 #        error DIODE_DIRECTION must be one of COL2ROW or ROW2COL!
 #    endif
@@ -192,9 +247,61 @@ static bool read_rows_on_col(matrix_row_t current_matrix[], uint8_t current_col)
 #    error DIODE_DIRECTION is not defined!
 #endif
 
+#if defined(MATRIX_IDLE_TIMEOUT) && !defined(DIRECT_PINS)
+/* Idle scanning
+ *
+ * Once the matrix has been quiet for MATRIX_IDLE_TIMEOUT ms with no key held,
+ * every strobe line is driven active at once and full scans stop: each
+ * matrix_scan() only samples the sense lines, and resumes scanning on the
+ * first one that reads active. Where pin interrupts are available (ChibiOS
+ * with PAL callbacks, LUFA AVRs) the sense lines are also armed for them, and
+ * the main loop sleeps in matrix_idle_wait() until an edge or the next poll
+ * instead of spinning.
+ */
+static bool idle_active = false;
+
+bool matrix_is_idle(void) { return idle_active; }
+
+bool matrix_idle_enter(void) {
+    if (idle_active) {
+        return true;
+    }
+
+    // A held key keeps its sense line active, so a second key on it would go unnoticed
+    for (uint8_t i = 0; i < MATRIX_ROWS; i++) {
+        if (raw_matrix[i] || matrix[i]) {
+            return false;
+        }
+    }
+
+    idle_select_all();
+#    ifdef MATRIX_IDLE_IRQ
+    matrix_idle_irq_arm();
+#    endif
+    idle_active = true;
+    return true;
+}
+
+void matrix_idle_exit(void) {
+    if (!idle_active) {
+        return;
+    }
+
+#    ifdef MATRIX_IDLE_IRQ
+    matrix_idle_irq_disarm();
+#    endif
+    idle_unselect_all();
+    matrix_output_unselect_delay();  // wait for the strobe lines to go HIGH
+    idle_active = false;
+}
+#endif
+
 void matrix_init(void) {
     // initialize key pins
     init_pins();
+#if defined(MATRIX_IDLE_TIMEOUT) && defined(MATRIX_IDLE_IRQ) && !defined(DIRECT_PINS)
+    matrix_idle_irq_init(IDLE_SENSE_PINS, IDLE_SENSE_COUNT);
+#endif
 
     // initialize matrix state: all keys off
     for (uint8_t i = 0; i < MATRIX_ROWS; i++) {
@@ -210,6 +317,18 @@ void matrix_init(void) {
 uint8_t matrix_scan(void) {
     bool changed = false;
 
+#if defined(MATRIX_IDLE_TIMEOUT) && !defined(DIRECT_PINS)
+    if (idle_active) {
+        if (!idle_sense_any()) {
+            debounce(raw_matrix, matrix, MATRIX_ROWS, false);
+
+            matrix_scan_quantum();
+            return 0;
+        }
+        matrix_idle_exit();
+    }
+#endif
+
 #if defined(DIRECT_PINS) || (DIODE_DIRECTION == COL2ROW)
     // Set row, read cols
     for (uint8_t current_row = 0; current_row < MATRIX_ROWS; current_row++) {
@@ -222,7 +341,15 @@ uint8_t matrix_scan(void) {
     }
 #endif
 
+    TASK_PROFILE_BEGIN(TASK_PROFILE_DEBOUNCE);
     debounce(raw_matrix, matrix, MATRIX_ROWS, changed);
+    TASK_PROFILE_END(TASK_PROFILE_DEBOUNCE);
+
+#if defined(MATRIX_IDLE_TIMEOUT) && !defined(DIRECT_PINS)
+    if (!changed && last_matrix_activity_elapsed() >= MATRIX_IDLE_TIMEOUT) {
+        matrix_idle_enter();
+    }
+#endif
 
     matrix_scan_quantum();
     return (uint8_t)changed;
@@ -64,6 +64,12 @@ void matrix_io_delay(void);
 void matrix_power_up(void);
 void matrix_power_down(void);
 
+/* idle scanning, see MATRIX_IDLE_TIMEOUT */
+bool matrix_idle_enter(void);
+void matrix_idle_exit(void);
+bool matrix_is_idle(void);
+void matrix_idle_wait(void);
+
 /* executes code for Quantum */
 void matrix_init_quantum(void);
 void matrix_scan_quantum(void);
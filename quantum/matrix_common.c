@@ -1,6 +1,7 @@
 #include "quantum.h"
 #include "matrix.h"
 #include "debounce.h"
+#include "task_profile.h"
 #include "wait.h"
 #include "print.h"
 #include "debug.h"
@@ -90,6 +91,12 @@ __attribute__((weak)) void matrix_io_delay(void) { wait_us(MATRIX_IO_DELAY); }
 __attribute__((weak)) void matrix_output_select_delay(void) { waitInputPinDelay(); }
 __attribute__((weak)) void matrix_output_unselect_delay(void) { matrix_io_delay(); }
 
+// Matrices without idle scanning are never idle
+__attribute__((weak)) bool matrix_idle_enter(void) { return false; }
+__attribute__((weak)) void matrix_idle_exit(void) {}
+__attribute__((weak)) bool matrix_is_idle(void) { return false; }
+__attribute__((weak)) void matrix_idle_wait(void) {}
+
 // CUSTOM MATRIX 'LITE'
 __attribute__((weak)) void matrix_init_custom(void) {}
 
@@ -112,7 +119,9 @@ __attribute__((weak)) void matrix_init(void) {
 __attribute__((weak)) uint8_t matrix_scan(void) {
     bool changed = matrix_scan_custom(raw_matrix);
 
+    TASK_PROFILE_BEGIN(TASK_PROFILE_DEBOUNCE);
     debounce(raw_matrix, matrix, MATRIX_ROWS, changed);
+    TASK_PROFILE_END(TASK_PROFILE_DEBOUNCE);
 
     matrix_scan_quantum();
     return changed;
@@ -0,0 +1,217 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+#include "matrix.h"
+#include "matrix_idle.h"
+
+#if defined(MATRIX_IDLE_TIMEOUT) && defined(MATRIX_IDLE_IRQ) && !defined(DIRECT_PINS)
+
+// How long the main loop sleeps between polls of an idle matrix
+#    ifndef MATRIX_IDLE_WAIT
+#        define MATRIX_IDLE_WAIT 1
+#    endif
+
+#    if defined(PROTOCOL_CHIBIOS)
+static BSEMAPHORE_DECL(idle_wake_sem, true);
+
+static const pin_t *idle_pins;
+static uint8_t      idle_pin_count;
+static uint32_t     idle_irq_pins;  // sense pins that are armed, one bit per pin
+
+/* STM32 EXTI lines are shared by pad number across ports, so only sense pins
+ * with a pad of their own are armed, the others are left to the poll. The
+ * split serial driver also listens on the pad of SOFT_SERIAL_PIN. Pins are
+ * not constant expressions on ChibiOS, so this is sorted out at init.
+ */
+void matrix_idle_irq_init(const pin_t *pins, uint8_t count) {
+    idle_pins      = pins;
+    idle_pin_count = count;
+    idle_irq_pins  = 0;
+    for (uint8_t x = 0; x < count; x++) {
+        bool own_pad = pins[x] != NO_PIN;
+#        ifdef SOFT_SERIAL_PIN
+        own_pad = own_pad && PAL_PAD(SOFT_SERIAL_PIN) != PAL_PAD(pins[x]);
+#        endif
+        for (uint8_t y = 0; y < count && own_pad; y++) {
+            if (y != x && pins[y] != NO_PIN && PAL_PAD(pins[y]) == PAL_PAD(pins[x])) {
+                own_pad = false;
+            }
+        }
+        if (own_pad) {
+            idle_irq_pins |= (uint32_t)1 << x;
+        }
+    }
+}
+
+static void idle_wake_cb(void *arg) {
+    chSysLockFromISR();
+    chBSemSignalI(&idle_wake_sem);
+    chSysUnlockFromISR();
+}
+
+void matrix_idle_irq_arm(void) {
+    chBSemReset(&idle_wake_sem, true);
+    for (uint8_t x = 0; x < idle_pin_count; x++) {
+        if (idle_irq_pins & ((uint32_t)1 << x)) {
+            palEnableLineEvent(idle_pins[x], PAL_EVENT_MODE_FALLING_EDGE);
+            palSetLineCallback(idle_pins[x], idle_wake_cb, NULL);
+        }
+    }
+}
+
+void matrix_idle_irq_disarm(void) {
+    for (uint8_t x = 0; x < idle_pin_count; x++) {
+        if (idle_irq_pins & ((uint32_t)1 << x)) {
+            palDisableLineEvent(idle_pins[x]);
+        }
+    }
+}
+
+void matrix_idle_wait(void) {
+    if (matrix_is_idle()) {
+        chBSemWaitTimeout(&idle_wake_sem, TIME_MS2I(MATRIX_IDLE_WAIT));
+    }
+}
+
+#    elif defined(PROTOCOL_LUFA)
+#        include <avr/interrupt.h>
+#        include <avr/sleep.h>
+
+/* Every USB AVR has PCINT0-7 on port B and INT0-3 on D0-D3, sense pins
+ * anywhere else are only seen on the next Timer0 tick. Pin interrupts that
+ * belong to the split serial driver or to a PS/2, XT or IBM 4704 host are
+ * left alone.
+ */
+#        if defined(PS2_INT_VECT) || defined(XT_INT_VECT) || defined(IBM4704_INT_VECT)
+#            define IDLE_PCINT0 0
+#            define IDLE_INT0 0
+#            define IDLE_INT1 0
+#            define IDLE_INT2 0
+#            define IDLE_INT3 0
+#        else
+#            define IDLE_PCINT0 1
+#            if defined(SOFT_SERIAL_PIN) && SOFT_SERIAL_PIN == D0
+#                define IDLE_INT0 0
+#            else
+#                define IDLE_INT0 _BV(INT0)
+#            endif
+#            if defined(SOFT_SERIAL_PIN) && SOFT_SERIAL_PIN == D1
+#                define IDLE_INT1 0
+#            else
+#                define IDLE_INT1 _BV(INT1)
+#            endif
+#            if defined(SOFT_SERIAL_PIN) && SOFT_SERIAL_PIN == D2
+#                define IDLE_INT2 0
+#            else
+#                define IDLE_INT2 _BV(INT2)
+#            endif
+#            if defined(SOFT_SERIAL_PIN) && SOFT_SERIAL_PIN == D3
+#                define IDLE_INT3 0
+#            else
+#                define IDLE_INT3 _BV(INT3)
+#            endif
+#        endif
+
+static volatile bool idle_woken = false;
+
+// INTn of D0-D3 and PCINTn of port B that are armed
+static uint8_t idle_int_mask;
+static uint8_t idle_pcint_mask;
+
+#        if IDLE_PCINT0
+ISR(PCINT0_vect) { idle_woken = true; }
+#        endif
+#        if IDLE_INT0
+ISR(INT0_vect) { idle_woken = true; }
+#        endif
+#        if IDLE_INT1
+ISR(INT1_vect) { idle_woken = true; }
+#        endif
+#        if IDLE_INT2
+ISR(INT2_vect) { idle_woken = true; }
+#        endif
+#        if IDLE_INT3
+ISR(INT3_vect) { idle_woken = true; }
+#        endif
+
+void matrix_idle_irq_init(const pin_t *pins, uint8_t count) {
+    idle_int_mask   = 0;
+    idle_pcint_mask = 0;
+    for (uint8_t x = 0; x < count; x++) {
+        if (pins[x] == NO_PIN) {
+            continue;
+        }
+        if (IDLE_PCINT0 && getPinPort(pins[x]) == getPinPort(B0)) {
+            idle_pcint_mask |= getPinMask(pins[x]);
+        } else if (getPinPort(pins[x]) == getPinPort(D0) && (pins[x] & 0xF) < 4) {
+            // INTn sits on Dn
+            idle_int_mask |= getPinMask(pins[x]) & (IDLE_INT0 | IDLE_INT1 | IDLE_INT2 | IDLE_INT3);
+        }
+    }
+}
+
+void matrix_idle_irq_arm(void) {
+    idle_woken = false;
+    for (uint8_t n = 0; n < 4; n++) {
+        if (idle_int_mask & _BV(n)) {
+            // falling edge
+            EICRA = (EICRA & ~(3 << (n * 2))) | (2 << (n * 2));
+        }
+    }
+    EIFR = idle_int_mask;
+    EIMSK |= idle_int_mask;
+    if (idle_pcint_mask) {
+        PCIFR = _BV(PCIF0);
+        PCMSK0 |= idle_pcint_mask;
+        PCICR |= _BV(PCIE0);
+    }
+}
+
+void matrix_idle_irq_disarm(void) {
+    EIMSK &= ~idle_int_mask;
+    PCMSK0 &= ~idle_pcint_mask;
+    if (!PCMSK0) {
+        PCICR &= ~_BV(PCIE0);
+    }
+}
+
+/* Sleeps until a sense pin fires or MATRIX_IDLE_WAIT ms have passed. Idle
+ * sleep keeps the clocks running, so USB and the Timer0 tick wake it too.
+ */
+void matrix_idle_wait(void) {
+    if (!matrix_is_idle()) {
+        return;
+    }
+
+    uint16_t start = timer_read();
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    while (timer_elapsed(start) < MATRIX_IDLE_WAIT) {
+        cli();
+        if (idle_woken) {
+            idle_woken = false;
+            sei();
+            return;
+        }
+        // nothing can fire between sei and sleep, so a wake up is never missed
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+    }
+}
+#    endif
+#endif
@@ -0,0 +1,35 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "gpio.h"
+
+/* Pin interrupts that wake the main loop while the matrix is idle, see
+ * MATRIX_IDLE_TIMEOUT. Shared by the standard and split matrix, which hand
+ * over the pins they sense with. Where there are no pin interrupts the sense
+ * pins are only polled, and matrix_idle_wait() does not sleep.
+ */
+#if (defined(PROTOCOL_CHIBIOS) && (PAL_USE_CALLBACKS == TRUE)) || defined(PROTOCOL_LUFA)
+#    define MATRIX_IDLE_IRQ
+#endif
+
+#ifdef MATRIX_IDLE_IRQ
+void matrix_idle_irq_init(const pin_t *pins, uint8_t count);
+void matrix_idle_irq_arm(void);
+void matrix_idle_irq_disarm(void);
+#endif
@@ -0,0 +1,78 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gpio.h"
+
+/* Matrix pins grouped by GPIO port, so that all of them are sampled with one
+ * read per port instead of one per pin. Shared by the standard and split
+ * matrix, which keep one group for the pins they read.
+ */
+#ifndef MATRIX_PORT_GROUP_SIZE
+#    define MATRIX_PORT_GROUP_SIZE MATRIX_COLS
+#endif
+
+typedef struct {
+    uint8_t     count;                          // ports in use
+    port_t      ports[MATRIX_PORT_GROUP_SIZE];  // each port once
+    port_data_t used[MATRIX_PORT_GROUP_SIZE];   // pins of each port that belong to the group
+    uint8_t     index[MATRIX_PORT_GROUP_SIZE];  // port of each pin
+    port_data_t mask[MATRIX_PORT_GROUP_SIZE];   // bit of each pin within its port
+} matrix_port_group_t;
+
+static inline void matrix_port_group_init(matrix_port_group_t *group, const pin_t *pins, uint8_t pin_count) {
+    group->count = 0;
+    for (uint8_t x = 0; x < pin_count; x++) {
+        if (pins[x] == NO_PIN) {
+            continue;
+        }
+        port_t  port = getPinPort(pins[x]);
+        uint8_t i    = 0;
+        while (i < group->count && group->ports[i] != port) {
+            i++;
+        }
+        if (i == group->count) {
+            group->ports[group->count++] = port;
+            group->used[i]               = 0;
+        }
+        group->index[x] = i;
+        group->mask[x]  = getPinMask(pins[x]);
+        group->used[i] |= group->mask[x];
+    }
+}
+
+// Samples every port of the group, state needs room for one entry per port
+static inline void matrix_port_group_read(const matrix_port_group_t *group, port_data_t *state) {
+    for (uint8_t i = 0; i < group->count; i++) {
+        state[i] = readPort(group->ports[i]);
+    }
+}
+
+// Level of pin x out of the sampled ports, the pin must not be NO_PIN
+static inline bool matrix_port_group_pin_high(const matrix_port_group_t *group, const port_data_t *state, uint8_t x) { return state[group->index[x]] & group->mask[x]; }
+
+// Whether any pin of the group reads low
+static inline bool matrix_port_group_any_low(const matrix_port_group_t *group) {
+    for (uint8_t i = 0; i < group->count; i++) {
+        if ((readPort(group->ports[i]) & group->used[i]) != group->used[i]) {
+            return true;
+        }
+    }
+    return false;
+}
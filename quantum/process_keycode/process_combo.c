@@ -14,6 +14,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdlib.h>
 #include "print.h"
 #include "process_combo.h"
 
@@ -26,18 +27,182 @@ extern int      COMBO_LEN;
 
 __attribute__((weak)) void process_combo_event(uint16_t combo_index, bool pressed) {}
 
+#ifdef COMBO_TERM_PER_COMBO
+__attribute__((weak)) uint16_t get_combo_term(uint16_t combo_index, combo_t *combo) { return COMBO_TERM; }
+#    define COMBO_TERM_OF(index) get_combo_term(index, &key_combos[index])
+#else
+#    define COMBO_TERM_OF(index) COMBO_TERM
+#endif
+
+#define COMBO_KEY_BIT(bit) ((uint32_t)1 << (bit))
+
 static uint16_t timer               = 0;
 static uint16_t current_combo_index = 0;
-static bool     drop_buffer         = false;
-static bool     is_active           = false;
+static bool     is_active           = true;
 static bool     b_combo_enable      = true;  // defaults to enabled
+static uint8_t  combo_keys_held     = 0;     // keys down that are part of a combo
 
-static uint8_t buffer_size = 0;
-#ifdef COMBO_ALLOW_ACTION_KEYS
+/* Presses held back while they can still complete a combo. Every combo has a
+ * bit set in its state for each of these keys it contains, so the combos
+ * containing all of them (the candidates) are the ones with as many bits set
+ * as there are keys in the buffer. */
+static uint8_t     buffer_size = 0;
 static keyrecord_t key_buffer[MAX_COMBO_LENGTH];
+static uint16_t    buffer_keycodes[MAX_COMBO_LENGTH];
+static uint16_t    buffer_term = 0;  // the buffer is resolved once this long has passed since timer
+
+/* combos that fired and still have keys down */
+typedef struct {
+    uint16_t combo_index;
+    uint32_t keys_down;
+    bool     released;
+} active_combo_t;
+
+static active_combo_t active_combos[MAX_COMBO_LENGTH];
+static uint8_t        active_count = 0;
+
+static inline uint16_t combo_count(void) {
+#ifndef COMBO_VARIABLE_LEN
+    return COMBO_COUNT;
 #else
-static uint16_t key_buffer[MAX_COMBO_LENGTH];
+    return COMBO_LEN;
 #endif
+}
+
+/* Reverse index from keycode to the combos using it, sorted by keycode and
+ * then combo index. Built from key_combos by combo_init(), so that only the
+ * combos containing the key have their key list read. */
+typedef struct {
+    uint16_t keycode;
+    uint16_t combo_index;
+} combo_index_entry_t;
+
+#ifdef COMBO_INDEX_SIZE
+static combo_index_entry_t combo_index_buffer[COMBO_INDEX_SIZE];
+#endif
+static combo_index_entry_t *combo_index;
+static uint16_t             combo_index_size;
+
+/* Low byte of every combo key, lets keys outside of all combos through without
+ * looking at the combos when there is no index. */
+static uint8_t combo_key_filter[32];
+
+#define COMBO_FILTER_BIT(keycode) ((uint8_t)1 << ((keycode)&7))
+#define COMBO_FILTER_BYTE(keycode) combo_key_filter[((keycode)&0xFF) >> 3]
+
+static int combo_index_compare(const void *a, const void *b) {
+    const combo_index_entry_t *entry_a = a;
+    const combo_index_entry_t *entry_b = b;
+    if (entry_a->keycode != entry_b->keycode) {
+        return entry_a->keycode < entry_b->keycode ? -1 : 1;
+    }
+    return (int)entry_a->combo_index - (int)entry_b->combo_index;
+}
+
+static void build_combo_index(void) {
+    uint16_t size = 0;
+    for (uint16_t i = 0; i < combo_count(); ++i) {
+        for (const uint16_t *keys = key_combos[i].keys; COMBO_END != pgm_read_word(keys); ++keys) {
+            COMBO_FILTER_BYTE(pgm_read_word(keys)) |= COMBO_FILTER_BIT(pgm_read_word(keys));
+            size++;
+        }
+    }
+    // without room for the index every combo is scanned instead
+#ifdef COMBO_INDEX_SIZE
+    if (size > COMBO_INDEX_SIZE) {
+        dprintf("combo: index needs %u entries, COMBO_INDEX_SIZE is %u\n", size, COMBO_INDEX_SIZE);
+        return;
+    }
+    combo_index = combo_index_buffer;
+#else
+    combo_index = (combo_index_entry_t *)malloc(size * sizeof(combo_index_entry_t));
+    if (!combo_index) {
+        return;
+    }
+#endif
+
+    for (uint16_t i = 0; i < combo_count(); ++i) {
+        for (const uint16_t *keys = key_combos[i].keys; COMBO_END != pgm_read_word(keys); ++keys) {
+            combo_index[combo_index_size++] = (combo_index_entry_t){.keycode = pgm_read_word(keys), .combo_index = i};
+        }
+    }
+    qsort(combo_index, combo_index_size, sizeof(combo_index_entry_t), combo_index_compare);
+
+    // a key used twice in a combo still selects it once
+    uint16_t unique = 0;
+    for (uint16_t i = 0; i < combo_index_size; ++i) {
+        if (unique == 0 || combo_index_compare(&combo_index[unique - 1], &combo_index[i]) != 0) {
+            combo_index[unique++] = combo_index[i];
+        }
+    }
+    combo_index_size = unique;
+}
+
+/* first index entry for keycode, or combo_index_size if there is none */
+static uint16_t find_combo_index(uint16_t keycode) {
+    uint16_t low = 0, high = combo_index_size;
+    while (low < high) {
+        uint16_t middle = low + (high - low) / 2;
+        if (combo_index[middle].keycode < keycode) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/* walks the combos containing keycode in combo order, starting from combo_cursor() */
+static uint16_t combo_cursor(uint16_t keycode) { return combo_index ? find_combo_index(keycode) : 0; }
+
+static int8_t combo_key_bit(const combo_t *combo, uint16_t keycode);
+
+static bool next_combo_with_key(uint16_t keycode, uint16_t *cursor, uint16_t *index) {
+    if (combo_index) {
+        if (*cursor < combo_index_size && combo_index[*cursor].keycode == keycode) {
+            *index = combo_index[(*cursor)++].combo_index;
+            return true;
+        }
+        return false;
+    }
+    if (!(COMBO_FILTER_BYTE(keycode) & COMBO_FILTER_BIT(keycode))) {
+        return false;
+    }
+    while (*cursor < combo_count()) {
+        *index = (*cursor)++;
+        if (combo_key_bit(&key_combos[*index], keycode) >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint8_t combo_length(const combo_t *combo) {
+    uint8_t length = 0;
+    while (COMBO_END != pgm_read_word(&combo->keys[length])) {
+        length++;
+    }
+    return length;
+}
+
+/* bit of keycode in the combo state, -1 if it is not part of the combo */
+static int8_t combo_key_bit(const combo_t *combo, uint16_t keycode) {
+    int8_t bit = -1;
+    for (uint8_t i = 0;; i++) {
+        uint16_t key = pgm_read_word(&combo->keys[i]);
+        if (COMBO_END == key) break;
+        if (keycode == key) bit = i;
+    }
+    return bit;
+}
+
+static uint8_t count_bits(uint32_t bits) {
+    uint8_t count = 0;
+    for (; bits; bits &= bits - 1) {
+        count++;
+    }
+    return count;
+}
 
 static inline void send_combo(uint16_t action, bool pressed) {
     if (action) {
@@ -51,81 +216,200 @@ static inline void send_combo(uint16_t action, bool pressed) {
     }
 }
 
-static inline void dump_key_buffer(bool emit) {
-    if (buffer_size == 0) {
-        return;
-    }
-
-    if (emit) {
-        for (uint8_t i = 0; i < buffer_size; i++) {
-#ifdef COMBO_ALLOW_ACTION_KEYS
-            const action_t action = store_or_get_action(key_buffer[i].event.pressed, key_buffer[i].event.key);
-            process_action(&(key_buffer[i]), action);
-#else
-            register_code16(key_buffer[i]);
-            send_keyboard_report();
-#endif
+static void set_key_state(uint16_t keycode, bool down) {
+    uint16_t cursor = combo_cursor(keycode), index;
+    while (next_combo_with_key(keycode, &cursor, &index)) {
+        combo_t *combo = &key_combos[index];
+        uint32_t bit   = COMBO_KEY_BIT(combo_key_bit(combo, keycode));
+        if (down) {
+            combo->state |= bit;
+        } else {
+            combo->state &= ~bit;
         }
     }
+}
+
+static void push_key(uint16_t keycode, keyrecord_t *record) {
+    key_buffer[buffer_size]      = *record;
+    buffer_keycodes[buffer_size] = keycode;
+    buffer_size++;
+    set_key_state(keycode, true);
+    timer = timer_read();
+}
 
+static void clear_buffer(void) {
+    for (uint8_t i = 0; i < buffer_size; i++) {
+        set_key_state(buffer_keycodes[i], false);
+    }
     buffer_size = 0;
 }
 
-#define ALL_COMBO_KEYS_ARE_DOWN (((1 << count) - 1) == combo->state)
-#define KEY_STATE_DOWN(key)         \
-    do {                            \
-        combo->state |= (1 << key); \
-    } while (0)
-#define KEY_STATE_UP(key)            \
-    do {                             \
-        combo->state &= ~(1 << key); \
-    } while (0)
-
-static bool process_single_combo(combo_t *combo, uint16_t keycode, keyrecord_t *record) {
-    uint8_t  count = 0;
-    uint16_t index = -1;
-    /* Find index of keycode and number of combo keys */
-    for (const uint16_t *keys = combo->keys;; ++count) {
-        uint16_t key = pgm_read_word(&keys[count]);
-        if (keycode == key) index = count;
-        if (COMBO_END == key) break;
+/* the buffered keys did not make a combo, send them on in order */
+static void replay_buffer(void) {
+    for (uint8_t i = 0; i < buffer_size; i++) {
+        const action_t action = store_or_get_action(true, key_buffer[i].event.key);
+        process_action(&key_buffer[i], action);
     }
+    clear_buffer();
+}
 
-    /* Continue processing if not a combo key */
-    if (-1 == (int8_t)index) return false;
+static void fire_combo(uint16_t index) {
+    current_combo_index = index;
+    send_combo(key_combos[index].keycode, true);
 
-    bool is_combo_active = is_active;
+    if (active_count < MAX_COMBO_LENGTH) {
+        active_combos[active_count++] = (active_combo_t){.combo_index = index, .keys_down = key_combos[index].state};
+    } else {
+        // no room to wait for its keys to be released
+        send_combo(key_combos[index].keycode, false);
+    }
+    clear_buffer();
+}
 
-    if (record->event.pressed) {
-        KEY_STATE_DOWN(index);
+static bool is_candidate(const combo_t *combo) { return count_bits(combo->state) == buffer_size; }
 
-        if (is_combo_active) {
-            if (ALL_COMBO_KEYS_ARE_DOWN) { /* Combo was pressed */
-                send_combo(combo->keycode, true);
-                drop_buffer = true;
+/* walks the candidates in combo order, starting from combo_cursor(buffer_keycodes[0]) */
+static bool next_candidate(uint16_t *cursor, uint16_t *index) {
+    if (combo_index) {
+        while (next_combo_with_key(buffer_keycodes[0], cursor, index)) {
+            if (is_candidate(&key_combos[*index])) {
+                return true;
             }
         }
+        return false;
+    }
+    // only candidates have a bit set for every buffered key, no key list needs to be read
+    while (*cursor < combo_count()) {
+        *index = (*cursor)++;
+        if (key_combos[*index].state && is_candidate(&key_combos[*index])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool has_candidates(void) {
+    uint16_t cursor = combo_cursor(buffer_keycodes[0]), index;
+    return next_candidate(&cursor, &index);
+}
+
+/* Fires the longest combo made of the buffered keys once no longer candidate
+ * can still be completed within its term, or replays the keys if there is no
+ * such combo. With interrupted set no more keys can join the buffer. */
+static void resolve_buffer(bool interrupted) {
+    uint16_t best        = 0;
+    uint8_t  best_length = 0;
+    bool     waiting     = false;
+    uint16_t elapsed     = timer_elapsed(timer);
+
+    buffer_term = 0;
+    uint16_t cursor = combo_cursor(buffer_keycodes[0]), index;
+    while (next_candidate(&cursor, &index)) {
+        combo_t *combo  = &key_combos[index];
+        uint8_t  length = combo_length(combo);
+        if (combo->state == COMBO_KEY_BIT(length) - 1) {
+            if (length > best_length) {
+                best        = index;
+                best_length = length;
+            }
+        } else if (!interrupted) {
+            uint16_t term = COMBO_TERM_OF(index);
+            if (elapsed <= term) {
+                waiting = true;
+                if (term > buffer_term) {
+                    buffer_term = term;
+                }
+            }
+        }
+    }
+
+    if (waiting) {
+        return;
+    }
+    if (best_length) {
+        fire_combo(best);
     } else {
-        if (ALL_COMBO_KEYS_ARE_DOWN) { /* Combo was released */
-            send_combo(combo->keycode, false);
-        } else {
-            /* continue processing without immediately returning */
-            is_combo_active = false;
+        if (!interrupted) {
+            /* Timed out: the keys are handled by the next processors in the
+             * chain until every combo key is released */
+            is_active = false;
         }
+        replay_buffer();
+    }
+}
 
-        KEY_STATE_UP(index);
+static bool release_active_combo(uint16_t keycode) {
+    for (uint8_t i = 0; i < active_count; i++) {
+        active_combo_t *active = &active_combos[i];
+        int8_t          bit    = combo_key_bit(&key_combos[active->combo_index], keycode);
+        if (bit < 0 || !(active->keys_down & COMBO_KEY_BIT(bit))) {
+            continue;
+        }
+
+        // the combo is released with its first key
+        if (!active->released) {
+            current_combo_index = active->combo_index;
+            send_combo(key_combos[active->combo_index].keycode, false);
+            active->released = true;
+        }
+        active->keys_down &= ~COMBO_KEY_BIT(bit);
+        if (!active->keys_down) {
+            active_combos[i] = active_combos[--active_count];
+        }
+        return true;
     }
+    return false;
+}
 
-    return is_combo_active;
+static bool is_buffered(uint16_t keycode) {
+    for (uint8_t i = 0; i < buffer_size; i++) {
+        if (buffer_keycodes[i] == keycode) {
+            return true;
+        }
+    }
+    return false;
 }
 
-#define NO_COMBO_KEYS_ARE_DOWN (0 == combo->state)
+static bool process_combo_press(uint16_t keycode, keyrecord_t *record) {
+    if (!is_active) {
+        return true;
+    }
 
-bool process_combo(uint16_t keycode, keyrecord_t *record) {
-    bool is_combo_key          = false;
-    drop_buffer                = false;
-    bool no_combo_keys_pressed = true;
+    if (buffer_size) {
+        if (buffer_size < MAX_COMBO_LENGTH && !is_buffered(keycode)) {
+            push_key(keycode, record);
+            if (has_candidates()) {
+                resolve_buffer(false);
+                return false;
+            }
+            // the key completes no candidate, it starts over once the others are resolved
+            buffer_size--;
+            set_key_state(keycode, false);
+        }
+        resolve_buffer(true);
+    }
+
+    push_key(keycode, record);
+    resolve_buffer(false);
+    return false;
+}
+
+static bool process_combo_release(uint16_t keycode) {
+    if (is_buffered(keycode)) {
+        resolve_buffer(true);
+    }
+    bool consumed = release_active_combo(keycode);
 
+    if (combo_keys_held) {
+        combo_keys_held--;
+    }
+    if (!combo_keys_held) {
+        is_active = true;
+    }
+    return !consumed;
+}
+
+bool process_combo(uint16_t keycode, keyrecord_t *record) {
     if (keycode == CMB_ON && record->event.pressed) {
         combo_enable();
         return true;
@@ -144,62 +428,36 @@ bool process_combo(uint16_t keycode, keyrecord_t *record) {
     if (!is_combo_enabled()) {
         return true;
     }
-#ifndef COMBO_VARIABLE_LEN
-    for (current_combo_index = 0; current_combo_index < COMBO_COUNT; ++current_combo_index) {
-#else
-    for (current_combo_index = 0; current_combo_index < COMBO_LEN; ++current_combo_index) {
-#endif
-        combo_t *combo = &key_combos[current_combo_index];
-        is_combo_key |= process_single_combo(combo, keycode, record);
-        no_combo_keys_pressed = no_combo_keys_pressed && NO_COMBO_KEYS_ARE_DOWN;
-    }
-
-    if (drop_buffer) {
-        /* buffer is only dropped when we complete a combo, so we refresh the timer
-         * here */
-        timer = timer_read();
-        dump_key_buffer(false);
-    } else if (!is_combo_key) {
-        /* if no combos claim the key we need to emit the keybuffer */
-        dump_key_buffer(true);
-
-        // reset state if there are no combo keys pressed at all
-        if (no_combo_keys_pressed) {
-            timer     = 0;
-            is_active = true;
-        }
-    } else if (record->event.pressed && is_active) {
-        /* otherwise the key is consumed and placed in the buffer */
-        timer = timer_read();
-
-        if (buffer_size < MAX_COMBO_LENGTH) {
-#ifdef COMBO_ALLOW_ACTION_KEYS
-            key_buffer[buffer_size++] = *record;
-#else
-            key_buffer[buffer_size++] = keycode;
-#endif
+
+    uint16_t cursor = combo_cursor(keycode), index;
+    if (!next_combo_with_key(keycode, &cursor, &index)) {
+        // any other key ends the wait for a longer combo
+        if (buffer_size) {
+            resolve_buffer(true);
         }
+        return true;
     }
 
-    return !is_combo_key;
+    if (record->event.pressed) {
+        combo_keys_held++;
+        return process_combo_press(keycode, record);
+    }
+    return process_combo_release(keycode);
 }
 
+void combo_init(void) { build_combo_index(); }
+
 void matrix_scan_combo(void) {
-    if (b_combo_enable && is_active && timer && timer_elapsed(timer) > COMBO_TERM) {
-        /* This disables the combo, meaning key events for this
-         * combo will be handled by the next processors in the chain
-         */
-        is_active = false;
-        dump_key_buffer(true);
+    if (b_combo_enable && buffer_size && timer_elapsed(timer) > buffer_term) {
+        resolve_buffer(false);
     }
 }
 
 void combo_enable(void) { b_combo_enable = true; }
 
 void combo_disable(void) {
-    b_combo_enable = is_active = false;
-    timer                      = 0;
-    dump_key_buffer(true);
+    b_combo_enable = false;
+    replay_buffer();
 }
 
 void combo_toggle(void) {
@@ -53,9 +53,13 @@ typedef struct {
 #    define COMBO_TERM TAPPING_TERM
 #endif
 
+void combo_init(void);
 bool process_combo(uint16_t keycode, keyrecord_t *record);
 void matrix_scan_combo(void);
 void process_combo_event(uint16_t combo_index, bool pressed);
+#ifdef COMBO_TERM_PER_COMBO
+uint16_t get_combo_term(uint16_t combo_index, combo_t *combo);
+#endif
 
 void combo_enable(void);
 void combo_disable(void);
@@ -142,6 +142,14 @@ void reset_keyboard(void) {
 #endif
 #ifdef HAPTIC_ENABLE
     haptic_shutdown();
+#endif
+#ifdef SEND_STRING_ASYNC
+    // finish strings that are still queued, so no key is left down
+    send_string_flush();
+#endif
+#if defined(DYNAMIC_KEYMAP_ENABLE) && defined(DYNAMIC_KEYMAP_RAM_CACHE)
+    // don't lose keymap edits that are still waiting to be written back
+    dynamic_keymap_flush();
 #endif
     bootloader_jump();
 }
@@ -380,6 +388,9 @@ void matrix_init_quantum() {
 #if defined(BLUETOOTH_ENABLE) && defined(OUTPUT_AUTO_ENABLE)
     set_output(OUTPUT_AUTO);
 #endif
+#ifdef COMBO_ENABLE
+    combo_init();
+#endif
 
     matrix_init_kb();
 }
@@ -444,6 +455,14 @@ void matrix_scan_quantum() {
     autoshift_matrix_scan();
 #endif
 
+#if defined(DYNAMIC_KEYMAP_ENABLE) && defined(DYNAMIC_KEYMAP_RAM_CACHE)
+    dynamic_keymap_task();
+#endif
+
+#ifdef SEND_STRING_ASYNC
+    send_string_task();
+#endif
+
     matrix_scan_kb();
 }
 
@@ -33,7 +33,12 @@ const point_t k_rgb_matrix_center = RGB_MATRIX_CENTER;
 
 __attribute__((weak)) RGB rgb_matrix_hsv_to_rgb(HSV hsv) { return hsv_to_rgb(hsv); }
 
+// Distance and angle of each LED from the center, filled in by rgb_matrix_init()
+// so that effects don't have to redo the sqrt16()/atan2_8() every frame.
+led_geometry_t g_led_geometry[DRIVER_LED_TOTAL];
+
 // Generic effect runners
+#include "rgb_matrix_runners/effect_runner_angle_dist.h"
 #include "rgb_matrix_runners/effect_runner_dx_dy_dist.h"
 #include "rgb_matrix_runners/effect_runner_dx_dy.h"
 #include "rgb_matrix_runners/effect_runner_i.h"
@@ -184,10 +189,27 @@ void rgb_matrix_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
 
 void rgb_matrix_set_color_all(uint8_t red, uint8_t green, uint8_t blue) { rgb_matrix_driver.set_color_all(red, green, blue); }
 
+#ifdef RGB_MATRIX_SPLIT_HITS
+// on the slave only count is used, as the number of hits processed so far
+static rgb_matrix_split_hits_t split_hits;
+
+// The slave processes its own keys, so it is only sent those of the master's half
+static void rgb_matrix_record_split_hit(uint8_t row, uint8_t col, bool pressed) {
+    if ((row < MATRIX_ROWS / 2) != is_keyboard_left()) return;
+
+    memmove(&split_hits.hits[0], &split_hits.hits[1], sizeof(split_hits.hits) - sizeof(split_hits.hits[0]));
+    split_hits.hits[RGB_MATRIX_SPLIT_HITS - 1] = (rgb_matrix_split_hit_t){.row = row, .pressed = pressed, .col = col};
+    split_hits.count++;
+}
+#endif  // RGB_MATRIX_SPLIT_HITS
+
 void process_rgb_matrix(uint8_t row, uint8_t col, bool pressed) {
 #ifndef RGB_MATRIX_SPLIT
     if (!is_keyboard_master()) return;
 #endif
+#ifdef RGB_MATRIX_SPLIT_HITS
+    if (is_keyboard_master()) rgb_matrix_record_split_hit(row, col, pressed);
+#endif  // RGB_MATRIX_SPLIT_HITS
 #if RGB_DISABLE_TIMEOUT > 0
     rgb_anykey_timer = 0;
 #endif  // RGB_DISABLE_TIMEOUT > 0
@@ -447,8 +469,19 @@ __attribute__((weak)) void rgb_matrix_indicators_advanced_kb(uint8_t led_min, ui
 
 __attribute__((weak)) void rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max) {}
 
+// Call again if g_led_config.point is changed at runtime
+void rgb_matrix_update_geometry(void) {
+    for (uint8_t i = 0; i < DRIVER_LED_TOTAL; i++) {
+        int16_t dx              = g_led_config.point[i].x - k_rgb_matrix_center.x;
+        int16_t dy              = g_led_config.point[i].y - k_rgb_matrix_center.y;
+        g_led_geometry[i].dist  = sqrt16(dx * dx + dy * dy);
+        g_led_geometry[i].angle = atan2_8(dy, dx);
+    }
+}
+
 void rgb_matrix_init(void) {
     rgb_matrix_driver.init();
+    rgb_matrix_update_geometry();
 
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
     g_last_hit_tracker.count = 0;
@@ -621,3 +654,39 @@ void rgb_matrix_decrease_speed(void) { rgb_matrix_decrease_speed_helper(true); }
 led_flags_t rgb_matrix_get_flags(void) { return rgb_effect_params.flags; }
 
 void rgb_matrix_set_flags(led_flags_t flags) { rgb_effect_params.flags = flags; }
+
+#ifdef RGB_MATRIX_SPLIT
+/* for split keyboard master side */
+void rgb_matrix_get_syncinfo(rgb_matrix_syncinfo_t *syncinfo) {
+    syncinfo->config    = rgb_matrix_config;
+    syncinfo->flags     = rgb_effect_params.flags;
+    syncinfo->suspended = g_suspend_state;
+}
+
+/* for split keyboard slave side */
+void rgb_matrix_update_sync(const rgb_matrix_syncinfo_t *syncinfo) {
+    if (syncinfo->config.enable != rgb_matrix_config.enable || syncinfo->config.mode != rgb_matrix_config.mode) {
+        rgb_task_state = STARTING;
+    }
+    rgb_matrix_config       = syncinfo->config;
+    rgb_effect_params.flags = syncinfo->flags;
+    if (syncinfo->suspended != g_suspend_state) {
+        rgb_matrix_set_suspend_state(syncinfo->suspended);
+    }
+}
+
+#    ifdef RGB_MATRIX_SPLIT_HITS
+void rgb_matrix_get_split_hits(rgb_matrix_split_hits_t *hits) { *hits = split_hits; }
+
+void rgb_matrix_update_split_hits(const rgb_matrix_split_hits_t *hits) {
+    uint8_t new_hits = hits->count - split_hits.count;
+    // more than fit means the halves lost track of each other, e.g. the master was reset
+    if (new_hits <= RGB_MATRIX_SPLIT_HITS) {
+        for (uint8_t i = RGB_MATRIX_SPLIT_HITS - new_hits; i < RGB_MATRIX_SPLIT_HITS; i++) {
+            process_rgb_matrix(hits->hits[i].row, hits->hits[i].col, hits->hits[i].pressed);
+        }
+    }
+    split_hits.count = hits->count;
+}
+#    endif  // RGB_MATRIX_SPLIT_HITS
+#endif      // RGB_MATRIX_SPLIT
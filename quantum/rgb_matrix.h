@@ -113,6 +113,7 @@ void rgb_matrix_indicators_advanced_kb(uint8_t led_min, uint8_t led_max);
 void rgb_matrix_indicators_advanced_user(uint8_t led_min, uint8_t led_max);
 
 void rgb_matrix_init(void);
+void rgb_matrix_update_geometry(void);
 
 void        rgb_matrix_set_suspend_state(bool state);
 bool        rgb_matrix_get_suspend_state(void);
@@ -158,6 +159,43 @@ void        rgb_matrix_decrease_speed_noeeprom(void);
 led_flags_t rgb_matrix_get_flags(void);
 void        rgb_matrix_set_flags(led_flags_t flags);
 
+#ifdef RGB_MATRIX_SPLIT
+// With SPLIT_TRANSPORT_MIRROR the slave scans the master's keys itself
+#    if !defined(SPLIT_TRANSPORT_MIRROR) && !defined(RGB_MATRIX_SPLIT_HITS)
+#        define RGB_MATRIX_SPLIT_HITS 4
+#    endif
+
+typedef struct PACKED {
+    rgb_config_t config;
+    led_flags_t  flags;
+    bool         suspended;
+} rgb_matrix_syncinfo_t;
+
+#    ifdef RGB_MATRIX_SPLIT_HITS
+typedef struct PACKED {
+    uint8_t row : 7;
+    bool    pressed : 1;
+    uint8_t col;
+} rgb_matrix_split_hit_t;
+
+// The last RGB_MATRIX_SPLIT_HITS switch events on the master's half, oldest
+// first, and how many there have been so far.
+typedef struct PACKED {
+    uint8_t                count;
+    rgb_matrix_split_hit_t hits[RGB_MATRIX_SPLIT_HITS];
+} rgb_matrix_split_hits_t;
+#    endif
+
+/* for split keyboard master side */
+void rgb_matrix_get_syncinfo(rgb_matrix_syncinfo_t *syncinfo);
+/* for split keyboard slave side, only acts on what has changed */
+void rgb_matrix_update_sync(const rgb_matrix_syncinfo_t *syncinfo);
+#    ifdef RGB_MATRIX_SPLIT_HITS
+void rgb_matrix_get_split_hits(rgb_matrix_split_hits_t *hits);
+void rgb_matrix_update_split_hits(const rgb_matrix_split_hits_t *hits);
+#    endif
+#endif
+
 #ifndef RGBLIGHT_ENABLE
 #    define eeconfig_update_rgblight_current eeconfig_update_rgb_matrix
 #    define rgblight_toggle rgb_matrix_toggle
@@ -216,9 +254,10 @@ extern const rgb_matrix_driver_t rgb_matrix_driver;
 
 extern rgb_config_t rgb_matrix_config;
 
-extern bool         g_suspend_state;
-extern uint32_t     g_rgb_timer;
-extern led_config_t g_led_config;
+extern bool           g_suspend_state;
+extern uint32_t       g_rgb_timer;
+extern led_config_t   g_led_config;
+extern led_geometry_t g_led_geometry[DRIVER_LED_TOTAL];
 #ifdef RGB_MATRIX_KEYREACTIVE_ENABLED
 extern last_hit_t g_last_hit_tracker;
 #endif
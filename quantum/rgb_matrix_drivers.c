@@ -27,6 +27,39 @@
 
 #    include "i2c_master.h"
 
+#    if defined(ISSI_ASYNC_FLUSH) && defined(PROTOCOL_CHIBIOS)
+#        include <ch.h>
+
+#        ifndef ISSI_ASYNC_FLUSH_STACK
+#            define ISSI_ASYNC_FLUSH_STACK 256
+#        endif
+
+static void flush(void);
+
+static THD_WORKING_AREA(waIssiFlushThread, ISSI_ASYNC_FLUSH_STACK);
+static binary_semaphore_t issi_flush_sem;
+
+// Runs above the main thread, so taking a driver's dirty blocks never
+// interleaves with set_color(); the main thread only gets to run again
+// while the I2C transfers are in progress.
+static THD_FUNCTION(IssiFlushThread, arg) {
+    (void)arg;
+    chRegSetThreadName("issi_flush");
+    while (true) {
+        chBSemWait(&issi_flush_sem);
+        flush();
+    }
+}
+
+// Requests coalesce while a flush is in progress, the next one picks up
+// everything that changed in the meantime.
+static void flush_async(void) { chBSemSignal(&issi_flush_sem); }
+
+#        define ISSI_FLUSH flush_async
+#    else
+#        define ISSI_FLUSH flush
+#    endif
+
 static void init(void) {
     i2c_init();
 #    ifdef IS31FL3731
@@ -80,6 +113,10 @@ static void init(void) {
 #    else
     IS31FL3741_update_led_control_registers(DRIVER_ADDR_1, 0);
 #    endif
+#    if defined(ISSI_ASYNC_FLUSH) && defined(PROTOCOL_CHIBIOS)
+    chBSemObjectInit(&issi_flush_sem, true);
+    chThdCreateStatic(waIssiFlushThread, sizeof(waIssiFlushThread), NORMALPRIO + 1, IssiFlushThread, NULL);
+#    endif
 }
 
 #    ifdef IS31FL3731
@@ -98,7 +135,7 @@ static void flush(void) {
 
 const rgb_matrix_driver_t rgb_matrix_driver = {
     .init          = init,
-    .flush         = flush,
+    .flush         = ISSI_FLUSH,
     .set_color     = IS31FL3731_set_color,
     .set_color_all = IS31FL3731_set_color_all,
 };
@@ -110,7 +147,7 @@ static void flush(void) {
 
 const rgb_matrix_driver_t rgb_matrix_driver = {
     .init = init,
-    .flush = flush,
+    .flush = ISSI_FLUSH,
     .set_color = IS31FL3733_set_color,
     .set_color_all = IS31FL3733_set_color_all,
 };
@@ -119,7 +156,7 @@ static void flush(void) { IS31FL3737_update_pwm_buffers(DRIVER_ADDR_1, DRIVER_AD
 
 const rgb_matrix_driver_t rgb_matrix_driver = {
     .init = init,
-    .flush = flush,
+    .flush = ISSI_FLUSH,
     .set_color = IS31FL3737_set_color,
     .set_color_all = IS31FL3737_set_color_all,
 };
@@ -128,7 +165,7 @@ static void flush(void) { IS31FL3741_update_pwm_buffers(DRIVER_ADDR_1, DRIVER_AD
 
 const rgb_matrix_driver_t rgb_matrix_driver = {
     .init = init,
-    .flush = flush,
+    .flush = ISSI_FLUSH,
     .set_color = IS31FL3741_set_color,
     .set_color_all = IS31FL3741_set_color_all,
 };
@@ -82,6 +82,12 @@ typedef struct PACKED {
     uint8_t flags[DRIVER_LED_TOTAL];
 } led_config_t;
 
+// Position of an LED relative to k_rgb_matrix_center
+typedef struct PACKED {
+    uint8_t dist;
+    uint8_t angle;
+} led_geometry_t;
+
 typedef union {
     uint32_t raw;
     struct PACKED {
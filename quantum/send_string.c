@@ -134,11 +134,216 @@ __attribute__((weak)) const uint8_t ascii_to_keycode_lut[128] PROGMEM = {
 // Note: we bit-pack in "reverse" order to optimize loading
 #define PGM_LOADBIT(mem, pos) ((pgm_read_byte(&((mem)[(pos) / 8])) >> ((pos) % 8)) & 0x01)
 
+#ifdef SEND_STRING_ASYNC
+#    ifndef SEND_STRING_QUEUE_SIZE
+#        define SEND_STRING_QUEUE_SIZE 4
+#    endif
+
+#    ifndef TAP_CODE_DELAY
+#        define TAP_CODE_DELAY 0
+#    endif
+#    ifndef TAP_HOLD_CAPS_DELAY
+#        define TAP_HOLD_CAPS_DELAY 80
+#    endif
+
+/* Queued strings are expanded one character at a time into a short list of
+ * steps, each of which changes the report at most once. send_string_task()
+ * runs one step per scan, so matrix scanning carries on while they play.
+ */
+typedef struct {
+    const char *         str;
+    send_string_reader_t reader;
+    uint8_t              interval;
+    bool                 implicit_prefix;
+} send_string_job_t;
+
+enum send_string_action {
+    SS_ACTION_NONE,
+    SS_ACTION_DOWN,
+    SS_ACTION_UP,
+};
+
+typedef struct {
+    uint8_t  action;
+    uint8_t  keycode;
+    uint16_t delay;  // time to wait before the next step
+} send_string_step_t;
+
+// A shifted, AltGr'd dead key takes the most steps
+#    define SEND_STRING_MAX_STEPS 8
+
+static send_string_job_t  ss_jobs[SEND_STRING_QUEUE_SIZE];
+static uint8_t            ss_job_head  = 0;
+static uint8_t            ss_job_count = 0;
+static send_string_step_t ss_steps[SEND_STRING_MAX_STEPS];
+static uint8_t            ss_step_index = 0;
+static uint8_t            ss_step_count = 0;
+static uint16_t           ss_timer      = 0;
+static uint16_t           ss_delay      = 0;
+
+static char send_string_read_P(const char *str) { return pgm_read_byte(str); }
+
+static void send_string_add_step(uint8_t action, uint8_t keycode, uint16_t delay) { ss_steps[ss_step_count++] = (send_string_step_t){action, keycode, delay}; }
+
+static void send_string_add_tap(uint8_t keycode) {
+    send_string_add_step(SS_ACTION_DOWN, keycode, keycode == KC_CAPS ? TAP_HOLD_CAPS_DELAY : TAP_CODE_DELAY);
+    send_string_add_step(SS_ACTION_UP, keycode, 0);
+}
+
+// Same as send_char(), as steps
+static void send_string_add_char(char ascii_code) {
+#    if defined(AUDIO_ENABLE) && defined(SENDSTRING_BELL)
+    if (ascii_code == '\a') {  // BEL
+        PLAY_SONG(bell_song);
+        return;
+    }
+#    endif
+
+    uint8_t keycode    = pgm_read_byte(&ascii_to_keycode_lut[(uint8_t)ascii_code]);
+    bool    is_shifted = PGM_LOADBIT(ascii_to_shift_lut, (uint8_t)ascii_code);
+    bool    is_altgred = PGM_LOADBIT(ascii_to_altgr_lut, (uint8_t)ascii_code);
+    bool    is_dead    = PGM_LOADBIT(ascii_to_dead_lut, (uint8_t)ascii_code);
+
+    if (is_shifted) {
+        send_string_add_step(SS_ACTION_DOWN, KC_LSFT, 0);
+    }
+    if (is_altgred) {
+        send_string_add_step(SS_ACTION_DOWN, KC_RALT, 0);
+    }
+    send_string_add_tap(keycode);
+    if (is_altgred) {
+        send_string_add_step(SS_ACTION_UP, KC_RALT, 0);
+    }
+    if (is_shifted) {
+        send_string_add_step(SS_ACTION_UP, KC_LSFT, 0);
+    }
+    if (is_dead) {
+        send_string_add_tap(KC_SPACE);
+    }
+}
+
+static void send_string_next_job(void) {
+    ss_job_head = (ss_job_head + 1) % SEND_STRING_QUEUE_SIZE;
+    ss_job_count--;
+}
+
+// Expands the next character of the queued strings, returns false once they are all sent
+static bool send_string_load_steps(void) {
+    ss_step_index = 0;
+    ss_step_count = 0;
+    while (ss_job_count) {
+        send_string_job_t *job        = &ss_jobs[ss_job_head];
+        char               ascii_code = job->reader(job->str);
+        if (!ascii_code) {
+            send_string_next_job();
+            continue;
+        }
+
+        bool is_code = job->implicit_prefix ? (ascii_code == SS_TAP_CODE || ascii_code == SS_DOWN_CODE || ascii_code == SS_UP_CODE) : ascii_code == SS_QMK_PREFIX;
+        if (is_code) {
+            if (!job->implicit_prefix) {
+                ascii_code = job->reader(++job->str);
+            }
+            if (ascii_code == SS_DELAY_CODE) {
+                uint32_t ms    = 0;
+                char     digit = job->reader(++job->str);
+                while (isdigit(digit)) {
+                    ms    = ms * 10 + digit - '0';
+                    digit = job->reader(++job->str);
+                }
+                // leave room for the interval
+                send_string_add_step(SS_ACTION_NONE, KC_NO, ms < UINT16_MAX - UINT8_MAX ? ms : UINT16_MAX - UINT8_MAX);
+            } else {
+                uint8_t keycode = job->reader(++job->str);
+                if (!keycode) {
+                    // truncated string, drop what is left of it
+                    continue;
+                }
+                if (ascii_code == SS_TAP_CODE) {
+                    send_string_add_tap(keycode);
+                } else if (ascii_code == SS_DOWN_CODE) {
+                    send_string_add_step(SS_ACTION_DOWN, keycode, 0);
+                } else if (ascii_code == SS_UP_CODE) {
+                    send_string_add_step(SS_ACTION_UP, keycode, 0);
+                }
+            }
+        } else {
+            send_string_add_char(ascii_code);
+        }
+        ++job->str;
+
+        uint8_t interval = job->interval;
+        if (!job->reader(job->str)) {
+            // done with this string, so send_string_is_active() knows once the last step is out
+            send_string_next_job();
+        }
+        if (ss_step_count) {
+            ss_steps[ss_step_count - 1].delay += interval;
+            return true;
+        }
+    }
+    return false;
+}
+
+/** \brief Queues a string to be sent by send_string_task()
+ *
+ * \param str The string, which must stay valid until it has been sent.
+ * \param reader Reads a character of the string, e.g. from PROGMEM.
+ * \param interval The time in milliseconds to wait after each character.
+ * \param implicit_prefix Whether tap, down and up codes appear without SS_QMK_PREFIX, as in dynamic keymap macros.
+ */
+void send_string_async(const char *str, send_string_reader_t reader, uint8_t interval, bool implicit_prefix) {
+    // the queue is full, make room by sending the oldest string now
+    while (ss_job_count == SEND_STRING_QUEUE_SIZE) {
+        send_string_task();
+        wait_ms(1);
+    }
+    ss_jobs[(ss_job_head + ss_job_count) % SEND_STRING_QUEUE_SIZE] = (send_string_job_t){str, reader, interval, implicit_prefix};
+    ss_job_count++;
+}
+
+bool send_string_is_active(void) { return ss_job_count || ss_step_index != ss_step_count; }
+
+/** \brief Sends all queued strings before returning
+ */
+void send_string_flush(void) {
+    while (send_string_is_active() || timer_elapsed(ss_timer) < ss_delay) {
+        if (timer_elapsed(ss_timer) < ss_delay) {
+            wait_ms(1);
+        } else {
+            send_string_task();
+        }
+    }
+}
+
+void send_string_task(void) {
+    if (timer_elapsed(ss_timer) < ss_delay) {
+        return;
+    }
+    if (ss_step_index == ss_step_count && !send_string_load_steps()) {
+        return;
+    }
+
+    send_string_step_t *step = &ss_steps[ss_step_index++];
+    if (step->action == SS_ACTION_DOWN) {
+        register_code(step->keycode);
+    } else if (step->action == SS_ACTION_UP) {
+        unregister_code(step->keycode);
+    }
+    ss_timer = timer_read();
+    ss_delay = step->delay;
+}
+#endif
+
 void send_string(const char *str) { send_string_with_delay(str, 0); }
 
 void send_string_P(const char *str) { send_string_with_delay_P(str, 0); }
 
 void send_string_with_delay(const char *str, uint8_t interval) {
+#ifdef SEND_STRING_ASYNC
+    // strings in RAM may not outlive the call, so these are sent straight away
+    send_string_flush();
+#endif
     while (1) {
         char ascii_code = *str;
         if (!ascii_code) break;
@@ -180,6 +385,9 @@ void send_string_with_delay(const char *str, uint8_t interval) {
 }
 
 void send_string_with_delay_P(const char *str, uint8_t interval) {
+#ifdef SEND_STRING_ASYNC
+    send_string_async(str, send_string_read_P, interval, false);
+#else
     while (1) {
         char ascii_code = pgm_read_byte(str);
         if (!ascii_code) break;
@@ -218,9 +426,14 @@ void send_string_with_delay_P(const char *str, uint8_t interval) {
             while (ms--) wait_ms(1);
         }
     }
+#endif
 }
 
 void send_char(char ascii_code) {
+#ifdef SEND_STRING_ASYNC
+    send_string_flush();
+#endif
+
 #if defined(AUDIO_ENABLE) && defined(SENDSTRING_BELL)
     if (ascii_code == '\a') {  // BEL
         PLAY_SONG(bell_song);
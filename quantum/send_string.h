@@ -14,6 +14,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "progmem.h"
@@ -52,3 +53,13 @@ void send_byte(uint8_t number);
 void send_nibble(uint8_t number);
 
 void tap_random_base64(void);
+
+#ifdef SEND_STRING_ASYNC
+// Reads the character at the given position of a queued string
+typedef char (*send_string_reader_t)(const char *str);
+
+void send_string_async(const char *str, send_string_reader_t reader, uint8_t interval, bool implicit_prefix);
+bool send_string_is_active(void);
+void send_string_flush(void);
+void send_string_task(void);
+#endif
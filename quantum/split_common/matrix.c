@@ -19,7 +19,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "util.h"
 #include "matrix.h"
 #include "debounce.h"
+#include "task_profile.h"
 #include "quantum.h"
+#include "matrix_port_group.h"
+#include "matrix_idle.h"
 #include "split_util.h"
 #include "config.h"
 #include "transport.h"
@@ -103,11 +106,15 @@ static void unselect_rows(void) {
     }
 }
 
+// Column pins grouped by GPIO port, built from col_pins by init_pins()
+static matrix_port_group_t col_ports;
+
 static void init_pins(void) {
     unselect_rows();
     for (uint8_t x = 0; x < MATRIX_COLS; x++) {
         setPinInputHigh_atomic(col_pins[x]);
     }
+    matrix_port_group_init(&col_ports, col_pins, MATRIX_COLS);
 }
 
 static bool read_cols_on_row(matrix_row_t current_matrix[], uint8_t current_row) {
@@ -118,13 +125,18 @@ static bool read_cols_on_row(matrix_row_t current_matrix[], uint8_t current_row)
     select_row(current_row);
     matrix_output_select_delay();
 
+    // Sample every port the cols live on
+    port_data_t port_state[MATRIX_COLS];
+    matrix_port_group_read(&col_ports, port_state);
+
     // For each col...
     for (uint8_t col_index = 0; col_index < MATRIX_COLS; col_index++) {
-        // Select the col pin to read (active low)
-        uint8_t pin_state = readPin(col_pins[col_index]);
+        if (col_pins[col_index] == NO_PIN) {
+            continue;
+        }
 
-        // Populate the matrix row with the state of the col pin
-        current_row_value |= pin_state ? 0 : (MATRIX_ROW_SHIFTER << col_index);
+        // Populate the matrix row with the state of the col pin (active low)
+        current_row_value |= matrix_port_group_pin_high(&col_ports, port_state, col_index) ? 0 : (MATRIX_ROW_SHIFTER << col_index);
     }
 
     // Unselect row
@@ -141,6 +153,24 @@ static bool read_cols_on_row(matrix_row_t current_matrix[], uint8_t current_row)
     return false;
 }
 
+#        ifdef MATRIX_IDLE_TIMEOUT
+#            define IDLE_SENSE_PINS col_pins
+#            define IDLE_SENSE_COUNT MATRIX_COLS
+
+static void idle_select_all(void) {
+    for (uint8_t x = 0; x < ROWS_PER_HAND; x++) {
+        if (row_pins[x] != NO_PIN) {
+            select_row(x);
+        }
+    }
+}
+
+static void idle_unselect_all(void) { unselect_rows(); }
+
+// With every row selected, any pressed key pulls its col low
+static bool idle_sense_any(void) { return matrix_port_group_any_low(&col_ports); }
+#        endif
+
 #    elif (DIODE_DIRECTION == ROW2COL)
 
 static void select_col(uint8_t col) { setPinOutput_writeLow(col_pins[col]); }
@@ -198,6 +228,31 @@ static bool read_rows_on_col(matrix_row_t current_matrix[], uint8_t current_col)
     return matrix_changed;
 }
 
+#        ifdef MATRIX_IDLE_TIMEOUT
+#            define IDLE_SENSE_PINS row_pins
+#            define IDLE_SENSE_COUNT ROWS_PER_HAND
+
+static void idle_select_all(void) {
+    for (uint8_t x = 0; x < MATRIX_COLS; x++) {
+        if (col_pins[x] != NO_PIN) {
+            select_col(x);
+        }
+    }
+}
+
+static void idle_unselect_all(void) { unselect_cols(); }
+
+// With every col selected, any pressed key pulls its row low
+static bool idle_sense_any(void) {
+    for (uint8_t x = 0; x < ROWS_PER_HAND; x++) {
+        if (row_pins[x] != NO_PIN && readPin(row_pins[x]) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+#        endif
+
 #    else
 #        error DIODE_DIRECTION must be one of COL2ROW or ROW2COL!
 #    endif
@@ -205,6 +260,51 @@ static bool read_rows_on_col(matrix_row_t current_matrix[], uint8_t current_col)
 #    error DIODE_DIRECTION is not defined!
 #endif
 
+#if defined(MATRIX_IDLE_TIMEOUT) && !defined(DIRECT_PINS)
+/* Idle scanning, as in the standard matrix
+ *
+ * Each half only stops scanning its own keys, the transport keeps running on
+ * every matrix_scan(). The pins of the right half are in place by the time
+ * the sense pins are handed to the pin interrupts.
+ */
+static bool idle_active = false;
+
+bool matrix_is_idle(void) { return idle_active; }
+
+bool matrix_idle_enter(void) {
+    if (idle_active) {
+        return true;
+    }
+
+    // A held key keeps its sense line active, so a second key on it would go unnoticed
+    for (uint8_t i = 0; i < ROWS_PER_HAND; i++) {
+        if (raw_matrix[i] || matrix[thisHand + i]) {
+            return false;
+        }
+    }
+
+    idle_select_all();
+#    ifdef MATRIX_IDLE_IRQ
+    matrix_idle_irq_arm();
+#    endif
+    idle_active = true;
+    return true;
+}
+
+void matrix_idle_exit(void) {
+    if (!idle_active) {
+        return;
+    }
+
+#    ifdef MATRIX_IDLE_IRQ
+    matrix_idle_irq_disarm();
+#    endif
+    idle_unselect_all();
+    matrix_output_unselect_delay();  // wait for the strobe lines to go HIGH
+    idle_active = false;
+}
+#endif
+
 void matrix_init(void) {
     split_pre_init();
 
@@ -237,6 +337,9 @@ void matrix_init(void) {
 
     // initialize key pins
     init_pins();
+#if defined(MATRIX_IDLE_TIMEOUT) && defined(MATRIX_IDLE_IRQ) && !defined(DIRECT_PINS)
+    matrix_idle_irq_init(IDLE_SENSE_PINS, IDLE_SENSE_COUNT);
+#endif
 
     // initialize matrix state: all keys off
     for (uint8_t i = 0; i < MATRIX_ROWS; i++) {
@@ -257,7 +360,10 @@ bool matrix_post_scan(void) {
         static uint8_t error_count;
 
         matrix_row_t slave_matrix[ROWS_PER_HAND] = {0};
-        if (!transport_master(matrix + thisHand, slave_matrix)) {
+        TASK_PROFILE_BEGIN(TASK_PROFILE_SPLIT_TRANSPORT);
+        bool transport_ok = transport_master(matrix + thisHand, slave_matrix);
+        TASK_PROFILE_END(TASK_PROFILE_SPLIT_TRANSPORT);
+        if (!transport_ok) {
             error_count++;
 
             if (error_count > ERROR_DISCONNECT_COUNT) {
@@ -282,7 +388,9 @@ bool matrix_post_scan(void) {
 
         matrix_scan_quantum();
     } else {
+        TASK_PROFILE_BEGIN(TASK_PROFILE_SPLIT_TRANSPORT);
         transport_slave(matrix + thatHand, matrix + thisHand);
+        TASK_PROFILE_END(TASK_PROFILE_SPLIT_TRANSPORT);
 
         matrix_slave_scan_user();
     }
@@ -293,6 +401,17 @@ bool matrix_post_scan(void) {
 uint8_t matrix_scan(void) {
     bool local_changed = false;
 
+#if defined(MATRIX_IDLE_TIMEOUT) && !defined(DIRECT_PINS)
+    if (idle_active) {
+        if (!idle_sense_any()) {
+            debounce(raw_matrix, matrix + thisHand, ROWS_PER_HAND, false);
+
+            return (uint8_t)matrix_post_scan();
+        }
+        matrix_idle_exit();
+    }
+#endif
+
 #if defined(DIRECT_PINS) || (DIODE_DIRECTION == COL2ROW)
     // Set row, read cols
     for (uint8_t current_row = 0; current_row < ROWS_PER_HAND; current_row++) {
@@ -305,7 +424,15 @@ uint8_t matrix_scan(void) {
     }
 #endif
 
+    TASK_PROFILE_BEGIN(TASK_PROFILE_DEBOUNCE);
     debounce(raw_matrix, matrix + thisHand, ROWS_PER_HAND, local_changed);
+    TASK_PROFILE_END(TASK_PROFILE_DEBOUNCE);
+
+#if defined(MATRIX_IDLE_TIMEOUT) && !defined(DIRECT_PINS)
+    if (!local_changed && last_matrix_activity_elapsed() >= MATRIX_IDLE_TIMEOUT) {
+        matrix_idle_enter();
+    }
+#endif
 
     bool remote_changed = matrix_post_scan();
     return (uint8_t)(local_changed || remote_changed);
@@ -16,4 +16,17 @@
 // When using serial and RGBLIGHT_SPLIT need separate transaction
 #        define SERIAL_USE_MULTI_TRANSACTION
 #    endif
+#    if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT) && !defined(SERIAL_USE_MULTI_TRANSACTION)
+// RGB Matrix state is sent in its own transaction as well
+#        define SERIAL_USE_MULTI_TRANSACTION
+#    endif
+#    ifdef SPLIT_TRANSPORT_DELTA
+// Every channel has its own transaction
+#        ifndef SERIAL_USE_MULTI_TRANSACTION
+#            define SERIAL_USE_MULTI_TRANSACTION
+#        endif
+#        ifndef SPLIT_TRANSPORT_RESYNC_INTERVAL
+#            define SPLIT_TRANSPORT_RESYNC_INTERVAL 500
+#        endif
+#    endif
 #endif
@@ -0,0 +1,62 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Stands in for <avr/io.h> of an ATmega32U4, backed by soft_serial_sim.c
+
+#pragma once
+
+#include <stdint.h>
+
+#define __AVR_ATmega32U4__
+
+/* Only the registers of the external interrupts, timer 1 and port D exist.
+ * Each half has its own set, AVR_SIM_IO names the one of the half that is
+ * being compiled. The interrupt flags are kept by the simulation, EIFR and
+ * TIFR1 only take the ones written to clear them.
+ */
+typedef struct {
+    uint8_t  eicra, eicrb, eimsk, eifr;
+    uint8_t  tccr1a, tccr1b, timsk1, tifr1;
+    uint16_t tcnt1, ocr1a;
+    uint8_t  pind, ddrd, portd;
+} avr_sim_io_t;
+
+#ifdef AVR_SIM_IO
+extern avr_sim_io_t AVR_SIM_IO;
+#endif
+
+#define _BV(bit) (1 << (bit))
+
+#define EICRA (AVR_SIM_IO.eicra)
+#define EICRB (AVR_SIM_IO.eicrb)
+#define EIMSK (AVR_SIM_IO.eimsk)
+#define EIFR (AVR_SIM_IO.eifr)
+
+#define TCCR1A (AVR_SIM_IO.tccr1a)
+#define TCCR1B (AVR_SIM_IO.tccr1b)
+#define TCNT1 (AVR_SIM_IO.tcnt1)
+#define OCR1A (AVR_SIM_IO.ocr1a)
+#define TIMSK1 (AVR_SIM_IO.timsk1)
+#define TIFR1 (AVR_SIM_IO.tifr1)
+
+#define PIND (AVR_SIM_IO.pind)
+#define DDRD (AVR_SIM_IO.ddrd)
+#define PORTD (AVR_SIM_IO.portd)
+
+#define CS10 0
+#define WGM12 3
+#define OCIE1A 1
+#define OCF1A 1
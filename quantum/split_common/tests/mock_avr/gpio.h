@@ -0,0 +1,43 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Stands in for tmk_core/common/avr/gpio.h, backed by soft_serial_sim.c
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <avr/io.h>
+
+typedef uint8_t pin_t;
+
+// Only port D is simulated
+#define D0 0xD0
+#define D1 0xD1
+#define D2 0xD2
+#define D3 0xD3
+#define D4 0xD4
+#define D5 0xD5
+#define D6 0xD6
+#define D7 0xD7
+
+#define setPinOutput(pin) (DDRD |= _BV((pin)&0xF))
+#define setPinInputHigh(pin) (DDRD &= ~_BV((pin)&0xF), PORTD |= _BV((pin)&0xF))
+#define writePinHigh(pin) (PORTD |= _BV((pin)&0xF))
+#define writePinLow(pin) (PORTD &= ~_BV((pin)&0xF))
+#define readPin(pin) soft_serial_sim_read_pin(&AVR_SIM_IO, (pin)&0xF)
+
+bool soft_serial_sim_read_pin(const avr_sim_io_t *io, uint8_t bit);
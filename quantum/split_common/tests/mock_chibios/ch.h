@@ -0,0 +1,49 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Stands in for <ch.h>, backed by usart_sim.c
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define TRUE 1
+#define FALSE 0
+
+#define CH_CFG_ST_FREQUENCY 10000
+
+typedef uint32_t sysinterval_t;
+typedef void (*vtfunc_t)(void *par);
+
+typedef struct {
+    uint64_t deadline_us;
+    vtfunc_t func;  // NULL while the timer is not armed
+    void *   par;
+} virtual_timer_t;
+
+#define TIME_MS2I(msecs) ((sysinterval_t)(msecs)*CH_CFG_ST_FREQUENCY / 1000)
+
+void chVTObjectInit(virtual_timer_t *vtp);
+void chVTSetI(virtual_timer_t *vtp, sysinterval_t delay, vtfunc_t vtfunc, void *par);
+void chVTResetI(virtual_timer_t *vtp);
+
+// the simulation runs one callback at a time, there is nothing to lock
+#define osalSysLock()
+#define osalSysUnlock()
+#define osalSysLockFromISR()
+#define osalSysUnlockFromISR()
@@ -0,0 +1,84 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Stands in for <hal.h> with the UART driver of the STM32 LLD, backed by usart_sim.c
+
+#pragma once
+
+#include "ch.h"
+
+#define HAL_USE_UART TRUE
+
+typedef uint32_t uartflags_t;
+
+#define UART_PARITY_ERROR 4
+#define UART_FRAMING_ERROR 8
+#define UART_OVERRUN_ERROR 16
+
+typedef enum {
+    UART_TX_IDLE,
+    UART_TX_ACTIVE,
+    UART_TX_COMPLETE,
+} uarttxstate_t;
+
+typedef enum {
+    UART_RX_IDLE,
+    UART_RX_ACTIVE,
+    UART_RX_COMPLETE,
+} uartrxstate_t;
+
+typedef struct UARTDriver UARTDriver;
+
+typedef void (*uartcb_t)(UARTDriver *uartp);
+typedef void (*uartccb_t)(UARTDriver *uartp, uint16_t c);
+typedef void (*uartecb_t)(UARTDriver *uartp, uartflags_t e);
+
+typedef struct {
+    uartcb_t  txend1_cb;
+    uartcb_t  txend2_cb;
+    uartcb_t  rxend_cb;
+    uartccb_t rxchar_cb;
+    uartecb_t rxerr_cb;
+    uint32_t  speed;
+    uint16_t  cr1;
+    uint16_t  cr2;
+    uint16_t  cr3;
+} UARTConfig;
+
+struct UARTDriver {
+    uarttxstate_t     txstate;
+    uartrxstate_t     rxstate;
+    const UARTConfig *config;
+    // what the DMA streams still have to move
+    const uint8_t *txbuf;
+    size_t         txn;
+    uint8_t *      rxbuf;
+    size_t         rxn;
+};
+
+extern UARTDriver UARTD1;
+
+void   uartStart(UARTDriver *uartp, const UARTConfig *config);
+void   uartStartSendI(UARTDriver *uartp, size_t n, const void *txbuf);
+void   uartStartReceiveI(UARTDriver *uartp, size_t n, void *rxbuf);
+size_t uartStopReceiveI(UARTDriver *uartp);
+
+#define palSetLineMode(line, mode)
+#define PAL_MODE_ALTERNATE(n) 0
+#define PAL_STM32_OTYPE_PUSHPULL 0
+#define PAL_STM32_PUPDR_PULLUP 0
+
+#define USART_CR2_SWAP (1 << 15)
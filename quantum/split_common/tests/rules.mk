@@ -0,0 +1,36 @@
+SPLIT_TRANSPORT_COMMON_DEFS := -DNO_DEBUG -DSPLIT_MODS_ENABLE -DSPLIT_TRANSPORT_MIRROR -DWPM_ENABLE
+SPLIT_TRANSPORT_COMMON_INC := $(QUANTUM_PATH)/split_common/tests $(DRIVER_PATH)/avr
+
+split_transport_DEFS := $(SPLIT_TRANSPORT_COMMON_DEFS)
+split_transport_INC := $(SPLIT_TRANSPORT_COMMON_INC)
+split_transport_SRC := \
+	$(QUANTUM_PATH)/split_common/tests/transport_tests.cpp \
+	$(QUANTUM_PATH)/split_common/tests/transport_master.c \
+	$(QUANTUM_PATH)/split_common/tests/transport_slave.c \
+	$(QUANTUM_PATH)/split_common/tests/split_link_sim.c \
+	$(TMK_PATH)/common/test/timer.c
+
+split_transport_delta_DEFS := $(SPLIT_TRANSPORT_COMMON_DEFS) -DSPLIT_TRANSPORT_DELTA -DSPLIT_TRANSPORT_USER_DATA_SIZE=4
+split_transport_delta_INC := $(SPLIT_TRANSPORT_COMMON_INC)
+split_transport_delta_SRC := $(split_transport_SRC)
+
+split_transport_rgb_matrix_DEFS := -DNO_DEBUG -DSPLIT_MODS_ENABLE -DWPM_ENABLE -DRGB_MATRIX_ENABLE -DRGB_MATRIX_SPLIT -DDRIVER_LED_TOTAL=16
+split_transport_rgb_matrix_INC := $(SPLIT_TRANSPORT_COMMON_INC)
+split_transport_rgb_matrix_SRC := $(split_transport_SRC)
+
+serial_interrupt_DEFS := -DNO_DEBUG -DF_CPU=16000000 -DSOFT_SERIAL_PIN=D2 -DSERIAL_USE_MULTI_TRANSACTION
+serial_interrupt_INC := $(QUANTUM_PATH)/split_common/tests/mock_avr $(DRIVER_PATH)/avr
+serial_interrupt_SRC := \
+	$(QUANTUM_PATH)/split_common/tests/serial_interrupt_tests.cpp \
+	$(QUANTUM_PATH)/split_common/tests/serial_interrupt_master.c \
+	$(QUANTUM_PATH)/split_common/tests/serial_interrupt_slave.c \
+	$(QUANTUM_PATH)/split_common/tests/soft_serial_sim.c
+
+serial_usart_dma_DEFS := -DNO_DEBUG -DSOFT_SERIAL_PIN=0 -DSERIAL_USART_RX_PIN=1 -DSERIAL_USART_TIMEOUT=5 -DSERIAL_USART_RETRIES=3 -DSERIAL_USE_MULTI_TRANSACTION
+serial_usart_dma_INC := $(QUANTUM_PATH)/split_common/tests/mock_chibios $(DRIVER_PATH)/chibios
+serial_usart_dma_CONFIG := $(QUANTUM_PATH)/split_common/tests/config.h
+serial_usart_dma_SRC := \
+	$(QUANTUM_PATH)/split_common/tests/serial_usart_dma_tests.cpp \
+	$(QUANTUM_PATH)/split_common/tests/serial_usart_dma_master.c \
+	$(QUANTUM_PATH)/split_common/tests/serial_usart_dma_slave.c \
+	$(QUANTUM_PATH)/split_common/tests/usart_sim.c
@@ -0,0 +1,230 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "serial.h"
+#include "soft_serial_sim.h"
+
+void master_soft_serial_initiator_init(SSTD_t *sstd_table, int sstd_table_size);
+int  master_soft_serial_transaction(int sstd_index);
+void slave_soft_serial_target_init(SSTD_t *sstd_table, int sstd_table_size);
+int  slave_soft_serial_get_and_clean_status(int sstd_index);
+}
+
+// 10 bit times per byte at 16us per bit
+#define BYTE_US 160
+
+enum { GET_MATRIX, PUT_MODS, EXCHANGE, NUM_TRANSACTIONS };
+
+struct side_buffers_t {
+    uint8_t status[NUM_TRANSACTIONS];
+    uint8_t matrix[6];
+    uint8_t mods[4];
+    uint8_t exchange_out[8];
+    uint8_t exchange_in[8];
+};
+
+static side_buffers_t master;
+static side_buffers_t slave;
+
+static SSTD_t master_table[] = {
+    [GET_MATRIX] = {&master.status[GET_MATRIX], 0, NULL, sizeof(master.matrix), master.matrix},
+    [PUT_MODS]   = {&master.status[PUT_MODS], sizeof(master.mods), master.mods, 0, NULL},
+    [EXCHANGE]   = {&master.status[EXCHANGE], sizeof(master.exchange_out), master.exchange_out, sizeof(master.exchange_in), master.exchange_in},
+};
+
+static SSTD_t slave_table[] = {
+    [GET_MATRIX] = {&slave.status[GET_MATRIX], 0, NULL, sizeof(slave.matrix), slave.matrix},
+    [PUT_MODS]   = {&slave.status[PUT_MODS], sizeof(slave.mods), slave.mods, 0, NULL},
+    [EXCHANGE]   = {&slave.status[EXCHANGE], sizeof(slave.exchange_in), slave.exchange_in, sizeof(slave.exchange_out), slave.exchange_out},
+};
+
+static bool uniform(const uint8_t *data, size_t size, uint8_t value) {
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] != value) return false;
+    }
+    return true;
+}
+
+class SerialInterrupt : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        soft_serial_sim_reset();
+        master = {};
+        slave  = {};
+        master_soft_serial_initiator_init(master_table, NUM_TRANSACTIONS);
+        slave_soft_serial_target_init(slave_table, NUM_TRANSACTIONS);
+    }
+
+    // one transaction followed by the rest of a 1ms scan
+    int scan(int sstd_index) {
+        int result = master_soft_serial_transaction(sstd_index);
+        soft_serial_sim_run_us(1000);
+        return result;
+    }
+
+    void fill(uint8_t master_value, uint8_t slave_value) {
+        memset(master.mods, master_value, sizeof(master.mods));
+        memset(master.exchange_out, master_value, sizeof(master.exchange_out));
+        memset(slave.matrix, slave_value, sizeof(slave.matrix));
+        memset(slave.exchange_out, slave_value, sizeof(slave.exchange_out));
+    }
+};
+
+TEST_F(SerialInterrupt, EveryTransactionTypeCompletes) {
+    fill(0x3C, 0xC3);
+
+    EXPECT_EQ(scan(GET_MATRIX), TRANSACTION_END);
+    EXPECT_TRUE(uniform(master.matrix, sizeof(master.matrix), 0xC3));
+    EXPECT_EQ(slave_soft_serial_get_and_clean_status(GET_MATRIX), TRANSACTION_ACCEPTED);
+
+    EXPECT_EQ(scan(PUT_MODS), TRANSACTION_END);
+    EXPECT_TRUE(uniform(slave.mods, sizeof(slave.mods), 0x3C));
+    EXPECT_EQ(slave_soft_serial_get_and_clean_status(PUT_MODS), TRANSACTION_ACCEPTED);
+
+    EXPECT_EQ(scan(EXCHANGE), TRANSACTION_END);
+    EXPECT_TRUE(uniform(master.exchange_in, sizeof(master.exchange_in), 0xC3));
+    EXPECT_TRUE(uniform(slave.exchange_in, sizeof(slave.exchange_in), 0x3C));
+    EXPECT_EQ(slave_soft_serial_get_and_clean_status(EXCHANGE), TRANSACTION_ACCEPTED);
+    EXPECT_EQ(master.status[EXCHANGE], TRANSACTION_END);
+
+    EXPECT_EQ(master_soft_serial_transaction(NUM_TRANSACTIONS), TRANSACTION_TYPE_ERROR);
+    EXPECT_EQ(soft_serial_sim_stats()->contention, 0);
+    EXPECT_EQ(soft_serial_sim_stats()->flipped, 0);
+}
+
+TEST_F(SerialInterrupt, TransactionTimeFollowsFraming) {
+    fill(0x00, 0xFF);
+    uint64_t start = soft_serial_sim_now_us();
+    EXPECT_EQ(master_soft_serial_transaction(EXCHANGE), TRANSACTION_END);
+    uint64_t time = soft_serial_sim_now_us() - start;
+
+    // header, data and crc each way plus a few bit times of turnaround
+    uint64_t wire = 2 * (2 + sizeof(master.exchange_out)) * BYTE_US;
+    EXPECT_GE(time, wire);
+    EXPECT_LE(time, wire + 2 * BYTE_US);
+    fprintf(stdout, "[ STATS    ] %u byte exchange took %u us\n", (unsigned)sizeof(master.exchange_out), (unsigned)time);
+}
+
+TEST_F(SerialInterrupt, CorruptRequestIsNotAccepted) {
+    fill(0x55, 0xAA);
+    // a data bit of the first byte after the header
+    soft_serial_sim_flip_read(SOFT_SERIAL_SIM_SLAVE, 9 + 3);
+
+    EXPECT_EQ(scan(EXCHANGE), TRANSACTION_NO_RESPONSE);
+    EXPECT_EQ(slave_soft_serial_get_and_clean_status(EXCHANGE), TRANSACTION_DATA_ERROR);
+    EXPECT_TRUE(uniform(slave.exchange_in, sizeof(slave.exchange_in), 0));
+    EXPECT_TRUE(uniform(master.exchange_in, sizeof(master.exchange_in), 0));
+
+    EXPECT_EQ(scan(EXCHANGE), TRANSACTION_END);
+    EXPECT_TRUE(uniform(slave.exchange_in, sizeof(slave.exchange_in), 0x55));
+    EXPECT_EQ(soft_serial_sim_stats()->contention, 0);
+}
+
+TEST_F(SerialInterrupt, CorruptHeaderIsIgnored) {
+    fill(0x55, 0xAA);
+    soft_serial_sim_flip_read(SOFT_SERIAL_SIM_SLAVE, 2);
+
+    EXPECT_EQ(scan(PUT_MODS), TRANSACTION_NO_RESPONSE);
+    EXPECT_EQ(slave_soft_serial_get_and_clean_status(PUT_MODS), 0);
+    EXPECT_TRUE(uniform(slave.mods, sizeof(slave.mods), 0));
+
+    EXPECT_EQ(scan(PUT_MODS), TRANSACTION_END);
+    EXPECT_TRUE(uniform(slave.mods, sizeof(slave.mods), 0x55));
+}
+
+TEST_F(SerialInterrupt, BrokenStopBitDropsPacket) {
+    fill(0x55, 0xAA);
+    // stop bit of the header
+    soft_serial_sim_flip_read(SOFT_SERIAL_SIM_SLAVE, 9);
+
+    EXPECT_EQ(scan(PUT_MODS), TRANSACTION_NO_RESPONSE);
+    EXPECT_TRUE(uniform(slave.mods, sizeof(slave.mods), 0));
+
+    EXPECT_EQ(scan(PUT_MODS), TRANSACTION_END);
+    EXPECT_TRUE(uniform(slave.mods, sizeof(slave.mods), 0x55));
+}
+
+TEST_F(SerialInterrupt, CorruptReplyIsRejected) {
+    fill(0x55, 0xAA);
+    soft_serial_sim_flip_read(SOFT_SERIAL_SIM_MASTER, 9 + 5);
+
+    EXPECT_EQ(scan(EXCHANGE), TRANSACTION_DATA_ERROR);
+    EXPECT_EQ(master.status[EXCHANGE], TRANSACTION_DATA_ERROR);
+    EXPECT_TRUE(uniform(master.exchange_in, sizeof(master.exchange_in), 0));
+    // the slave had already taken the request
+    EXPECT_EQ(slave_soft_serial_get_and_clean_status(EXCHANGE), TRANSACTION_ACCEPTED);
+
+    EXPECT_EQ(scan(EXCHANGE), TRANSACTION_END);
+    EXPECT_TRUE(uniform(master.exchange_in, sizeof(master.exchange_in), 0xAA));
+}
+
+TEST_F(SerialInterrupt, NoResponseWhileDisconnected) {
+    fill(0x55, 0xAA);
+    soft_serial_sim_config()->disconnected = true;
+
+    uint64_t start = soft_serial_sim_now_us();
+    EXPECT_EQ(master_soft_serial_transaction(GET_MATRIX), TRANSACTION_NO_RESPONSE);
+    // gives up after the response timeout instead of waiting for a reply
+    EXPECT_LE(soft_serial_sim_now_us() - start, 2 * BYTE_US + 20 * 16);
+    soft_serial_sim_run_us(1000);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ(scan(i % NUM_TRANSACTIONS), TRANSACTION_NO_RESPONSE);
+    }
+    EXPECT_TRUE(uniform(master.matrix, sizeof(master.matrix), 0));
+    EXPECT_TRUE(uniform(slave.mods, sizeof(slave.mods), 0));
+
+    soft_serial_sim_config()->disconnected = false;
+    EXPECT_EQ(scan(GET_MATRIX), TRANSACTION_END);
+    EXPECT_TRUE(uniform(master.matrix, sizeof(master.matrix), 0xAA));
+    EXPECT_EQ(scan(PUT_MODS), TRANSACTION_END);
+    EXPECT_TRUE(uniform(slave.mods, sizeof(slave.mods), 0x55));
+}
+
+TEST_F(SerialInterrupt, NoisyLinkNeverDeliversCorruptData) {
+    soft_serial_sim_config()->read_error_ppm = 500;
+    int results[TRANSACTION_DATA_ERROR + 1] = {};
+    int corrupt                             = 0;
+    int accepted                            = 0;
+
+    for (int i = 0; i < 2000; i++) {
+        uint8_t value = i * 7;
+        fill(value, ~value);
+        int result = scan(EXCHANGE);
+        ASSERT_LE(result, TRANSACTION_DATA_ERROR);
+        results[result]++;
+        if (result == TRANSACTION_END && !uniform(master.exchange_in, sizeof(master.exchange_in), (uint8_t)~value)) {
+            corrupt++;
+        }
+        if (slave_soft_serial_get_and_clean_status(EXCHANGE) == TRANSACTION_ACCEPTED) {
+            accepted++;
+            if (!uniform(slave.exchange_in, sizeof(slave.exchange_in), value)) {
+                corrupt++;
+            }
+        }
+    }
+
+    EXPECT_EQ(corrupt, 0);
+    EXPECT_GT(soft_serial_sim_stats()->flipped, 0);
+    EXPECT_GT(results[TRANSACTION_END], 2000 * 3 / 4);
+    EXPECT_GT(results[TRANSACTION_NO_RESPONSE] + results[TRANSACTION_DATA_ERROR], 0);
+    fprintf(stdout, "[ STATS    ] noisy: %d end, %d no response, %d data error, %d accepted by the slave, %u of %u reads flipped\n", results[TRANSACTION_END], results[TRANSACTION_NO_RESPONSE], results[TRANSACTION_DATA_ERROR], accepted, soft_serial_sim_stats()->flipped, soft_serial_sim_stats()->reads);
+}
@@ -0,0 +1,38 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/* The serial harnesses link a serial driver twice, once per half. Each copy
+ * gets its global symbols, and the hardware it talks to, prefixed with the
+ * name of its half so that the simulation can tell the two apart.
+ */
+
+#define SIDE_SYMBOL__(side, name) side##_##name
+#define SIDE_SYMBOL_(side, name) SIDE_SYMBOL__(side, name)
+#define SIDE_SYMBOL(name) SIDE_SYMBOL_(SPLIT_SIDE, name)
+
+#define soft_serial_initiator_init SIDE_SYMBOL(soft_serial_initiator_init)
+#define soft_serial_target_init SIDE_SYMBOL(soft_serial_target_init)
+#define soft_serial_transaction SIDE_SYMBOL(soft_serial_transaction)
+#define soft_serial_get_and_clean_status SIDE_SYMBOL(soft_serial_get_and_clean_status)
+
+#define AVR_SIM_IO SIDE_SYMBOL(avr_io)
+#define INT2_vect SIDE_SYMBOL(INT2_vect)
+#define TIMER1_COMPA_vect SIDE_SYMBOL(TIMER1_COMPA_vect)
+
+#define UARTD1 SIDE_SYMBOL(UARTD1)
+#define usart_init SIDE_SYMBOL(usart_init)
@@ -0,0 +1,276 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "serial.h"
+#include "usart_sim.h"
+
+void master_soft_serial_initiator_init(SSTD_t *sstd_table, int sstd_table_size);
+int  master_soft_serial_transaction(int sstd_index);
+void slave_soft_serial_target_init(SSTD_t *sstd_table, int sstd_table_size);
+}
+
+// sync, id, sequence, length and crc16 around the payload
+#define FRAME_SIZE(payload) (6 + (payload))
+
+enum { GET_MATRIX, PUT_MODS, EXCHANGE, NUM_TRANSACTIONS };
+
+struct side_buffers_t {
+    uint8_t status[NUM_TRANSACTIONS];
+    uint8_t matrix[6];
+    uint8_t mods[4];
+    uint8_t exchange_out[8];
+    uint8_t exchange_in[8];
+};
+
+static side_buffers_t master;
+static side_buffers_t slave;
+
+static SSTD_t master_table[] = {
+    [GET_MATRIX] = {&master.status[GET_MATRIX], 0, NULL, sizeof(master.matrix), master.matrix},
+    [PUT_MODS]   = {&master.status[PUT_MODS], sizeof(master.mods), master.mods, 0, NULL},
+    [EXCHANGE]   = {&master.status[EXCHANGE], sizeof(master.exchange_out), master.exchange_out, sizeof(master.exchange_in), master.exchange_in},
+};
+
+static SSTD_t slave_table[] = {
+    [GET_MATRIX] = {&slave.status[GET_MATRIX], 0, NULL, sizeof(slave.matrix), slave.matrix},
+    [PUT_MODS]   = {&slave.status[PUT_MODS], sizeof(slave.mods), slave.mods, 0, NULL},
+    [EXCHANGE]   = {&slave.status[EXCHANGE], sizeof(slave.exchange_in), slave.exchange_in, sizeof(slave.exchange_out), slave.exchange_out},
+};
+
+static bool uniform(const uint8_t *data, size_t size, uint8_t value) {
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] != value) return false;
+    }
+    return true;
+}
+
+class SerialUsartDma : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        usart_sim_reset();
+        master = {};
+        slave  = {};
+        master_soft_serial_initiator_init(master_table, NUM_TRANSACTIONS);
+        slave_soft_serial_target_init(slave_table, NUM_TRANSACTIONS);
+    }
+
+    void TearDown() override {
+        EXPECT_EQ(usart_sim_stats()->send_while_busy, 0);
+        EXPECT_EQ(usart_sim_stats()->receive_while_busy, 0);
+        // lets the master give up on whatever is still in flight before the next init
+        usart_sim_reset();
+        usart_sim_run_us(100000);
+    }
+
+    // one transaction followed by the rest of a 1ms scan
+    int scan(int sstd_index) {
+        int result = master_soft_serial_transaction(sstd_index);
+        usart_sim_run_us(1000);
+        return result;
+    }
+
+    void fill(uint8_t master_value, uint8_t slave_value) {
+        memset(master.mods, master_value, sizeof(master.mods));
+        memset(master.exchange_out, master_value, sizeof(master.exchange_out));
+        memset(slave.matrix, slave_value, sizeof(slave.matrix));
+        memset(slave.exchange_out, slave_value, sizeof(slave.exchange_out));
+    }
+};
+
+TEST_F(SerialUsartDma, ExchangeCompletesWithoutBlocking) {
+    fill(0x3C, 0xC3);
+
+    uint64_t start = usart_sim_now_us();
+    // nothing was exchanged yet, the request is only queued
+    EXPECT_EQ(master_soft_serial_transaction(EXCHANGE), TRANSACTION_NO_RESPONSE);
+    EXPECT_EQ(usart_sim_now_us(), start);
+    EXPECT_TRUE(uniform(master.exchange_in, sizeof(master.exchange_in), 0));
+
+    usart_sim_run_us(2000);
+    EXPECT_TRUE(uniform(slave.exchange_in, sizeof(slave.exchange_in), 0x3C));
+    EXPECT_EQ(slave.status[EXCHANGE], TRANSACTION_ACCEPTED);
+    EXPECT_EQ(usart_sim_stats()->sent[USART_SIM_MASTER], FRAME_SIZE(sizeof(master.exchange_out)));
+    EXPECT_EQ(usart_sim_stats()->sent[USART_SIM_SLAVE], FRAME_SIZE(sizeof(slave.exchange_out)));
+
+    // the reply is handed over by the next call
+    EXPECT_EQ(master_soft_serial_transaction(EXCHANGE), TRANSACTION_END);
+    EXPECT_EQ(master.status[EXCHANGE], TRANSACTION_END);
+    EXPECT_TRUE(uniform(master.exchange_in, sizeof(master.exchange_in), 0xC3));
+}
+
+TEST_F(SerialUsartDma, TransactionsTakeTurns) {
+    fill(0x11, 0x22);
+    for (int i = 0; i < NUM_TRANSACTIONS; i++) {
+        master_soft_serial_transaction(i);
+    }
+    usart_sim_run_us(5000);
+    for (int i = 0; i < NUM_TRANSACTIONS; i++) {
+        EXPECT_EQ(master_soft_serial_transaction(i), TRANSACTION_END);
+        EXPECT_EQ(slave.status[i], TRANSACTION_ACCEPTED);
+    }
+    EXPECT_TRUE(uniform(master.matrix, sizeof(master.matrix), 0x22));
+    EXPECT_TRUE(uniform(slave.mods, sizeof(slave.mods), 0x11));
+    EXPECT_TRUE(uniform(master.exchange_in, sizeof(master.exchange_in), 0x22));
+}
+
+TEST_F(SerialUsartDma, PendingUntilCurrentDataIsAcknowledged) {
+    fill(0x01, 0);
+    master_soft_serial_transaction(PUT_MODS);
+    usart_sim_run_us(2000);
+    EXPECT_EQ(master_soft_serial_transaction(PUT_MODS), TRANSACTION_END);
+    usart_sim_run_us(2000);
+    // unchanged data stays acknowledged
+    EXPECT_EQ(master_soft_serial_transaction(PUT_MODS), TRANSACTION_END);
+
+    fill(0x02, 0);
+    EXPECT_EQ(master_soft_serial_transaction(PUT_MODS), TRANSACTION_PENDING);
+    EXPECT_TRUE(uniform(slave.mods, sizeof(slave.mods), 0x01));
+    usart_sim_run_us(2000);
+    EXPECT_TRUE(uniform(slave.mods, sizeof(slave.mods), 0x02));
+    EXPECT_EQ(master_soft_serial_transaction(PUT_MODS), TRANSACTION_END);
+
+    // a reply to older data does not acknowledge newer data
+    fill(0x03, 0);
+    master_soft_serial_transaction(PUT_MODS);
+    fill(0x04, 0);
+    usart_sim_run_us(2000);
+    EXPECT_EQ(master_soft_serial_transaction(PUT_MODS), TRANSACTION_PENDING);
+    usart_sim_run_us(2000);
+    EXPECT_EQ(master_soft_serial_transaction(PUT_MODS), TRANSACTION_END);
+    EXPECT_TRUE(uniform(slave.mods, sizeof(slave.mods), 0x04));
+}
+
+TEST_F(SerialUsartDma, CorruptRequestIsSentAgain) {
+    fill(0x3C, 0xC3);
+    // first payload byte
+    usart_sim_corrupt(USART_SIM_MASTER, 5);
+    master_soft_serial_transaction(EXCHANGE);
+
+    usart_sim_run_us(4000);
+    EXPECT_EQ(slave.status[EXCHANGE], 0);
+    EXPECT_TRUE(uniform(slave.exchange_in, sizeof(slave.exchange_in), 0));
+
+    // sent again once SERIAL_USART_TIMEOUT passed without a reply
+    usart_sim_run_us(4000);
+    EXPECT_EQ(slave.status[EXCHANGE], TRANSACTION_ACCEPTED);
+    EXPECT_TRUE(uniform(slave.exchange_in, sizeof(slave.exchange_in), 0x3C));
+    EXPECT_EQ(usart_sim_stats()->sent[USART_SIM_MASTER], 2 * FRAME_SIZE(sizeof(master.exchange_out)));
+    EXPECT_EQ(master_soft_serial_transaction(EXCHANGE), TRANSACTION_END);
+    EXPECT_TRUE(uniform(master.exchange_in, sizeof(master.exchange_in), 0xC3));
+}
+
+TEST_F(SerialUsartDma, LostReplyIsAnsweredAgain) {
+    fill(0x3C, 0xC3);
+    // last crc byte of the reply
+    usart_sim_corrupt(USART_SIM_SLAVE, FRAME_SIZE(sizeof(slave.exchange_out)));
+    master_soft_serial_transaction(EXCHANGE);
+
+    usart_sim_run_us(2000);
+    EXPECT_EQ(slave.status[EXCHANGE], TRANSACTION_ACCEPTED);
+    slave.status[EXCHANGE] = 0;
+    memset(slave.exchange_in, 0, sizeof(slave.exchange_in));
+
+    // the repeated request is only answered, not taken again
+    usart_sim_run_us(6000);
+    EXPECT_EQ(slave.status[EXCHANGE], 0);
+    EXPECT_TRUE(uniform(slave.exchange_in, sizeof(slave.exchange_in), 0));
+    EXPECT_EQ(usart_sim_stats()->sent[USART_SIM_SLAVE], 2 * FRAME_SIZE(sizeof(slave.exchange_out)));
+    EXPECT_EQ(master_soft_serial_transaction(EXCHANGE), TRANSACTION_END);
+    EXPECT_TRUE(uniform(master.exchange_in, sizeof(master.exchange_in), 0xC3));
+}
+
+TEST_F(SerialUsartDma, ResyncsAfterCorruptSyncByte) {
+    fill(0x3C, 0xC3);
+    usart_sim_corrupt(USART_SIM_MASTER, 1);
+    master_soft_serial_transaction(PUT_MODS);
+
+    usart_sim_run_us(4000);
+    EXPECT_EQ(slave.status[PUT_MODS], 0);
+    usart_sim_run_us(4000);
+    EXPECT_EQ(slave.status[PUT_MODS], TRANSACTION_ACCEPTED);
+    EXPECT_TRUE(uniform(slave.mods, sizeof(slave.mods), 0x3C));
+    EXPECT_EQ(master_soft_serial_transaction(PUT_MODS), TRANSACTION_END);
+}
+
+TEST_F(SerialUsartDma, GivesUpAfterRetries) {
+    fill(0x3C, 0xC3);
+    usart_sim_config()->disconnected = true;
+    master_soft_serial_transaction(GET_MATRIX);
+    usart_sim_run_us(SERIAL_USART_RETRIES * SERIAL_USART_TIMEOUT * 1000 + 1000);
+    EXPECT_EQ(usart_sim_stats()->sent[USART_SIM_MASTER], SERIAL_USART_RETRIES * FRAME_SIZE(0));
+    EXPECT_EQ(master_soft_serial_transaction(GET_MATRIX), TRANSACTION_NO_RESPONSE);
+    EXPECT_EQ(master.status[GET_MATRIX], TRANSACTION_NO_RESPONSE);
+
+    usart_sim_config()->disconnected = false;
+    usart_sim_run_us(2000);
+    EXPECT_EQ(master_soft_serial_transaction(GET_MATRIX), TRANSACTION_END);
+    EXPECT_TRUE(uniform(master.matrix, sizeof(master.matrix), 0xC3));
+}
+
+TEST_F(SerialUsartDma, NoisyLinkNeverDeliversCorruptData) {
+    usart_sim_config()->bit_error_ppm = 200;
+    int results[TRANSACTION_PENDING + 1] = {};
+    int corrupt                          = 0;
+    int accepted                         = 0;
+    int stale                            = 0;
+
+    for (int i = 0; i < 5000; i++) {
+        uint8_t value = i / 3;
+        fill(value, ~value);
+        int result = scan(EXCHANGE);
+        ASSERT_LE(result, TRANSACTION_PENDING);
+        results[result]++;
+        // replies may be a few scans old, but never torn
+        if (result == TRANSACTION_END && !uniform(master.exchange_in, sizeof(master.exchange_in), master.exchange_in[0])) {
+            corrupt++;
+        }
+        // TRANSACTION_END promises that the slave holds the current data
+        if (result == TRANSACTION_END && !uniform(slave.exchange_in, sizeof(slave.exchange_in), value)) {
+            stale++;
+        }
+        if (slave.status[EXCHANGE] == TRANSACTION_ACCEPTED) {
+            slave.status[EXCHANGE] = 0;
+            accepted++;
+            if (!uniform(slave.exchange_in, sizeof(slave.exchange_in), slave.exchange_in[0])) {
+                corrupt++;
+            }
+        }
+    }
+
+    EXPECT_EQ(corrupt, 0);
+    EXPECT_EQ(stale, 0);
+    EXPECT_GT(usart_sim_stats()->corrupt + usart_sim_stats()->framing_errors, 0);
+    EXPECT_GT(results[TRANSACTION_END], 0);
+    EXPECT_GT(results[TRANSACTION_END] + results[TRANSACTION_PENDING], 5000 * 9 / 10);
+    EXPECT_GT(accepted, 5000 / 2);
+    fprintf(stdout, "[ STATS    ] noisy: %d end, %d pending, %d no response, %d accepted by the slave, %u corrupt characters, %u framing errors\n", results[TRANSACTION_END], results[TRANSACTION_PENDING], results[TRANSACTION_NO_RESPONSE], accepted, usart_sim_stats()->corrupt, usart_sim_stats()->framing_errors);
+
+    // back in sync once the noise is gone
+    usart_sim_config()->bit_error_ppm = 0;
+    fill(0x5A, 0xA5);
+    for (int i = 0; i < 30; i++) {
+        scan(EXCHANGE);
+    }
+    EXPECT_EQ(scan(EXCHANGE), TRANSACTION_END);
+    EXPECT_TRUE(uniform(master.exchange_in, sizeof(master.exchange_in), 0xA5));
+    EXPECT_TRUE(uniform(slave.exchange_in, sizeof(slave.exchange_in), 0x5A));
+}
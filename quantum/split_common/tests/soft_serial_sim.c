@@ -0,0 +1,231 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <avr/io.h>
+#include "gpio.h"
+#include "soft_serial_sim.h"
+
+#if SOFT_SERIAL_PIN != D2
+#    error The simulated wire is on D2 and INT2
+#endif
+
+#define SIM_PIN _BV(SOFT_SERIAL_PIN & 0xF)
+#define SIM_INT _BV(2)
+#define SIM_CYCLES_PER_US (F_CPU / 1000000)
+// far longer than any transaction, which would otherwise hang its caller
+#define SIM_TRANSACTION_LIMIT_US 100000
+
+avr_sim_io_t master_avr_io;
+avr_sim_io_t slave_avr_io;
+
+void master_INT2_vect(void);
+void master_TIMER1_COMPA_vect(void);
+void slave_INT2_vect(void);
+void slave_TIMER1_COMPA_vect(void);
+
+typedef struct {
+    avr_sim_io_t *io;
+    void (*pin_vect)(void);
+    void (*timer_vect)(void);
+    uint8_t  eifr;       // pending interrupt flags
+    uint8_t  tifr1;
+    uint32_t flip_read;  // countdown to the next read that is flipped
+} sim_side_t;
+
+static sim_side_t sides[2] = {
+    [SOFT_SERIAL_SIM_MASTER] = {.io = &master_avr_io, .pin_vect = master_INT2_vect, .timer_vect = master_TIMER1_COMPA_vect},
+    [SOFT_SERIAL_SIM_SLAVE]  = {.io = &slave_avr_io, .pin_vect = slave_INT2_vect, .timer_vect = slave_TIMER1_COMPA_vect},
+};
+
+static soft_serial_sim_config_t config;
+static soft_serial_sim_stats_t  stats;
+static uint32_t                 rng_state;
+static uint64_t                 now;  // CPU cycles
+static bool                     servicing;
+
+// xorshift32, so every run sees the same faults
+static uint32_t sim_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static bool drives(const avr_sim_io_t *io) { return io->ddrd & SIM_PIN; }
+
+// level a half puts on its end of the wire, the pull-up keeps it high while it only listens
+static bool own_level(const avr_sim_io_t *io) { return !drives(io) || (io->portd & SIM_PIN); }
+
+static void service(sim_side_t *side);
+
+// writing a one to a flag clears it
+static void clear_flags(sim_side_t *side) {
+    side->eifr &= ~side->io->eifr;
+    side->tifr1 &= ~side->io->tifr1;
+    side->io->eifr  = 0;
+    side->io->tifr1 = 0;
+}
+
+static void wire_update(void) {
+    for (uint8_t i = 0; i < 2; i++) {
+        clear_flags(&sides[i]);
+    }
+    if (drives(&master_avr_io) && drives(&slave_avr_io)) {
+        stats.contention++;
+    }
+    bool wire = own_level(&master_avr_io) && own_level(&slave_avr_io);
+    for (uint8_t i = 0; i < 2; i++) {
+        avr_sim_io_t *io    = sides[i].io;
+        bool          level = config.disconnected ? own_level(io) : wire;
+        if ((io->pind & SIM_PIN) && !level) {
+            stats.edges++;
+            if ((io->eicra & (3 << 4)) == (2 << 4)) {
+                sides[i].eifr |= SIM_INT;
+            }
+        }
+        io->pind = level ? io->pind | SIM_PIN : io->pind & ~SIM_PIN;
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+        service(&sides[i]);
+    }
+}
+
+// runs the pending vectors of one half, lowest vector first like the hardware
+static void service(sim_side_t *side) {
+    avr_sim_io_t *io = side->io;
+    clear_flags(side);
+    if (side->eifr & io->eimsk & SIM_INT) {
+        side->eifr &= ~SIM_INT;
+        side->pin_vect();
+        wire_update();
+    }
+    if (side->tifr1 & io->timsk1 & _BV(OCF1A)) {
+        side->tifr1 &= ~_BV(OCF1A);
+        side->timer_vect();
+        wire_update();
+    }
+}
+
+static bool timer_running(const avr_sim_io_t *io) { return io->tccr1b & 0x07; }
+
+// in CTC mode the counter is cleared on the cycle after it reached OCR1A
+static uint32_t cycles_to_match(const avr_sim_io_t *io) {
+    if (io->tcnt1 <= io->ocr1a) {
+        return io->ocr1a - io->tcnt1 + 1;
+    }
+    return 0x10000 - io->tcnt1 + io->ocr1a + 1;
+}
+
+// runs until the next compare match or until, returns false if until came first
+static bool step(uint64_t until) {
+    uint64_t delta = UINT64_MAX;
+    for (uint8_t i = 0; i < 2; i++) {
+        if (timer_running(sides[i].io) && cycles_to_match(sides[i].io) < delta) {
+            delta = cycles_to_match(sides[i].io);
+        }
+    }
+    bool match = delta <= until - now;
+    if (!match) {
+        delta = until - now;
+    }
+
+    now += delta;
+    for (uint8_t i = 0; i < 2; i++) {
+        avr_sim_io_t *io = sides[i].io;
+        if (!timer_running(io)) {
+            continue;
+        }
+        if (cycles_to_match(io) == delta) {
+            io->tcnt1 = 0;
+            sides[i].tifr1 |= _BV(OCF1A);
+        } else {
+            io->tcnt1 += delta;
+        }
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+        service(&sides[i]);
+    }
+    return match;
+}
+
+bool soft_serial_sim_read_pin(const avr_sim_io_t *io, uint8_t bit) {
+    sim_side_t *side  = io == &master_avr_io ? &sides[SOFT_SERIAL_SIM_MASTER] : &sides[SOFT_SERIAL_SIM_SLAVE];
+    bool        level = (io->pind >> bit) & 1;
+
+    stats.reads++;
+    bool flip = side->flip_read && --side->flip_read == 0;
+    if (config.read_error_ppm && sim_random() % 1000000 < config.read_error_ppm) {
+        flip = true;
+    }
+    if (flip) {
+        stats.flipped++;
+        level = !level;
+    }
+    return level;
+}
+
+void soft_serial_sim_interrupts_enabled(void) {
+    if (servicing) {
+        return;
+    }
+    servicing = true;
+    wire_update();
+    uint64_t limit = now + (uint64_t)SIM_TRANSACTION_LIMIT_US * SIM_CYCLES_PER_US;
+    while (timer_running(&master_avr_io)) {
+        if (!step(limit)) {
+            fprintf(stderr, "soft_serial_sim: the initiator did not finish its transaction\n");
+            abort();
+        }
+    }
+    servicing = false;
+}
+
+void soft_serial_sim_run_us(uint32_t us) {
+    servicing     = true;
+    uint64_t until = now + (uint64_t)us * SIM_CYCLES_PER_US;
+    wire_update();
+    while (step(until)) {
+    }
+    servicing = false;
+}
+
+uint64_t soft_serial_sim_now_us(void) { return now / SIM_CYCLES_PER_US; }
+
+void soft_serial_sim_reset(void) {
+    memset(&master_avr_io, 0, sizeof(master_avr_io));
+    memset(&slave_avr_io, 0, sizeof(slave_avr_io));
+    master_avr_io.pind = slave_avr_io.pind = SIM_PIN;
+    for (uint8_t i = 0; i < 2; i++) {
+        sides[i].eifr      = 0;
+        sides[i].tifr1     = 0;
+        sides[i].flip_read = 0;
+    }
+    memset(&config, 0, sizeof(config));
+    rng_state = 0x2545F491;
+    soft_serial_sim_clear_stats();
+}
+
+soft_serial_sim_config_t *soft_serial_sim_config(void) { return &config; }
+
+const soft_serial_sim_stats_t *soft_serial_sim_stats(void) { return &stats; }
+
+void soft_serial_sim_clear_stats(void) { memset(&stats, 0, sizeof(stats)); }
+
+void soft_serial_sim_flip_read(soft_serial_sim_side_t side, uint32_t count) { sides[side].flip_read = count; }
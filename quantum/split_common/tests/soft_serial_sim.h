@@ -0,0 +1,72 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulated hardware for drivers/avr/serial_interrupt.c
+ *
+ * Both halves run their own copy of the driver against their own registers,
+ * the master half as initiator. The wire between their serial pins is open
+ * drain with pull-ups: it is low whenever either half drives it low. Timer 1
+ * counts CPU cycles in CTC mode and falling edges raise INT2, both call the
+ * vectors of their half like the hardware would, with no interrupt latency.
+ *
+ * soft_serial_transaction() spins with interrupts enabled until its
+ * transaction is over. Here the interrupts are serviced when its ATOMIC_BLOCK
+ * ends, until the timer of the initiator stops, which the driver does once the
+ * transaction is over. Everything else runs from soft_serial_sim_run_us().
+ */
+
+typedef enum {
+    SOFT_SERIAL_SIM_MASTER,
+    SOFT_SERIAL_SIM_SLAVE,
+} soft_serial_sim_side_t;
+
+typedef struct {
+    uint32_t read_error_ppm;  // chance of a pin read returning the wrong level, per million
+    bool     disconnected;    // each half only sees its own end of the wire
+} soft_serial_sim_config_t;
+
+typedef struct {
+    uint32_t reads;       // pin reads, i.e. bits sampled
+    uint32_t flipped;     // pin reads that returned the wrong level
+    uint32_t edges;       // falling edges on the wire
+    uint32_t contention;  // times both halves drove the wire at once
+} soft_serial_sim_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// clears the registers of both halves and restores the default config, stats and random seed
+void                           soft_serial_sim_reset(void);
+soft_serial_sim_config_t *     soft_serial_sim_config(void);
+const soft_serial_sim_stats_t *soft_serial_sim_stats(void);
+void                           soft_serial_sim_clear_stats(void);
+
+// the count-th pin read of side from now on returns the wrong level, 0 cancels
+void soft_serial_sim_flip_read(soft_serial_sim_side_t side, uint32_t count);
+
+// lets both halves run for us microseconds
+void     soft_serial_sim_run_us(uint32_t us);
+uint64_t soft_serial_sim_now_us(void);
+
+#ifdef __cplusplus
+}
+#endif
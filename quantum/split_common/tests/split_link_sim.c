@@ -0,0 +1,152 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "config.h"
+#include "split_link_sim.h"
+#include "serial.h"
+#include "timer.h"
+
+void advance_time(uint32_t ms);
+
+static SSTD_t *initiator_table;
+static int     initiator_table_size;
+static SSTD_t *target_table;
+static int     target_table_size;
+
+static split_link_config_t config;
+static split_link_stats_t  stats;
+static uint32_t            rng_state;
+static uint32_t            carry_us;
+
+static const split_link_config_t default_config = {
+    .byte_time_us = 70,
+    .overhead_us  = 40,
+};
+
+// xorshift32, so every run sees the same faults
+static uint32_t link_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static void link_busy(uint32_t us) {
+    stats.busy_us += us;
+    carry_us += us;
+    advance_time(carry_us / 1000);
+    carry_us %= 1000;
+}
+
+// copies size bytes across the wire, returns false if any bit was flipped on the way
+static bool link_transfer(uint8_t *dst, const uint8_t *src, uint8_t size) {
+    bool intact = true;
+    for (uint8_t i = 0; i < size; ++i) {
+        uint8_t data = src[i];
+        if (config.bit_error_ppm) {
+            for (uint8_t bit = 0; bit < 8; ++bit) {
+                if (link_random() % 1000000 < config.bit_error_ppm) {
+                    data ^= 1 << bit;
+                    intact = false;
+                }
+            }
+        }
+        dst[i] = data;
+    }
+    stats.bytes += size;
+    link_busy((uint32_t)size * config.byte_time_us);
+    return intact;
+}
+
+void split_link_reset(void) {
+    initiator_table = NULL;
+    target_table    = NULL;
+    config          = default_config;
+    rng_state       = 0x2545F491;
+    carry_us        = 0;
+    split_link_clear_stats();
+}
+
+split_link_config_t *split_link_config(void) { return &config; }
+
+const split_link_stats_t *split_link_stats(void) { return &stats; }
+
+void split_link_clear_stats(void) { memset(&stats, 0, sizeof(stats)); }
+
+void soft_serial_initiator_init(SSTD_t *sstd_table, int sstd_table_size) {
+    initiator_table      = sstd_table;
+    initiator_table_size = sstd_table_size;
+}
+
+void soft_serial_target_init(SSTD_t *sstd_table, int sstd_table_size) {
+    target_table      = sstd_table;
+    target_table_size = sstd_table_size;
+}
+
+static int link_transaction(int sstd_index) {
+    if (sstd_index >= initiator_table_size) {
+        return TRANSACTION_TYPE_ERROR;
+    }
+    SSTD_t *initiator = &initiator_table[sstd_index];
+
+    stats.transactions++;
+    link_busy(config.overhead_us);
+
+    bool dropped = config.disconnected || !target_table || sstd_index >= target_table_size || link_random() % 1000 < config.drop_permille;
+    if (dropped) {
+        stats.failed++;
+        *initiator->status = TRANSACTION_NO_RESPONSE;
+        return TRANSACTION_NO_RESPONSE;
+    }
+    SSTD_t *target = &target_table[sstd_index];
+    bool    intact = true;
+
+    // the target answers first, then takes the initiator's data
+    if (initiator->target2initiator_buffer_size) {
+        if (!link_transfer(initiator->target2initiator_buffer, target->target2initiator_buffer, initiator->target2initiator_buffer_size)) {
+            stats.corrupt++;
+            stats.failed++;
+            *initiator->status = TRANSACTION_DATA_ERROR;
+            return TRANSACTION_DATA_ERROR;
+        }
+    }
+    if (initiator->initiator2target_buffer_size) {
+        intact = link_transfer(target->initiator2target_buffer, initiator->initiator2target_buffer, initiator->initiator2target_buffer_size);
+    }
+    if (intact) {
+        *target->status = TRANSACTION_ACCEPTED;
+    } else {
+        stats.corrupt++;
+        *target->status = TRANSACTION_DATA_ERROR;
+    }
+
+    *initiator->status = TRANSACTION_END;
+    return TRANSACTION_END;
+}
+
+#ifndef SERIAL_USE_MULTI_TRANSACTION
+int soft_serial_transaction(void) { return link_transaction(0); }
+#else
+int soft_serial_transaction(int sstd_index) { return link_transaction(sstd_index); }
+
+int soft_serial_get_and_clean_status(int sstd_index) {
+    int status                       = *target_table[sstd_index].status;
+    *target_table[sstd_index].status = 0;
+    return status;
+}
+#endif
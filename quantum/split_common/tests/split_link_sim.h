@@ -0,0 +1,62 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulated soft serial link
+ *
+ * Stands in for the serial driver on both halves. A transaction started by
+ * the initiator is delivered to the target table immediately, with the timer
+ * advanced by the time it would have kept the wire busy. Faults follow the
+ * bitbang driver: corrupt initiator to target data lands in the target buffer
+ * flagged TRANSACTION_DATA_ERROR while the initiator sees TRANSACTION_END,
+ * corrupt target to initiator data fails the transaction with
+ * TRANSACTION_DATA_ERROR, and a dropped transaction times out with
+ * TRANSACTION_NO_RESPONSE. Every corruption is assumed to be detected.
+ */
+
+typedef struct {
+    uint16_t byte_time_us;   // wire time per payload byte
+    uint16_t overhead_us;    // handshake and turnaround per transaction, also the timeout
+    uint32_t bit_error_ppm;  // chance of each bit being flipped, per million
+    uint16_t drop_permille;  // chance of the target missing a transaction, per thousand
+    bool     disconnected;   // every transaction times out
+} split_link_config_t;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t failed;   // initiator did not get TRANSACTION_END
+    uint32_t corrupt;  // transactions with at least one flipped bit
+    uint32_t bytes;    // payload bytes put on the wire
+    uint32_t busy_us;  // time the wire was busy
+} split_link_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// forgets both tables and restores the default config, stats and random seed
+void                      split_link_reset(void);
+split_link_config_t *     split_link_config(void);
+const split_link_stats_t *split_link_stats(void);
+void                      split_link_clear_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,6 @@
+TEST_LIST +=\
+	split_transport\
+	split_transport_delta\
+	split_transport_rgb_matrix\
+	serial_interrupt\
+	serial_usart_dma
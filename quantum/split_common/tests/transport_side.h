@@ -0,0 +1,63 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/* The harness links transport.c twice, once per half. Each copy gets the
+ * global symbols of transport.c, and the state it shares with the rest of
+ * the firmware, prefixed with the name of its half so the two halves keep
+ * their own buffers like they would on two MCUs.
+ */
+
+#define SIDE_SYMBOL__(side, name) side##_##name
+#define SIDE_SYMBOL_(side, name) SIDE_SYMBOL__(side, name)
+#define SIDE_SYMBOL(name) SIDE_SYMBOL_(SPLIT_SIDE, name)
+
+#define serial_s2m_buffer SIDE_SYMBOL(serial_s2m_buffer)
+#define serial_m2s_buffer SIDE_SYMBOL(serial_m2s_buffer)
+#define status0 SIDE_SYMBOL(status0)
+#define serial_rgblight SIDE_SYMBOL(serial_rgblight)
+#define status_rgblight SIDE_SYMBOL(status_rgblight)
+#define serial_encoders SIDE_SYMBOL(serial_encoders)
+#define serial_sync_timer SIDE_SYMBOL(serial_sync_timer)
+#define serial_mmatrix SIDE_SYMBOL(serial_mmatrix)
+#define serial_mods SIDE_SYMBOL(serial_mods)
+#define serial_backlight_level SIDE_SYMBOL(serial_backlight_level)
+#define serial_wpm SIDE_SYMBOL(serial_wpm)
+#define serial_user_data SIDE_SYMBOL(serial_user_data)
+#define serial_status SIDE_SYMBOL(serial_status)
+#define transactions SIDE_SYMBOL(transactions)
+#define transport_master_init SIDE_SYMBOL(transport_master_init)
+#define transport_slave_init SIDE_SYMBOL(transport_slave_init)
+#define transport_master SIDE_SYMBOL(transport_master)
+#define transport_slave SIDE_SYMBOL(transport_slave)
+#define split_transport_user_data_master SIDE_SYMBOL(split_transport_user_data_master)
+#define split_transport_user_data_slave SIDE_SYMBOL(split_transport_user_data_slave)
+
+#define get_mods SIDE_SYMBOL(get_mods)
+#define set_mods SIDE_SYMBOL(set_mods)
+#define get_weak_mods SIDE_SYMBOL(get_weak_mods)
+#define set_weak_mods SIDE_SYMBOL(set_weak_mods)
+#define get_oneshot_mods SIDE_SYMBOL(get_oneshot_mods)
+#define set_oneshot_mods SIDE_SYMBOL(set_oneshot_mods)
+#define get_current_wpm SIDE_SYMBOL(get_current_wpm)
+#define set_current_wpm SIDE_SYMBOL(set_current_wpm)
+#define rgb_matrix_get_syncinfo SIDE_SYMBOL(rgb_matrix_get_syncinfo)
+#define rgb_matrix_update_sync SIDE_SYMBOL(rgb_matrix_update_sync)
+#define rgb_matrix_get_split_hits SIDE_SYMBOL(rgb_matrix_get_split_hits)
+#define rgb_matrix_update_split_hits SIDE_SYMBOL(rgb_matrix_update_split_hits)
+#define serial_rgb_matrix SIDE_SYMBOL(serial_rgb_matrix)
+#define status_rgb_matrix SIDE_SYMBOL(status_rgb_matrix)
@@ -0,0 +1,371 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "config.h"
+#include "matrix.h"
+#include "serial.h"
+#include "split_link_sim.h"
+#ifdef RGB_MATRIX_SPLIT
+#    include "rgb_matrix.h"
+#endif
+}
+
+#define ROWS_PER_HAND (MATRIX_ROWS / 2)
+
+extern "C" {
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+uint32_t timer_read32(void);
+
+void master_transport_master_init(void);
+bool master_transport_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]);
+void slave_transport_slave_init(void);
+void slave_transport_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]);
+}
+
+// What each half shares with the rest of its firmware
+struct side_state_t {
+    uint8_t mods;
+    uint8_t weak_mods;
+    uint8_t oneshot_mods;
+    uint8_t wpm;
+    uint8_t user_data[4];
+    int     user_data_updates;
+};
+
+static side_state_t master_side;
+static side_state_t slave_side;
+
+extern "C" {
+uint8_t master_get_mods(void) { return master_side.mods; }
+void    master_set_mods(uint8_t mods) { master_side.mods = mods; }
+uint8_t master_get_weak_mods(void) { return master_side.weak_mods; }
+void    master_set_weak_mods(uint8_t mods) { master_side.weak_mods = mods; }
+uint8_t master_get_oneshot_mods(void) { return master_side.oneshot_mods; }
+void    master_set_oneshot_mods(uint8_t mods) { master_side.oneshot_mods = mods; }
+uint8_t master_get_current_wpm(void) { return master_side.wpm; }
+void    master_set_current_wpm(uint8_t wpm) { master_side.wpm = wpm; }
+
+uint8_t slave_get_mods(void) { return slave_side.mods; }
+void    slave_set_mods(uint8_t mods) { slave_side.mods = mods; }
+uint8_t slave_get_weak_mods(void) { return slave_side.weak_mods; }
+void    slave_set_weak_mods(uint8_t mods) { slave_side.weak_mods = mods; }
+uint8_t slave_get_oneshot_mods(void) { return slave_side.oneshot_mods; }
+void    slave_set_oneshot_mods(uint8_t mods) { slave_side.oneshot_mods = mods; }
+uint8_t slave_get_current_wpm(void) { return slave_side.wpm; }
+void    slave_set_current_wpm(uint8_t wpm) { slave_side.wpm = wpm; }
+
+#ifdef RGB_MATRIX_SPLIT
+static rgb_matrix_syncinfo_t   master_rgb_matrix_sync;
+static rgb_matrix_syncinfo_t   slave_rgb_matrix_sync;
+static rgb_matrix_split_hits_t master_rgb_matrix_hits;
+static rgb_matrix_split_hits_t slave_rgb_matrix_hits;
+
+void master_rgb_matrix_get_syncinfo(rgb_matrix_syncinfo_t *syncinfo) { *syncinfo = master_rgb_matrix_sync; }
+void master_rgb_matrix_update_sync(const rgb_matrix_syncinfo_t *syncinfo) { master_rgb_matrix_sync = *syncinfo; }
+void master_rgb_matrix_get_split_hits(rgb_matrix_split_hits_t *hits) { *hits = master_rgb_matrix_hits; }
+void master_rgb_matrix_update_split_hits(const rgb_matrix_split_hits_t *hits) { master_rgb_matrix_hits = *hits; }
+
+void slave_rgb_matrix_get_syncinfo(rgb_matrix_syncinfo_t *syncinfo) { *syncinfo = slave_rgb_matrix_sync; }
+void slave_rgb_matrix_update_sync(const rgb_matrix_syncinfo_t *syncinfo) { slave_rgb_matrix_sync = *syncinfo; }
+void slave_rgb_matrix_get_split_hits(rgb_matrix_split_hits_t *hits) { *hits = slave_rgb_matrix_hits; }
+void slave_rgb_matrix_update_split_hits(const rgb_matrix_split_hits_t *hits) { slave_rgb_matrix_hits = *hits; }
+#endif
+
+#ifdef SPLIT_TRANSPORT_USER_DATA_SIZE
+void master_split_transport_user_data_master(uint8_t *data) { memcpy(data, master_side.user_data, SPLIT_TRANSPORT_USER_DATA_SIZE); }
+
+void slave_split_transport_user_data_slave(const uint8_t *data) {
+    memcpy(slave_side.user_data, data, SPLIT_TRANSPORT_USER_DATA_SIZE);
+    slave_side.user_data_updates++;
+}
+#endif
+}
+
+// Rows carry a check byte so that a corrupt copy can be told from a stale one
+static void make_rows(matrix_row_t rows[], uint16_t seed) {
+    rows[0] = seed;
+    rows[1] = seed >> 8;
+    rows[2] = seed * 37;
+    rows[3] = rows[0] ^ rows[1] ^ rows[2] ^ 0xA5;
+}
+
+static bool rows_valid(const matrix_row_t rows[]) { return rows[3] == (matrix_row_t)(rows[0] ^ rows[1] ^ rows[2] ^ 0xA5); }
+
+static bool rows_equal(const matrix_row_t a[], const matrix_row_t b[]) { return memcmp(a, b, sizeof(matrix_row_t) * ROWS_PER_HAND) == 0; }
+
+class SplitTransport : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        set_time(0);
+        split_link_reset();
+        master_side = {};
+        slave_side  = {};
+#ifdef RGB_MATRIX_SPLIT
+        master_rgb_matrix_sync = {};
+        slave_rgb_matrix_sync  = {};
+        master_rgb_matrix_hits = {};
+        slave_rgb_matrix_hits  = {};
+#endif
+        make_rows(master_rows, 0);
+        make_rows(slave_rows, 0);
+        make_rows(master_copy, 0);
+        make_rows(slave_copy, 0);
+        scans = synced = corrupt_rows = corrupt_mirrors = 0;
+        master_transport_master_init();
+        slave_transport_slave_init();
+    }
+
+    // One scan of both halves, returns what transport_master() did
+    bool scan(void) {
+        slave_transport_slave(slave_copy, slave_rows);
+        bool ok = master_transport_master(master_rows, master_copy);
+        scans++;
+        if (ok) {
+            if (rows_equal(master_copy, slave_rows)) {
+                synced++;
+            } else {
+                corrupt_rows++;
+            }
+        }
+        if (!rows_valid(slave_copy)) {
+            corrupt_mirrors++;
+        }
+        advance_time(1);
+        return ok;
+    }
+
+    bool in_sync(void) {
+#ifdef SPLIT_TRANSPORT_MIRROR
+        if (!rows_equal(slave_copy, master_rows)) return false;
+#endif
+        return rows_equal(master_copy, slave_rows) && slave_side.mods == master_side.mods && slave_side.wpm == master_side.wpm;
+    }
+
+    void report(const char *name) {
+        const split_link_stats_t *stats = split_link_stats();
+        uint32_t                  time  = timer_read32();
+        fprintf(stdout, "[ STATS    ] %s: %u scans in %u ms, %u synced (%.1f%%, %.0f/s), %u transactions (%u failed, %u corrupt), %.1f bytes/scan, link busy %.1f%%\n", name, scans, time, synced, 100.0 * synced / scans, 1000.0 * synced / time, stats->transactions, stats->failed, stats->corrupt, (double)stats->bytes / scans, stats->busy_us / (10.0 * time));
+    }
+
+    matrix_row_t master_rows[ROWS_PER_HAND];
+    matrix_row_t slave_rows[ROWS_PER_HAND];
+    // the master's copy of the slave rows and the slave's copy of the master rows
+    matrix_row_t master_copy[ROWS_PER_HAND];
+    matrix_row_t slave_copy[ROWS_PER_HAND];
+
+    uint32_t scans;
+    uint32_t synced;
+    uint32_t corrupt_rows;
+    uint32_t corrupt_mirrors;
+};
+
+TEST_F(SplitTransport, CleanLinkSyncsEveryScan) {
+    for (uint16_t i = 0; i < 1000; i++) {
+        make_rows(slave_rows, i);
+        make_rows(master_rows, i / 10);
+        master_side.mods = i / 100;
+        master_side.wpm  = i / 50;
+        EXPECT_TRUE(scan());
+        EXPECT_TRUE(rows_equal(master_copy, slave_rows));
+    }
+    for (int i = 0; i < 3; i++) {
+        scan();
+    }
+    EXPECT_TRUE(in_sync());
+    EXPECT_EQ(split_link_stats()->failed, 0);
+    report("clean");
+}
+
+TEST_F(SplitTransport, NoisyLinkNeverDeliversCorruptMatrix) {
+    split_link_config()->bit_error_ppm = 1000;
+    for (uint16_t i = 0; i < 5000; i++) {
+        make_rows(slave_rows, i);
+        make_rows(master_rows, i / 7);
+        scan();
+    }
+    EXPECT_GT(split_link_stats()->corrupt, 0);
+    EXPECT_EQ(corrupt_rows, 0);
+    EXPECT_GT(synced, scans * 9 / 10);
+    report("noisy");
+    fprintf(stdout, "[ STATS    ] noisy: %u scans with a corrupt mirror matrix on the slave\n", corrupt_mirrors);
+#ifdef SPLIT_TRANSPORT_DELTA
+    // the slave only applies what it received intact
+    EXPECT_EQ(corrupt_mirrors, 0);
+#endif
+}
+
+TEST_F(SplitTransport, DroppedTransactions) {
+    split_link_config()->drop_permille = 100;
+    for (uint16_t i = 0; i < 5000; i++) {
+        make_rows(slave_rows, i);
+        make_rows(master_rows, i / 7);
+        master_side.mods = i / 13;
+        scan();
+    }
+    EXPECT_EQ(corrupt_rows, 0);
+    EXPECT_GT(synced, scans * 8 / 10);
+    report("dropped");
+
+    split_link_config()->drop_permille = 0;
+    for (int i = 0; i < 3; i++) {
+        scan();
+    }
+    EXPECT_TRUE(in_sync());
+}
+
+TEST_F(SplitTransport, RecoversAfterDisconnect) {
+    for (uint16_t i = 0; i < 100; i++) {
+        make_rows(slave_rows, i);
+        scan();
+    }
+    ASSERT_TRUE(in_sync());
+
+    split_link_config()->disconnected = true;
+    make_rows(slave_rows, 1000);
+    make_rows(master_rows, 1000);
+    master_side.mods = 0x22;
+    master_side.wpm  = 42;
+    for (int i = 0; i < 100; i++) {
+        EXPECT_FALSE(scan());
+    }
+
+    split_link_config()->disconnected = false;
+    uint32_t reconnected = timer_read32();
+    int      recovery    = 0;
+    while (!in_sync() && recovery < 100) {
+        scan();
+        recovery++;
+    }
+    EXPECT_LE(recovery, 3);
+    fprintf(stdout, "[ STATS    ] recovery: in sync %d scans, %u ms after reconnecting\n", recovery, timer_read32() - reconnected);
+}
+
+TEST_F(SplitTransport, IdleLinkTraffic) {
+    for (int i = 0; i < 10; i++) {
+        scan();
+    }
+    split_link_clear_stats();
+    scans = synced = 0;
+    for (int i = 0; i < 2000; i++) {
+        scan();
+    }
+    EXPECT_EQ(synced, scans);
+    report("idle");
+#ifdef SPLIT_TRANSPORT_DELTA
+    // only the slave matrix, plus a resync every SPLIT_TRANSPORT_RESYNC_INTERVAL
+    EXPECT_LT(split_link_stats()->bytes, scans * (sizeof(matrix_row_t) * ROWS_PER_HAND + 1));
+#endif
+}
+
+#ifdef SPLIT_TRANSPORT_USER_DATA_SIZE
+TEST_F(SplitTransport, UserDataReachesSlave) {
+    master_side.user_data[0] = 0x12;
+    master_side.user_data[3] = 0x34;
+    for (int i = 0; i < 10; i++) {
+        scan();
+    }
+    EXPECT_EQ(memcmp(slave_side.user_data, master_side.user_data, SPLIT_TRANSPORT_USER_DATA_SIZE), 0);
+    // unchanged data is not sent again until the next resync
+    EXPECT_EQ(slave_side.user_data_updates, 1);
+
+    split_link_config()->bit_error_ppm = 20000;
+    master_side.user_data[1] = 0x56;
+    for (int i = 0; i < 10; i++) {
+        scan();
+    }
+    split_link_config()->bit_error_ppm = 0;
+    scan();
+    EXPECT_EQ(memcmp(slave_side.user_data, master_side.user_data, SPLIT_TRANSPORT_USER_DATA_SIZE), 0);
+}
+#endif
+
+#ifdef RGB_MATRIX_SPLIT
+static void record_hit(uint8_t row, uint8_t col, bool pressed) {
+    memmove(&master_rgb_matrix_hits.hits[0], &master_rgb_matrix_hits.hits[1], sizeof(master_rgb_matrix_hits.hits) - sizeof(master_rgb_matrix_hits.hits[0]));
+    master_rgb_matrix_hits.hits[RGB_MATRIX_SPLIT_HITS - 1] = (rgb_matrix_split_hit_t){.row = row, .pressed = pressed, .col = col};
+    master_rgb_matrix_hits.count++;
+}
+
+TEST_F(SplitTransport, RgbMatrixFollowsMaster) {
+    master_rgb_matrix_sync.config.enable = 1;
+    master_rgb_matrix_sync.config.mode   = 3;
+    master_rgb_matrix_sync.flags         = LED_FLAG_ALL;
+    for (int i = 0; i < 10; i++) {
+        scan();
+    }
+    EXPECT_EQ(memcmp(&slave_rgb_matrix_sync, &master_rgb_matrix_sync, sizeof(rgb_matrix_syncinfo_t)), 0);
+
+    split_link_clear_stats();
+    for (int i = 0; i < 10; i++) {
+        scan();
+    }
+    // nothing changed, nothing but the slave matrix was sent
+    EXPECT_EQ(split_link_stats()->transactions, 10);
+
+    master_rgb_matrix_sync.config.hsv.h = 100;
+    master_rgb_matrix_sync.config.speed = 200;
+    master_rgb_matrix_sync.flags        = LED_FLAG_KEYLIGHT;
+    // the slave takes what it received on its next scan
+    scan();
+    scan();
+    EXPECT_EQ(memcmp(&slave_rgb_matrix_sync, &master_rgb_matrix_sync, sizeof(rgb_matrix_syncinfo_t)), 0);
+}
+
+TEST_F(SplitTransport, RgbMatrixHitsReachSlave) {
+    for (uint8_t i = 0; i < 100; i++) {
+        record_hit(i % 4, i % 8, i & 1);
+        if (i % 3 == 0) {
+            record_hit(3, 7, true);
+        }
+        scan();
+        scan();
+        EXPECT_EQ(slave_rgb_matrix_hits.count, master_rgb_matrix_hits.count);
+        EXPECT_EQ(memcmp(&slave_rgb_matrix_hits, &master_rgb_matrix_hits, sizeof(rgb_matrix_split_hits_t)), 0);
+    }
+    report("rgb matrix hits");
+}
+
+TEST_F(SplitTransport, RgbMatrixOnNoisyLink) {
+    master_rgb_matrix_sync.config.enable = 1;
+    master_rgb_matrix_sync.config.mode   = 5;
+    split_link_config()->bit_error_ppm   = 2000;
+    int corrupt = 0;
+    for (int i = 0; i < 2000; i++) {
+        record_hit(i % 4, i % 8, i & 1);
+        scan();
+        if (slave_rgb_matrix_sync.config.mode && memcmp(&slave_rgb_matrix_sync, &master_rgb_matrix_sync, sizeof(rgb_matrix_syncinfo_t)) != 0) {
+            corrupt++;
+        }
+    }
+    report("rgb matrix noisy");
+    fprintf(stdout, "[ STATS    ] rgb matrix noisy: %d scans with a corrupt RGB Matrix state on the slave\n", corrupt);
+    // the slave only takes RGB Matrix state it received intact
+    EXPECT_EQ(corrupt, 0);
+
+    split_link_config()->bit_error_ppm = 0;
+    scan();
+    scan();
+    EXPECT_EQ(memcmp(&slave_rgb_matrix_sync, &master_rgb_matrix_sync, sizeof(rgb_matrix_syncinfo_t)), 0);
+    EXPECT_EQ(slave_rgb_matrix_hits.count, master_rgb_matrix_hits.count);
+}
+#endif
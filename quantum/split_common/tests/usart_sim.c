@@ -0,0 +1,232 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "hal.h"
+#include "usart_sim.h"
+
+#define SIM_TIMERS 4
+
+UARTDriver master_UARTD1;
+UARTDriver slave_UARTD1;
+
+typedef struct {
+    UARTDriver *driver;
+    uint32_t    corrupt;  // countdown to the next character that is corrupted
+} sim_side_t;
+
+static sim_side_t sides[2] = {
+    [USART_SIM_MASTER] = {.driver = &master_UARTD1},
+    [USART_SIM_SLAVE]  = {.driver = &slave_UARTD1},
+};
+
+static virtual_timer_t *timers[SIM_TIMERS];
+static uint8_t          timer_count;
+
+static usart_sim_config_t config;
+static usart_sim_stats_t  stats;
+static uint32_t           rng_state;
+static uint64_t           now;
+
+static const usart_sim_config_t default_config = {
+    .char_time_us = 44,  // 10 bits at 230400 baud
+};
+
+// xorshift32, so every run sees the same faults
+static uint32_t sim_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+void chVTObjectInit(virtual_timer_t *vtp) {
+    vtp->func = NULL;
+    for (uint8_t i = 0; i < timer_count; i++) {
+        if (timers[i] == vtp) {
+            return;
+        }
+    }
+    if (timer_count < SIM_TIMERS) {
+        timers[timer_count++] = vtp;
+    }
+}
+
+void chVTSetI(virtual_timer_t *vtp, sysinterval_t delay, vtfunc_t vtfunc, void *par) {
+    vtp->deadline_us = now + (uint64_t)delay * 1000000 / CH_CFG_ST_FREQUENCY;
+    vtp->func        = vtfunc;
+    vtp->par         = par;
+}
+
+void chVTResetI(virtual_timer_t *vtp) { vtp->func = NULL; }
+
+void uartStart(UARTDriver *uartp, const UARTConfig *config) {
+    uartp->config  = config;
+    uartp->txstate = UART_TX_IDLE;
+    uartp->rxstate = UART_RX_IDLE;
+    uartp->txn     = 0;
+    uartp->rxn     = 0;
+}
+
+void uartStartSendI(UARTDriver *uartp, size_t n, const void *txbuf) {
+    if (uartp->txstate == UART_TX_ACTIVE) {
+        stats.send_while_busy++;
+        return;
+    }
+    uartp->txbuf   = txbuf;
+    uartp->txn     = n;
+    uartp->txstate = UART_TX_ACTIVE;
+}
+
+void uartStartReceiveI(UARTDriver *uartp, size_t n, void *rxbuf) {
+    if (uartp->rxstate == UART_RX_ACTIVE) {
+        stats.receive_while_busy++;
+        return;
+    }
+    uartp->rxbuf   = rxbuf;
+    uartp->rxn     = n;
+    uartp->rxstate = UART_RX_ACTIVE;
+}
+
+size_t uartStopReceiveI(UARTDriver *uartp) {
+    if (uartp->rxstate != UART_RX_ACTIVE) {
+        return 0;
+    }
+    uartp->rxstate = UART_RX_IDLE;
+    return uartp->rxn;
+}
+
+static void receive(UARTDriver *uartp, uint8_t c) {
+    if (uartp->config == NULL) {
+        return;
+    }
+    if (uartp->rxstate != UART_RX_ACTIVE) {
+        if (uartp->config->rxchar_cb) {
+            uartp->config->rxchar_cb(uartp, c);
+        }
+        return;
+    }
+    *uartp->rxbuf++ = c;
+    if (--uartp->rxn == 0) {
+        uartp->rxstate = UART_RX_COMPLETE;
+        if (uartp->config->rxend_cb) {
+            uartp->config->rxend_cb(uartp);
+        }
+        if (uartp->rxstate == UART_RX_COMPLETE) {
+            uartp->rxstate = UART_RX_IDLE;
+        }
+    }
+}
+
+// moves one character from side to the other half
+static void transmit(usart_sim_side_t from) {
+    UARTDriver *uartp = sides[from].driver;
+    UARTDriver *peer  = sides[from ^ 1].driver;
+    if (uartp->txstate != UART_TX_ACTIVE) {
+        return;
+    }
+
+    uint8_t c = *uartp->txbuf++;
+    stats.sent[from]++;
+    bool framing_error = false;
+    if (sides[from].corrupt && --sides[from].corrupt == 0) {
+        c ^= 1;
+        stats.corrupt++;
+    }
+    if (config.bit_error_ppm) {
+        bool corrupt = false;
+        for (uint8_t bit = 0; bit < 10; bit++) {
+            if (sim_random() % 1000000 < config.bit_error_ppm) {
+                if (bit == 0 || bit == 9) {
+                    framing_error = true;
+                } else {
+                    c ^= 1 << (bit - 1);
+                    corrupt = true;
+                }
+            }
+        }
+        stats.corrupt += corrupt && !framing_error;
+    }
+
+    if (!config.disconnected) {
+        if (!framing_error) {
+            receive(peer, c);
+        } else {
+            stats.framing_errors++;
+            if (peer->config && peer->config->rxerr_cb) {
+                peer->config->rxerr_cb(peer, UART_FRAMING_ERROR);
+            }
+        }
+    }
+
+    if (--uartp->txn == 0) {
+        uartp->txstate = UART_TX_COMPLETE;
+        if (uartp->config->txend1_cb) {
+            uartp->config->txend1_cb(uartp);
+        }
+        if (uartp->txstate == UART_TX_COMPLETE) {
+            uartp->txstate = UART_TX_IDLE;
+        }
+    }
+}
+
+static void fire_timers(void) {
+    for (uint8_t i = 0; i < timer_count; i++) {
+        virtual_timer_t *vtp = timers[i];
+        if (vtp->func && vtp->deadline_us <= now) {
+            vtfunc_t func = vtp->func;
+            vtp->func     = NULL;
+            func(vtp->par);
+        }
+    }
+}
+
+void usart_sim_run_us(uint32_t us) {
+    uint64_t until = now + us;
+    while (now + config.char_time_us <= until) {
+        now += config.char_time_us;
+        transmit(USART_SIM_MASTER);
+        transmit(USART_SIM_SLAVE);
+        fire_timers();
+    }
+    now = until;
+    fire_timers();
+}
+
+uint64_t usart_sim_now_us(void) { return now; }
+
+void usart_sim_reset(void) {
+    for (uint8_t i = 0; i < 2; i++) {
+        UARTDriver *uartp = sides[i].driver;
+        uartp->txstate    = UART_TX_IDLE;
+        uartp->rxstate    = UART_RX_IDLE;
+        uartp->txn        = 0;
+        uartp->rxn        = 0;
+        sides[i].corrupt  = 0;
+    }
+    config    = default_config;
+    rng_state = 0x2545F491;
+    usart_sim_clear_stats();
+}
+
+usart_sim_config_t *usart_sim_config(void) { return &config; }
+
+const usart_sim_stats_t *usart_sim_stats(void) { return &stats; }
+
+void usart_sim_clear_stats(void) { memset(&stats, 0, sizeof(stats)); }
+
+void usart_sim_corrupt(usart_sim_side_t side, uint32_t count) { sides[side].corrupt = count; }
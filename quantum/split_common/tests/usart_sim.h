@@ -0,0 +1,74 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Simulated UART link for drivers/chibios/serial_usart_dma.c
+ *
+ * Both halves run their own copy of the driver on their own UARTDriver, the
+ * master half as initiator, with a full duplex link in between. Every
+ * character takes char_time_us to cross, the DMA streams move one character
+ * per direction in that time and run the driver callbacks when they are
+ * done, like the ChibiOS UART driver does. Virtual timers fire in between
+ * characters. Nothing runs on its own: soft_serial_transaction() only queues
+ * its request, usart_sim_run_us() moves the link forward.
+ *
+ * A bit flipped in a data bit corrupts the character, one flipped in the
+ * start or stop bit loses it with a framing error.
+ */
+
+typedef enum {
+    USART_SIM_MASTER,
+    USART_SIM_SLAVE,
+} usart_sim_side_t;
+
+typedef struct {
+    uint16_t char_time_us;   // wire time per character
+    uint32_t bit_error_ppm;  // chance of each bit being flipped, per million
+    bool     disconnected;   // nothing gets across
+} usart_sim_config_t;
+
+typedef struct {
+    uint32_t sent[2];             // characters sent by each half
+    uint32_t corrupt;             // characters with a flipped data bit
+    uint32_t framing_errors;      // characters lost to a flipped start or stop bit
+    uint32_t send_while_busy;     // uartStartSendI() while the transmitter was busy
+    uint32_t receive_while_busy;  // uartStartReceiveI() while a receive was running
+} usart_sim_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// stops both DMA streams and restores the default config, stats and random seed
+void                     usart_sim_reset(void);
+usart_sim_config_t *     usart_sim_config(void);
+const usart_sim_stats_t *usart_sim_stats(void);
+void                     usart_sim_clear_stats(void);
+
+// the count-th character side sends from now on arrives with its lowest bit flipped, 0 cancels
+void usart_sim_corrupt(usart_sim_side_t side, uint32_t count);
+
+// lets both halves run for us microseconds
+void     usart_sim_run_us(uint32_t us);
+uint64_t usart_sim_now_us(void);
+
+#ifdef __cplusplus
+}
+#endif
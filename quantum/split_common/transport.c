@@ -16,6 +16,10 @@
 #    include "backlight.h"
 #endif
 
+#if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+#    include "rgb_matrix.h"
+#endif
+
 #ifdef ENCODER_ENABLE
 #    include "encoder.h"
 static pin_t encoders_pad[] = ENCODERS_PAD_A;
@@ -48,6 +52,12 @@ typedef struct _I2C_slave_buffer_t {
 #    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
     rgblight_syncinfo_t rgblight_sync;
 #    endif
+#    if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+    rgb_matrix_syncinfo_t rgb_matrix_sync;
+#        ifdef RGB_MATRIX_SPLIT_HITS
+    rgb_matrix_split_hits_t rgb_matrix_hits;
+#        endif
+#    endif
 #    ifdef ENCODER_ENABLE
     uint8_t encoder_state[NUMBER_OF_ENCODERS];
 #    endif
@@ -66,6 +76,8 @@ static I2C_slave_buffer_t *const i2c_buffer = (I2C_slave_buffer_t *)i2c_slave_re
 #    define I2C_ONESHOT_MODS_START offsetof(I2C_slave_buffer_t, oneshot_mods)
 #    define I2C_BACKLIGHT_START offsetof(I2C_slave_buffer_t, backlight_level)
 #    define I2C_RGB_START offsetof(I2C_slave_buffer_t, rgblight_sync)
+#    define I2C_RGB_MATRIX_START offsetof(I2C_slave_buffer_t, rgb_matrix_sync)
+#    define I2C_RGB_MATRIX_HITS_START offsetof(I2C_slave_buffer_t, rgb_matrix_hits)
 #    define I2C_ENCODER_START offsetof(I2C_slave_buffer_t, encoder_state)
 #    define I2C_WPM_START offsetof(I2C_slave_buffer_t, current_wpm)
 
@@ -102,6 +114,25 @@ bool transport_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[])
     }
 #    endif
 
+#    if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+    rgb_matrix_syncinfo_t rgb_matrix_sync;
+    rgb_matrix_get_syncinfo(&rgb_matrix_sync);
+    if (memcmp(&rgb_matrix_sync, &i2c_buffer->rgb_matrix_sync, sizeof(rgb_matrix_sync)) != 0) {
+        if (i2c_writeReg(SLAVE_I2C_ADDRESS, I2C_RGB_MATRIX_START, (void *)&rgb_matrix_sync, sizeof(rgb_matrix_sync), TIMEOUT) >= 0) {
+            i2c_buffer->rgb_matrix_sync = rgb_matrix_sync;
+        }
+    }
+#        ifdef RGB_MATRIX_SPLIT_HITS
+    rgb_matrix_split_hits_t rgb_matrix_hits;
+    rgb_matrix_get_split_hits(&rgb_matrix_hits);
+    if (rgb_matrix_hits.count != i2c_buffer->rgb_matrix_hits.count) {
+        if (i2c_writeReg(SLAVE_I2C_ADDRESS, I2C_RGB_MATRIX_HITS_START, (void *)&rgb_matrix_hits, sizeof(rgb_matrix_hits), TIMEOUT) >= 0) {
+            i2c_buffer->rgb_matrix_hits = rgb_matrix_hits;
+        }
+    }
+#        endif
+#    endif
+
 #    ifdef ENCODER_ENABLE
     i2c_readReg(SLAVE_I2C_ADDRESS, I2C_ENCODER_START, (void *)i2c_buffer->encoder_state, sizeof(i2c_buffer->encoder_state), TIMEOUT);
     encoder_update_raw(i2c_buffer->encoder_state);
@@ -171,6 +202,16 @@ void transport_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[])
     }
 #    endif
 
+#    if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+    // mode is 0 until the master has written the RGB Matrix state
+    if (i2c_buffer->rgb_matrix_sync.config.mode) {
+        rgb_matrix_update_sync(&i2c_buffer->rgb_matrix_sync);
+#        ifdef RGB_MATRIX_SPLIT_HITS
+        rgb_matrix_update_split_hits(&i2c_buffer->rgb_matrix_hits);
+#        endif
+    }
+#    endif
+
 #    ifdef ENCODER_ENABLE
     encoder_state_raw(i2c_buffer->encoder_state);
 #    endif
@@ -192,6 +233,344 @@ void transport_master_init(void) { i2c_init(); }
 
 void transport_slave_init(void) { i2c_slave_init(SLAVE_I2C_ADDRESS); }
 
+#elif defined(SPLIT_TRANSPORT_DELTA)
+
+#    include "serial.h"
+
+// Every piece of state has its own transaction and is only sent when it
+// differs from what the other side last acknowledged. Everything is sent
+// again every SPLIT_TRANSPORT_RESYNC_INTERVAL ms so that a half that was
+// reset or missed a transaction catches up.
+
+typedef struct _Serial_s2m_buffer_t {
+    matrix_row_t smatrix[ROWS_PER_HAND];
+#    ifdef ENCODER_ENABLE
+    // bumped by the slave whenever its encoder state changes
+    uint8_t      encoder_version;
+#    endif
+} Serial_s2m_buffer_t;
+
+#    ifdef SPLIT_MODS_ENABLE
+typedef struct _Serial_mods_t {
+    uint8_t real_mods;
+    uint8_t weak_mods;
+#        ifndef NO_ACTION_ONESHOT
+    uint8_t oneshot_mods;
+#        endif
+} Serial_mods_t;
+#    endif
+
+#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
+typedef struct _Serial_rgblight_t {
+    rgblight_syncinfo_t rgblight_sync;
+} Serial_rgblight_t;
+#    endif
+
+#    if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+typedef struct _Serial_rgb_matrix_t {
+    rgb_matrix_syncinfo_t   rgb_matrix_sync;
+#        ifdef RGB_MATRIX_SPLIT_HITS
+    rgb_matrix_split_hits_t rgb_matrix_hits;
+#        endif
+} Serial_rgb_matrix_t;
+#    endif
+
+enum serial_transaction_id {
+    GET_SLAVE_MATRIX = 0,
+#    ifdef ENCODER_ENABLE
+    GET_ENCODERS,
+#    endif
+#    ifndef DISABLE_SYNC_TIMER
+    PUT_SYNC_TIMER,
+#    endif
+#    ifdef SPLIT_TRANSPORT_MIRROR
+    PUT_MIRROR_MATRIX,
+#    endif
+#    ifdef SPLIT_MODS_ENABLE
+    PUT_MODS,
+#    endif
+#    ifdef BACKLIGHT_ENABLE
+    PUT_BACKLIGHT,
+#    endif
+#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
+    PUT_RGBLIGHT,
+#    endif
+#    if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+    PUT_RGB_MATRIX,
+#    endif
+#    ifdef WPM_ENABLE
+    PUT_WPM,
+#    endif
+#    ifdef SPLIT_TRANSPORT_USER_DATA_SIZE
+    PUT_USER_DATA,
+#    endif
+    NUM_TRANSACTIONS
+};
+
+volatile Serial_s2m_buffer_t serial_s2m_buffer = {};
+#    ifdef ENCODER_ENABLE
+volatile uint8_t serial_encoders[NUMBER_OF_ENCODERS] = {};
+#    endif
+#    ifndef DISABLE_SYNC_TIMER
+volatile uint32_t serial_sync_timer = 0;
+#    endif
+#    ifdef SPLIT_TRANSPORT_MIRROR
+volatile matrix_row_t serial_mmatrix[ROWS_PER_HAND] = {};
+#    endif
+#    ifdef SPLIT_MODS_ENABLE
+volatile Serial_mods_t serial_mods = {};
+#    endif
+#    ifdef BACKLIGHT_ENABLE
+volatile uint8_t serial_backlight_level = 0;
+#    endif
+#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
+volatile Serial_rgblight_t serial_rgblight = {};
+#    endif
+#    if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+volatile Serial_rgb_matrix_t serial_rgb_matrix = {};
+#    endif
+#    ifdef WPM_ENABLE
+volatile uint8_t serial_wpm = 0;
+#    endif
+#    ifdef SPLIT_TRANSPORT_USER_DATA_SIZE
+volatile uint8_t serial_user_data[SPLIT_TRANSPORT_USER_DATA_SIZE] = {};
+#    endif
+uint8_t volatile serial_status[NUM_TRANSACTIONS] = {};
+
+#    define SERIAL_GET(id, buffer) [id] = {(uint8_t *)&serial_status[id], 0, NULL, sizeof(buffer), (uint8_t *)&buffer}
+#    define SERIAL_PUT(id, buffer) [id] = {(uint8_t *)&serial_status[id], sizeof(buffer), (uint8_t *)&buffer, 0, NULL}
+
+SSTD_t transactions[] = {
+    SERIAL_GET(GET_SLAVE_MATRIX, serial_s2m_buffer),
+#    ifdef ENCODER_ENABLE
+    SERIAL_GET(GET_ENCODERS, serial_encoders),
+#    endif
+#    ifndef DISABLE_SYNC_TIMER
+    SERIAL_PUT(PUT_SYNC_TIMER, serial_sync_timer),
+#    endif
+#    ifdef SPLIT_TRANSPORT_MIRROR
+    SERIAL_PUT(PUT_MIRROR_MATRIX, serial_mmatrix),
+#    endif
+#    ifdef SPLIT_MODS_ENABLE
+    SERIAL_PUT(PUT_MODS, serial_mods),
+#    endif
+#    ifdef BACKLIGHT_ENABLE
+    SERIAL_PUT(PUT_BACKLIGHT, serial_backlight_level),
+#    endif
+#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
+    SERIAL_PUT(PUT_RGBLIGHT, serial_rgblight),
+#    endif
+#    if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+    SERIAL_PUT(PUT_RGB_MATRIX, serial_rgb_matrix),
+#    endif
+#    ifdef WPM_ENABLE
+    SERIAL_PUT(PUT_WPM, serial_wpm),
+#    endif
+#    ifdef SPLIT_TRANSPORT_USER_DATA_SIZE
+    SERIAL_PUT(PUT_USER_DATA, serial_user_data),
+#    endif
+};
+
+void transport_master_init(void) { soft_serial_initiator_init(transactions, TID_LIMIT(transactions)); }
+
+void transport_slave_init(void) { soft_serial_target_init(transactions, TID_LIMIT(transactions)); }
+
+#    ifdef SPLIT_TRANSPORT_USER_DATA_SIZE
+__attribute__((weak)) void split_transport_user_data_master(uint8_t *data) {}
+
+__attribute__((weak)) void split_transport_user_data_slave(const uint8_t *data) {}
+#    endif
+
+// Sends value through transaction id unless the slave already has it.
+// sent holds the last value the slave acknowledged and is left alone on failure,
+// so the channel is retried on the next scan.
+static bool transport_put_channel(uint8_t id, volatile void *buffer, void *sent, const void *value, uint8_t size, bool resync) {
+    if (!resync && memcmp(sent, value, size) == 0) {
+        return true;
+    }
+    memcpy((void *)buffer, value, size);
+    if (soft_serial_transaction(id) != TRANSACTION_END) {
+        return false;
+    }
+    memcpy(sent, value, size);
+    return true;
+}
+
+// Returns true once for every transaction the master has completed.
+static bool transport_channel_received(uint8_t id) {
+    if (serial_status[id] == TRANSACTION_ACCEPTED) {
+        serial_status[id] = TRANSACTION_END;
+        return true;
+    }
+    return false;
+}
+
+bool transport_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
+    static bool     synced      = false;
+    static uint32_t resync_time = 0;
+
+    bool resync = !synced || timer_elapsed32(resync_time) >= SPLIT_TRANSPORT_RESYNC_INTERVAL;
+    if (resync) {
+        resync_time = timer_read32();
+    }
+
+    if (soft_serial_transaction(GET_SLAVE_MATRIX) != TRANSACTION_END) {
+        synced = false;
+        return false;
+    }
+    synced = true;
+
+    for (int i = 0; i < ROWS_PER_HAND; ++i) {
+        slave_matrix[i] = serial_s2m_buffer.smatrix[i];
+    }
+
+#    ifdef ENCODER_ENABLE
+    static uint8_t encoder_version = 0;
+    if ((resync || serial_s2m_buffer.encoder_version != encoder_version) && soft_serial_transaction(GET_ENCODERS) == TRANSACTION_END) {
+        encoder_version = serial_s2m_buffer.encoder_version;
+        encoder_update_raw((uint8_t *)serial_encoders);
+    }
+#    endif
+
+#    ifndef DISABLE_SYNC_TIMER
+    if (resync) {
+        serial_sync_timer = sync_timer_read32() + SYNC_TIMER_OFFSET;
+        soft_serial_transaction(PUT_SYNC_TIMER);
+    }
+#    endif
+
+#    ifdef SPLIT_TRANSPORT_MIRROR
+    static matrix_row_t sent_mmatrix[ROWS_PER_HAND];
+    transport_put_channel(PUT_MIRROR_MATRIX, serial_mmatrix, sent_mmatrix, master_matrix, sizeof(sent_mmatrix), resync);
+#    endif
+
+#    ifdef SPLIT_MODS_ENABLE
+    static Serial_mods_t sent_mods;
+    Serial_mods_t        mods = {
+        .real_mods = get_mods(),
+        .weak_mods = get_weak_mods(),
+#        ifndef NO_ACTION_ONESHOT
+        .oneshot_mods = get_oneshot_mods(),
+#        endif
+    };
+    transport_put_channel(PUT_MODS, &serial_mods, &sent_mods, &mods, sizeof(mods), resync);
+#    endif
+
+#    ifdef BACKLIGHT_ENABLE
+    static uint8_t sent_backlight_level;
+    uint8_t        backlight_level = is_backlight_enabled() ? get_backlight_level() : 0;
+    transport_put_channel(PUT_BACKLIGHT, &serial_backlight_level, &sent_backlight_level, &backlight_level, sizeof(backlight_level), resync);
+#    endif
+
+#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
+    // rgblight tracks its own changes, a resync only resends the current state
+    if (rgblight_get_change_flags() || resync) {
+        rgblight_get_syncinfo((rgblight_syncinfo_t *)&serial_rgblight.rgblight_sync);
+        if (soft_serial_transaction(PUT_RGBLIGHT) == TRANSACTION_END) {
+            rgblight_clear_change_flags();
+        }
+    }
+#    endif
+
+#    if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+    static Serial_rgb_matrix_t sent_rgb_matrix;
+    Serial_rgb_matrix_t        rgb_matrix;
+    rgb_matrix_get_syncinfo(&rgb_matrix.rgb_matrix_sync);
+#        ifdef RGB_MATRIX_SPLIT_HITS
+    rgb_matrix_get_split_hits(&rgb_matrix.rgb_matrix_hits);
+#        endif
+    transport_put_channel(PUT_RGB_MATRIX, &serial_rgb_matrix, &sent_rgb_matrix, &rgb_matrix, sizeof(rgb_matrix), resync);
+#    endif
+
+#    ifdef WPM_ENABLE
+    static uint8_t sent_wpm;
+    uint8_t        wpm = get_current_wpm();
+    transport_put_channel(PUT_WPM, &serial_wpm, &sent_wpm, &wpm, sizeof(wpm), resync);
+#    endif
+
+#    ifdef SPLIT_TRANSPORT_USER_DATA_SIZE
+    static uint8_t sent_user_data[SPLIT_TRANSPORT_USER_DATA_SIZE];
+    uint8_t        user_data[SPLIT_TRANSPORT_USER_DATA_SIZE];
+    memcpy(user_data, sent_user_data, sizeof(user_data));
+    split_transport_user_data_master(user_data);
+    transport_put_channel(PUT_USER_DATA, serial_user_data, sent_user_data, user_data, sizeof(user_data), resync);
+#    endif
+
+    return true;
+}
+
+void transport_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
+    for (int i = 0; i < ROWS_PER_HAND; ++i) {
+        serial_s2m_buffer.smatrix[i] = slave_matrix[i];
+    }
+
+#    ifdef ENCODER_ENABLE
+    uint8_t encoder_state[NUMBER_OF_ENCODERS];
+    encoder_state_raw(encoder_state);
+    if (memcmp(encoder_state, (uint8_t *)serial_encoders, sizeof(encoder_state)) != 0) {
+        memcpy((uint8_t *)serial_encoders, encoder_state, sizeof(encoder_state));
+        serial_s2m_buffer.encoder_version++;
+    }
+#    endif
+
+#    ifndef DISABLE_SYNC_TIMER
+    if (transport_channel_received(PUT_SYNC_TIMER)) {
+        sync_timer_update(serial_sync_timer);
+    }
+#    endif
+
+#    ifdef SPLIT_TRANSPORT_MIRROR
+    if (transport_channel_received(PUT_MIRROR_MATRIX)) {
+        for (int i = 0; i < ROWS_PER_HAND; ++i) {
+            master_matrix[i] = serial_mmatrix[i];
+        }
+    }
+#    endif
+
+#    ifdef SPLIT_MODS_ENABLE
+    if (transport_channel_received(PUT_MODS)) {
+        set_mods(serial_mods.real_mods);
+        set_weak_mods(serial_mods.weak_mods);
+#        ifndef NO_ACTION_ONESHOT
+        set_oneshot_mods(serial_mods.oneshot_mods);
+#        endif
+    }
+#    endif
+
+#    ifdef BACKLIGHT_ENABLE
+    if (transport_channel_received(PUT_BACKLIGHT)) {
+        backlight_set(serial_backlight_level);
+    }
+#    endif
+
+#    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
+    if (transport_channel_received(PUT_RGBLIGHT)) {
+        rgblight_update_sync((rgblight_syncinfo_t *)&serial_rgblight.rgblight_sync, false);
+    }
+#    endif
+
+#    if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+    if (transport_channel_received(PUT_RGB_MATRIX)) {
+        rgb_matrix_update_sync((rgb_matrix_syncinfo_t *)&serial_rgb_matrix.rgb_matrix_sync);
+#        ifdef RGB_MATRIX_SPLIT_HITS
+        rgb_matrix_update_split_hits((rgb_matrix_split_hits_t *)&serial_rgb_matrix.rgb_matrix_hits);
+#        endif
+    }
+#    endif
+
+#    ifdef WPM_ENABLE
+    if (transport_channel_received(PUT_WPM)) {
+        set_current_wpm(serial_wpm);
+    }
+#    endif
+
+#    ifdef SPLIT_TRANSPORT_USER_DATA_SIZE
+    if (transport_channel_received(PUT_USER_DATA)) {
+        split_transport_user_data_slave((const uint8_t *)serial_user_data);
+    }
+#    endif
+}
+
 #else  // USE_SERIAL
 
 #    include "serial.h"
@@ -245,6 +624,19 @@ volatile Serial_rgblight_t serial_rgblight = {};
 uint8_t volatile status_rgblight           = 0;
 #    endif
 
+#    if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+// RGB Matrix state and the master's key hits, only sent when they change
+typedef struct _Serial_rgb_matrix_t {
+    rgb_matrix_syncinfo_t   rgb_matrix_sync;
+#        ifdef RGB_MATRIX_SPLIT_HITS
+    rgb_matrix_split_hits_t rgb_matrix_hits;
+#        endif
+} Serial_rgb_matrix_t;
+
+volatile Serial_rgb_matrix_t serial_rgb_matrix = {};
+uint8_t volatile status_rgb_matrix             = 0;
+#    endif
+
 volatile Serial_s2m_buffer_t serial_s2m_buffer = {};
 volatile Serial_m2s_buffer_t serial_m2s_buffer = {};
 uint8_t volatile status0                       = 0;
@@ -254,6 +646,9 @@ enum serial_transaction_id {
 #    if defined(RGBLIGHT_ENABLE) && defined(RGBLIGHT_SPLIT)
     PUT_RGBLIGHT,
 #    endif
+#    if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+    PUT_RGB_MATRIX,
+#    endif
 };
 
 SSTD_t transactions[] = {
@@ -271,6 +666,12 @@ SSTD_t transactions[] = {
             (uint8_t *)&status_rgblight, sizeof(serial_rgblight), (uint8_t *)&serial_rgblight, 0, NULL  // no slave to master transfer
         },
 #    endif
+#    if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+    [PUT_RGB_MATRIX] =
+        {
+            (uint8_t *)&status_rgb_matrix, sizeof(serial_rgb_matrix), (uint8_t *)&serial_rgb_matrix, 0, NULL  // no slave to master transfer
+        },
+#    endif
 };
 
 void transport_master_init(void) { soft_serial_initiator_init(transactions, TID_LIMIT(transactions)); }
@@ -302,17 +703,52 @@ void transport_rgblight_slave(void) {
 #        define transport_rgblight_slave()
 #    endif
 
+#    if defined(RGB_MATRIX_ENABLE) && defined(RGB_MATRIX_SPLIT)
+
+// RGB Matrix synchronization information communication.
+
+static void transport_rgb_matrix_master(void) {
+    static Serial_rgb_matrix_t sent;
+    Serial_rgb_matrix_t        rgb_matrix;
+    rgb_matrix_get_syncinfo(&rgb_matrix.rgb_matrix_sync);
+#        ifdef RGB_MATRIX_SPLIT_HITS
+    rgb_matrix_get_split_hits(&rgb_matrix.rgb_matrix_hits);
+#        endif
+    if (memcmp(&sent, &rgb_matrix, sizeof(rgb_matrix)) != 0) {
+        memcpy((void *)&serial_rgb_matrix, &rgb_matrix, sizeof(rgb_matrix));
+        if (soft_serial_transaction(PUT_RGB_MATRIX) == TRANSACTION_END) {
+            sent = rgb_matrix;
+        }
+    }
+}
+
+static void transport_rgb_matrix_slave(void) {
+    if (status_rgb_matrix == TRANSACTION_ACCEPTED) {
+        rgb_matrix_update_sync((rgb_matrix_syncinfo_t *)&serial_rgb_matrix.rgb_matrix_sync);
+#        ifdef RGB_MATRIX_SPLIT_HITS
+        rgb_matrix_update_split_hits((rgb_matrix_split_hits_t *)&serial_rgb_matrix.rgb_matrix_hits);
+#        endif
+        status_rgb_matrix = TRANSACTION_END;
+    }
+}
+
+#    else
+#        define transport_rgb_matrix_master()
+#        define transport_rgb_matrix_slave()
+#    endif
+
 bool transport_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
+    // The master to slave half changes every scan, a pending one still brings a valid slave matrix
 #    ifndef SERIAL_USE_MULTI_TRANSACTION
-    if (soft_serial_transaction() != TRANSACTION_END) {
-        return false;
-    }
+    int result = soft_serial_transaction();
 #    else
     transport_rgblight_master();
-    if (soft_serial_transaction(GET_SLAVE_MATRIX) != TRANSACTION_END) {
+    transport_rgb_matrix_master();
+    int result = soft_serial_transaction(GET_SLAVE_MATRIX);
+#    endif
+    if (result != TRANSACTION_END && result != TRANSACTION_PENDING) {
         return false;
     }
-#    endif
 
     // TODO:  if MATRIX_COLS > 8 change to unpack()
     for (int i = 0; i < ROWS_PER_HAND; ++i) {
@@ -351,6 +787,7 @@ bool transport_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[])
 
 void transport_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]) {
     transport_rgblight_slave();
+    transport_rgb_matrix_slave();
 #    ifndef DISABLE_SYNC_TIMER
     sync_timer_update(serial_m2s_buffer.sync_timer);
 #    endif
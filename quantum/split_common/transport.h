@@ -8,3 +8,10 @@ void transport_slave_init(void);
 // returns false if valid data not received from slave
 bool transport_master(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]);
 void transport_slave(matrix_row_t master_matrix[], matrix_row_t slave_matrix[]);
+
+#ifdef SPLIT_TRANSPORT_USER_DATA_SIZE
+// called on the master every scan to fill in the data kept in sync with the slave
+void split_transport_user_data_master(uint8_t *data);
+// called on the slave whenever new data has been received from the master
+void split_transport_user_data_slave(const uint8_t *data);
+#endif
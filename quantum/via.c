@@ -44,9 +44,14 @@
 
 #include "raw_hid.h"
 #include "dynamic_keymap.h"
+#include "task_profile.h"
+#ifdef LATENCY_TRACE_ENABLE
+#    include "latency_trace.h"
+#endif
 #include "tmk_core/common/eeprom.h"
 #include "version.h"  // for QMK_BUILDDATE used in EEPROM magic
 #include "via_ensure_keycode.h"
+#include <string.h>
 
 // Forward declare some helpers.
 #if defined(VIA_QMK_BACKLIGHT_ENABLE)
@@ -59,6 +64,90 @@ void via_qmk_rgblight_set_value(uint8_t *data);
 void via_qmk_rgblight_get_value(uint8_t *data);
 #endif
 
+// A bulk transfer streams a range of the dynamic keymap buffer in numbered
+// packets into a staging buffer, then checks a CRC over the whole range. Only
+// a matching transfer is copied into the keymap and written out in one flush,
+// so the keymap in use never holds part of a transfer. It needs
+// DYNAMIC_KEYMAP_RAM_CACHE; without it the bulk commands are answered as unhandled.
+#if defined(VIA_BULK_TRANSFER_ENABLE) && defined(DYNAMIC_KEYMAP_RAM_CACHE)
+#    define VIA_BULK_TRANSFER
+
+// Largest range a single transfer can carry, defaults to the whole keymap
+#    ifndef VIA_BULK_TRANSFER_SIZE
+#        define VIA_BULK_TRANSFER_SIZE (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2)
+#    endif
+
+static uint8_t  bulk_staging[VIA_BULK_TRANSFER_SIZE];
+static bool     bulk_active   = false;
+static uint16_t bulk_offset   = 0;
+static uint16_t bulk_size     = 0;
+static uint16_t bulk_received = 0;
+static uint16_t bulk_sequence = 0;
+
+// CRC-16/CCITT-FALSE
+static uint16_t via_crc16_update(uint16_t crc, uint8_t data) {
+    crc ^= (uint16_t)data << 8;
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
+
+static uint8_t via_bulk_begin(uint16_t offset, uint16_t size) {
+    // Starting over drops whatever an unfinished transfer sent
+    bulk_active          = false;
+    uint16_t keymap_size = dynamic_keymap_get_layer_count() * MATRIX_ROWS * MATRIX_COLS * 2;
+    if (size == 0 || size > VIA_BULK_TRANSFER_SIZE || offset >= keymap_size || size > keymap_size - offset) {
+        return bulk_status_range;
+    }
+    bulk_active   = true;
+    bulk_offset   = offset;
+    bulk_size     = size;
+    bulk_received = 0;
+    bulk_sequence = 0;
+    return bulk_status_ok;
+}
+
+static uint8_t via_bulk_write(uint16_t sequence, uint8_t *data, uint8_t length) {
+    if (!bulk_active) {
+        return bulk_status_not_active;
+    }
+    if (sequence != bulk_sequence) {
+        // A packet went missing, the host has to start over
+        bulk_active = false;
+        return bulk_status_sequence;
+    }
+    uint16_t count = bulk_size - bulk_received;
+    if (count > length) {
+        count = length;
+    }
+    memcpy(&bulk_staging[bulk_received], data, count);
+    bulk_received += count;
+    bulk_sequence++;
+    return bulk_status_ok;
+}
+
+static uint8_t via_bulk_commit(uint16_t crc, uint16_t *received_crc) {
+    if (!bulk_active) {
+        return bulk_status_not_active;
+    }
+    bulk_active = false;
+    if (bulk_received != bulk_size) {
+        return bulk_status_incomplete;
+    }
+    *received_crc = 0xFFFF;
+    for (uint16_t i = 0; i < bulk_size; i++) {
+        *received_crc = via_crc16_update(*received_crc, bulk_staging[i]);
+    }
+    if (*received_crc != crc) {
+        return bulk_status_crc;
+    }
+    dynamic_keymap_set_buffer(bulk_offset, bulk_size, bulk_staging);
+    dynamic_keymap_flush();
+    return bulk_status_ok;
+}
+#endif
+
 // Can be called in an overriding via_init_kb() to test if keyboard level code usage of
 // EEPROM is invalid and use/save defaults.
 bool via_eeprom_is_valid(void) {
@@ -110,6 +199,9 @@ void via_init(void) {
     // If the EEPROM has the magic, the data is good.
     // OK to load from EEPROM.
     if (via_eeprom_is_valid()) {
+#ifdef DYNAMIC_KEYMAP_RAM_CACHE
+        dynamic_keymap_cache_load();
+#endif
     } else {
         // This resets the layout options
         via_set_layout_options(VIA_EEPROM_LAYOUT_OPTIONS_DEFAULT);
@@ -246,6 +338,54 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
 #endif
                     break;
                 }
+#ifdef TASK_PROFILE_ENABLE
+                case id_task_profile: {
+                    // command_data[1] selects the stage, the reply is its last summary
+                    const task_profile_summary_t *summary = task_profile_get(command_data[1]);
+                    if (!summary) {
+                        *command_id = id_unhandled;
+                        break;
+                    }
+                    uint32_t values[] = {task_profile_ticks_per_ms(), summary->count, summary->min, summary->avg, summary->max, summary->p99};
+                    uint8_t  i        = 2;
+                    for (uint8_t v = 0; v < sizeof(values) / sizeof(values[0]); v++) {
+                        command_data[i++] = (values[v] >> 24) & 0xFF;
+                        command_data[i++] = (values[v] >> 16) & 0xFF;
+                        command_data[i++] = (values[v] >> 8) & 0xFF;
+                        command_data[i++] = values[v] & 0xFF;
+                    }
+                    break;
+                }
+#endif
+#ifdef LATENCY_TRACE_ENABLE
+                case id_latency_summary: {
+                    const latency_trace_t *trace = latency_trace_get();
+                    uint16_t               avg   = trace->count ? trace->total / trace->count : 0;
+                    command_data[1]              = (trace->count >> 24) & 0xFF;
+                    command_data[2]              = (trace->count >> 16) & 0xFF;
+                    command_data[3]              = (trace->count >> 8) & 0xFF;
+                    command_data[4]              = trace->count & 0xFF;
+                    command_data[5]              = avg >> 8;
+                    command_data[6]              = avg & 0xFF;
+                    command_data[7]              = trace->max >> 8;
+                    command_data[8]              = trace->max & 0xFF;
+                    command_data[9]              = LATENCY_TRACE_BUCKETS;
+                    break;
+                }
+                case id_latency_histogram: {
+                    // command_data[1] is the first bucket, the reply carries as many (floor, count) pairs as fit
+                    const latency_trace_t *trace = latency_trace_get();
+                    uint8_t                i     = 2;
+                    for (uint8_t bucket = command_data[1]; bucket < LATENCY_TRACE_BUCKETS && i + 4 <= length - 1; bucket++) {
+                        uint16_t floor    = latency_trace_bucket_floor(bucket);
+                        command_data[i++] = floor >> 8;
+                        command_data[i++] = floor & 0xFF;
+                        command_data[i++] = trace->histogram[bucket] >> 8;
+                        command_data[i++] = trace->histogram[bucket] & 0xFF;
+                    }
+                    break;
+                }
+#endif
                 default: {
                     raw_hid_receive_kb(data, length);
                     break;
@@ -260,6 +400,12 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
                     via_set_layout_options(value);
                     break;
                 }
+#ifdef LATENCY_TRACE_ENABLE
+                case id_latency_histogram: {
+                    latency_trace_clear();
+                    break;
+                }
+#endif
                 default: {
                     raw_hid_receive_kb(data, length);
                     break;
@@ -371,6 +517,28 @@ void raw_hid_receive(uint8_t *data, uint8_t length) {
             dynamic_keymap_set_buffer(offset, size, &command_data[3]);
             break;
         }
+#ifdef VIA_BULK_TRANSFER
+        case id_dynamic_keymap_bulk_begin: {
+            uint16_t offset = (command_data[0] << 8) | command_data[1];
+            uint16_t size   = (command_data[2] << 8) | command_data[3];
+            command_data[0] = via_bulk_begin(offset, size);
+            command_data[1] = length - 3;  // data bytes in each bulk write
+            break;
+        }
+        case id_dynamic_keymap_bulk_write: {
+            uint16_t sequence = (command_data[0] << 8) | command_data[1];
+            command_data[2]   = via_bulk_write(sequence, &command_data[2], length - 3);
+            break;
+        }
+        case id_dynamic_keymap_bulk_commit: {
+            uint16_t crc          = (command_data[0] << 8) | command_data[1];
+            uint16_t received_crc = 0;
+            command_data[2]       = via_bulk_commit(crc, &received_crc);
+            command_data[3]       = received_crc >> 8;
+            command_data[4]       = received_crc & 0xFF;
+            break;
+        }
+#endif
         default: {
             // The command ID is not known
             // Return the unhandled state
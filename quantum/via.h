@@ -78,13 +78,29 @@ enum via_command_id {
     id_dynamic_keymap_get_layer_count       = 0x11,
     id_dynamic_keymap_get_buffer            = 0x12,
     id_dynamic_keymap_set_buffer            = 0x13,
+    id_dynamic_keymap_bulk_begin            = 0x20,
+    id_dynamic_keymap_bulk_write            = 0x21,
+    id_dynamic_keymap_bulk_commit           = 0x22,
     id_unhandled                            = 0xFF,
 };
 
+// Status returned by the bulk transfer commands
+enum via_bulk_status {
+    bulk_status_ok         = 0x00,
+    bulk_status_not_active = 0x01,
+    bulk_status_range      = 0x02,
+    bulk_status_sequence   = 0x03,
+    bulk_status_incomplete = 0x04,
+    bulk_status_crc        = 0x05,
+};
+
 enum via_keyboard_value_id {
     id_uptime              = 0x01,  //
     id_layout_options      = 0x02,
-    id_switch_matrix_state = 0x03
+    id_switch_matrix_state = 0x03,
+    id_task_profile        = 0x04,
+    id_latency_summary     = 0x05,
+    id_latency_histogram   = 0x06,
 };
 
 enum via_lighting_value {
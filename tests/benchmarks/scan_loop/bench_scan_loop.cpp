@@ -0,0 +1,222 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Replays recorded keystroke traces through keyboard_task().
+ *
+ * A trace is a text file with one matrix event per line:
+ *
+ *     <virtual time in ms> <row> <col> <d|u>
+ *
+ * Lines starting with '#' are ignored, events must be sorted by time. Each
+ * trace is replayed one virtual millisecond per scan, and the benchmark reports
+ * the host cost of a scan, the cost of the scans that carried matrix changes,
+ * and how many virtual milliseconds input waited before a report was emitted.
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+
+#include "test_matrix.h"
+
+extern "C" {
+#include "keyboard.h"
+#include "host.h"
+#include "action_layer.h"
+#include "action_util.h"
+#include "action_tapping.h"
+#include "timer.h"
+
+void set_time(uint32_t t);
+void advance_time(uint32_t ms);
+}
+
+#ifndef BENCH_SETTLE_TIME
+#    define BENCH_SETTLE_TIME (TAPPING_TERM * 2)
+#endif
+
+#ifndef BENCH_REPETITIONS
+#    define BENCH_REPETITIONS 20
+#endif
+
+typedef std::chrono::steady_clock bench_clock;
+
+struct trace_event_t {
+    uint32_t time;
+    uint8_t  row;
+    uint8_t  col;
+    bool     pressed;
+};
+
+struct stats_t {
+    uint64_t count = 0;
+    uint64_t total = 0;
+    uint64_t min   = UINT64_MAX;
+    uint64_t max   = 0;
+
+    void add(uint64_t value) {
+        count++;
+        total += value;
+        if (value < min) min = value;
+        if (value > max) max = value;
+    }
+    uint64_t avg(void) const { return count ? total / count : 0; }
+};
+
+// Virtual time of the oldest matrix change that has not yet produced a report
+static bool     input_pending      = false;
+static uint32_t input_pending_time = 0;
+static stats_t  report_latency;
+static uint32_t reports_sent = 0;
+
+static uint8_t bench_keyboard_leds(void) { return 0; }
+
+static void bench_send_keyboard(report_keyboard_t *report) {
+    reports_sent++;
+    if (input_pending) {
+        report_latency.add(timer_read32() - input_pending_time);
+        input_pending = false;
+    }
+}
+
+static void bench_send_mouse(report_mouse_t *report) {}
+static void bench_send_system(uint16_t data) {}
+static void bench_send_consumer(uint16_t data) {}
+
+static host_driver_t bench_driver = {bench_keyboard_leds, bench_send_keyboard, bench_send_mouse, bench_send_system, bench_send_consumer};
+
+static bool load_trace(const char *path, std::vector<trace_event_t> &events) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "%s: cannot open trace\n", path);
+        return false;
+    }
+
+    char     line[128];
+    unsigned line_no = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line_no++;
+        if (line[0] == '#' || line[0] == '\n') continue;
+
+        unsigned time, row, col;
+        char     state;
+        if (sscanf(line, "%u %u %u %c", &time, &row, &col, &state) != 4 || row >= MATRIX_ROWS || col >= MATRIX_COLS || (state != 'd' && state != 'u') || (!events.empty() && time < events.back().time)) {
+            fprintf(stderr, "%s:%u: malformed event\n", path, line_no);
+            fclose(file);
+            return false;
+        }
+        events.push_back(trace_event_t{time, (uint8_t)row, (uint8_t)col, state == 'd'});
+    }
+    fclose(file);
+    return true;
+}
+
+static uint64_t timed_scan(void) {
+    bench_clock::time_point start = bench_clock::now();
+    keyboard_task();
+    bench_clock::time_point end = bench_clock::now();
+    advance_time(1);
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+static void settle(void) {
+    clear_all_keys();
+    layer_clear();
+    clear_keyboard();
+    for (uint32_t i = 0; i < BENCH_SETTLE_TIME; i++) {
+        keyboard_task();
+        advance_time(1);
+    }
+    input_pending = false;
+}
+
+static void replay(const char *path, const std::vector<trace_event_t> &events) {
+    stats_t  idle_scan, event_scan;
+    uint64_t event_count = 0;
+
+    report_latency = stats_t();
+    reports_sent   = 0;
+
+    for (unsigned rep = 0; rep < BENCH_REPETITIONS; rep++) {
+        settle();
+
+        uint32_t start = timer_read32();
+        size_t   next  = 0;
+        while (next < events.size()) {
+            uint32_t now     = timer_read32() - start;
+            unsigned changes = 0;
+            for (; next < events.size() && events[next].time <= now; next++, changes++) {
+                if (events[next].pressed) {
+                    press_key(events[next].col, events[next].row);
+                } else {
+                    release_key(events[next].col, events[next].row);
+                }
+            }
+            if (changes && !input_pending) {
+                input_pending      = true;
+                input_pending_time = timer_read32();
+            }
+
+            uint64_t ns = timed_scan();
+            if (changes) {
+                event_scan.add(ns);
+                event_count += changes;
+            } else {
+                idle_scan.add(ns);
+            }
+        }
+        // let tap-hold, combos and auto-shift resolve what is still buffered
+        for (uint32_t i = 0; i < BENCH_SETTLE_TIME; i++) {
+            idle_scan.add(timed_scan());
+        }
+    }
+
+    uint64_t scans = idle_scan.count + event_scan.count;
+    uint64_t total = idle_scan.total + event_scan.total;
+    // what a scan costs on top of an idle one, spread over the events it carried
+    int64_t per_event = event_count ? ((int64_t)event_scan.total - (int64_t)(idle_scan.avg() * event_scan.count)) / (int64_t)event_count : 0;
+
+    printf("%s\n", path);
+    printf("  events %lu, scans %lu, reports %u (x%u repetitions)\n", (unsigned long)(event_count / BENCH_REPETITIONS), (unsigned long)(scans / BENCH_REPETITIONS), reports_sent / BENCH_REPETITIONS, BENCH_REPETITIONS);
+    printf("  ns/scan          avg %8lu\n", (unsigned long)(scans ? total / scans : 0));
+    printf("  ns/idle scan     avg %8lu  min %8lu  max %8lu\n", (unsigned long)idle_scan.avg(), (unsigned long)idle_scan.min, (unsigned long)idle_scan.max);
+    printf("  ns/event scan    avg %8lu  min %8lu  max %8lu\n", (unsigned long)event_scan.avg(), (unsigned long)(event_scan.count ? event_scan.min : 0), (unsigned long)event_scan.max);
+    printf("  ns/event         avg %8ld\n", (long)per_event);
+    printf("  report latency   avg %8lu  min %8lu  max %8lu  (virtual ms)\n", (unsigned long)report_latency.avg(), (unsigned long)(report_latency.count ? report_latency.min : 0), (unsigned long)report_latency.max);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <trace>...\n", argv[0]);
+        return 1;
+    }
+
+    host_set_driver(&bench_driver);
+    set_time(0);
+    keyboard_init();
+
+    int result = 0;
+    for (int i = 1; i < argc; i++) {
+        std::vector<trace_event_t> events;
+        if (!load_trace(argv[i], events)) {
+            result = 1;
+            continue;
+        }
+        replay(argv[i], events);
+    }
+    return result;
+}
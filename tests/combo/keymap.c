@@ -0,0 +1,45 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "quantum.h"
+
+const uint16_t PROGMEM keymaps[][MATRIX_ROWS][MATRIX_COLS] = {
+    [0] =
+        {
+            // 0    1     2     3     4     5     6      7      8      9
+            {KC_A, KC_B, KC_C, KC_D, KC_E, KC_F, KC_NO, KC_NO, KC_NO, KC_NO},
+            {KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},
+            {KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},
+            {KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO, KC_NO},
+        },
+};
+
+const uint16_t PROGMEM ab_combo[]  = {KC_A, KC_B, COMBO_END};
+const uint16_t PROGMEM bc_combo[]  = {KC_B, KC_C, COMBO_END};
+const uint16_t PROGMEM cde_combo[] = {KC_C, KC_D, KC_E, COMBO_END};
+const uint16_t PROGMEM abc_combo[] = {KC_A, KC_B, KC_C, COMBO_END};
+// listed out of keycode order
+const uint16_t PROGMEM eda_combo[] = {KC_E, KC_D, KC_A, COMBO_END};
+
+combo_t key_combos[COMBO_COUNT] = {
+    COMBO(ab_combo, KC_X),
+    COMBO(bc_combo, KC_Y),
+    COMBO(cde_combo, KC_Z),
+    COMBO(eda_combo, KC_W),
+    COMBO(abc_combo, KC_V),
+};
+
+uint16_t get_combo_term(uint16_t combo_index, combo_t *combo) { return combo->keys == cde_combo ? COMBO_TERM * 2 : COMBO_TERM; }
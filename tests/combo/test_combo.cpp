@@ -0,0 +1,242 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::InSequence;
+
+class Combo : public TestFixture {};
+
+// Kept first, so the combo is the first key event after keyboard_init()
+TEST_F(Combo, ComboSendsItsKeycode) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    press_key(2, 0);
+    run_one_scan_loop();
+    press_key(3, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Z)));
+    press_key(4, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release_key(2, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // the other keys of the combo are swallowed
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    release_key(3, 0);
+    release_key(4, 0);
+    idle_for(COMBO_TERM);
+}
+
+TEST_F(Combo, ComboKeysListedOutOfOrderAreFound) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    press_key(4, 0);
+    run_one_scan_loop();
+    press_key(0, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_W)));
+    press_key(3, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(testing::AtLeast(1));
+    release_key(4, 0);
+    release_key(0, 0);
+    release_key(3, 0);
+    idle_for(COMBO_TERM);
+}
+
+TEST_F(Combo, KeyOutsideCombosIsNotBuffered) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_F)));
+    press_key(5, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release_key(5, 0);
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, UnfinishedComboKeyIsSentAfterComboTerm) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    press_key(1, 0);
+    run_one_scan_loop();
+    idle_for(COMBO_TERM);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    idle_for(2);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release_key(1, 0);
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, LongestComboWins) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    press_key(0, 0);
+    run_one_scan_loop();
+    press_key(1, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_V)));
+    press_key(2, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release_key(0, 0);
+    release_key(1, 0);
+    release_key(2, 0);
+    idle_for(3);
+}
+
+TEST_F(Combo, ShorterComboFiresWhenLongerOneTimesOut) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    press_key(0, 0);
+    run_one_scan_loop();
+    press_key(1, 0);
+    run_one_scan_loop();
+    idle_for(COMBO_TERM - 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    idle_for(2);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release_key(0, 0);
+    release_key(1, 0);
+    idle_for(2);
+}
+
+TEST_F(Combo, ShorterComboFiresWhenAnotherKeyIsPressed) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 0);
+    run_one_scan_loop();
+    press_key(1, 0);
+    run_one_scan_loop();
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X, KC_F)));
+    press_key(5, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(testing::AnyNumber());
+    release_key(0, 0);
+    release_key(1, 0);
+    release_key(5, 0);
+    idle_for(3);
+}
+
+TEST_F(Combo, ShorterComboIsTappedWhenItsKeyIsReleased) {
+    TestDriver driver;
+    InSequence s;
+    press_key(0, 0);
+    run_one_scan_loop();
+    press_key(1, 0);
+    run_one_scan_loop();
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release_key(0, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // the other key of the combo is swallowed
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    release_key(1, 0);
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, UnmatchedKeysAreReplayedInOrder) {
+    TestDriver driver;
+    InSequence s;
+    // A and C are both part of A+B+C, which times out
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    press_key(0, 0);
+    run_one_scan_loop();
+    press_key(2, 0);
+    run_one_scan_loop();
+    idle_for(COMBO_TERM);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_C)));
+    idle_for(2);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // combos stay off until the keys are released
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_C, KC_B)));
+    press_key(1, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(3);
+    release_key(0, 0);
+    run_one_scan_loop();
+    release_key(1, 0);
+    run_one_scan_loop();
+    release_key(2, 0);
+    run_one_scan_loop();
+}
+
+TEST_F(Combo, ComboTermCanBeSetPerCombo) {
+    TestDriver driver;
+    InSequence s;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    press_key(2, 0);
+    run_one_scan_loop();
+    idle_for(COMBO_TERM + 10);
+    press_key(3, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Z)));
+    press_key(4, 0);
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    release_key(2, 0);
+    release_key(3, 0);
+    release_key(4, 0);
+    idle_for(3);
+}
@@ -0,0 +1,104 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "dynamic_keymap.h"
+#include "eeprom.h"
+}
+
+using testing::_;
+using testing::AnyNumber;
+
+class DynamicKeymapCache : public TestFixture {
+   protected:
+    void TearDown() override {
+        dynamic_keymap_reset();
+        TestFixture::TearDown();
+    }
+
+    // keycode as currently stored in EEPROM, big endian
+    uint16_t eeprom_keycode(uint8_t layer, uint8_t row, uint8_t col) {
+        uint8_t *address = (uint8_t *)dynamic_keymap_key_to_eeprom_address(layer, row, col);
+        return (eeprom_read_byte(address) << 8) | eeprom_read_byte(address + 1);
+    }
+};
+
+TEST_F(DynamicKeymapCache, ResetWritesThroughImmediately) {
+    EXPECT_EQ(eeprom_keycode(0, 0, 0), KC_A);
+    EXPECT_EQ(eeprom_keycode(1, 0, 1), KC_X);
+}
+
+TEST_F(DynamicKeymapCache, EditsAreUsedBeforeTheyAreWrittenBack) {
+    TestDriver driver;
+    dynamic_keymap_set_keycode(0, 0, 0, KC_Z);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_Z);
+    EXPECT_EQ(eeprom_keycode(0, 0, 0), KC_A);
+
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Z)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    EXPECT_EQ(eeprom_keycode(0, 0, 0), KC_A);
+}
+
+TEST_F(DynamicKeymapCache, EditsAreWrittenBackAfterDelay) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+
+    uint8_t buffer[4] = {0x00, KC_C, 0x00, KC_D};
+    dynamic_keymap_set_buffer(0, sizeof(buffer), buffer);
+    idle_for(50);
+    // further edits push the write back out
+    dynamic_keymap_set_keycode(1, 3, 9, KC_E);
+    idle_for(90);
+    EXPECT_EQ(eeprom_keycode(0, 0, 0), KC_A);
+    EXPECT_EQ(eeprom_keycode(1, 3, 9), KC_TRNS);
+
+    idle_for(20);
+    EXPECT_EQ(eeprom_keycode(0, 0, 0), KC_C);
+    EXPECT_EQ(eeprom_keycode(0, 0, 1), KC_D);
+    EXPECT_EQ(eeprom_keycode(1, 3, 9), KC_E);
+}
+
+TEST_F(DynamicKeymapCache, FlushWritesBackImmediately) {
+    dynamic_keymap_set_keycode(0, 0, 1, KC_Y);
+    dynamic_keymap_flush();
+    EXPECT_EQ(eeprom_keycode(0, 0, 1), KC_Y);
+}
+
+TEST_F(DynamicKeymapCache, BufferReadsComeFromCache) {
+    dynamic_keymap_set_keycode(1, 0, 1, KC_Q);
+    uint8_t buffer[2];
+    dynamic_keymap_get_buffer(MATRIX_ROWS * MATRIX_COLS * 2 + 2, sizeof(buffer), buffer);
+    EXPECT_EQ(buffer[0], 0x00);
+    EXPECT_EQ(buffer[1], KC_Q);
+}
+
+TEST_F(DynamicKeymapCache, DroppedHoldKeepsEarlierEdits) {
+    dynamic_keymap_set_keycode(0, 0, 1, KC_Y);
+    dynamic_keymap_hold();
+    EXPECT_EQ(eeprom_keycode(0, 0, 1), KC_Y);
+
+    dynamic_keymap_set_keycode(1, 0, 1, KC_Q);
+    dynamic_keymap_release(false);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 1), KC_Y);
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 0, 1), KC_X);
+    EXPECT_EQ(eeprom_keycode(1, 0, 1), KC_X);
+}
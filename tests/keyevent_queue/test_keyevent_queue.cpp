@@ -0,0 +1,86 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+using testing::_;
+using testing::InSequence;
+
+class KeyeventQueue : public TestFixture {};
+
+TEST_F(KeyeventQueue, ChordIsDeliveredInOneScan) {
+    TestDriver driver;
+    InSequence s;
+    press_key(1, 0);
+    press_key(0, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B, KC_C)));
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(1, 0);
+    release_key(0, 3);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    keyboard_task();
+}
+
+TEST_F(KeyeventQueue, ModifierIsDeliveredWithKeyInOneScan) {
+    TestDriver driver;
+    InSequence s;
+    press_key(3, 0);
+    press_key(0, 0);
+    // matrix order is kept, so the modifier still follows the key
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_LSFT)));
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(3, 0);
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    keyboard_task();
+}
+
+TEST_F(KeyeventQueue, ChangesBeyondQueueSizeArriveOnNextScan) {
+    TestDriver driver;
+    InSequence s;
+    // six keys with a four entry queue
+    press_key(0, 0);
+    press_key(1, 0);
+    press_key(4, 0);
+    press_key(5, 0);
+    press_key(6, 0);
+    press_key(7, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_E)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_E, KC_F)));
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_E, KC_F, KC_G)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A, KC_B, KC_E, KC_F, KC_G, KC_H)));
+    keyboard_task();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    clear_all_keys();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(4);
+    keyboard_task();
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(2);
+    keyboard_task();
+}
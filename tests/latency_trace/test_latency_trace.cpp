@@ -0,0 +1,118 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "latency_trace.h"
+}
+
+using testing::_;
+using testing::InSequence;
+
+class LatencyTrace : public TestFixture {
+   protected:
+    void SetUp() override { latency_trace_clear(); }
+};
+
+TEST_F(LatencyTrace, KeyReportedInSameScanHasNoLatency) {
+    TestDriver driver;
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+
+    const latency_trace_t *trace = latency_trace_get();
+    EXPECT_EQ(trace->count, 1);
+    EXPECT_EQ(trace->max, 0);
+    EXPECT_EQ(trace->histogram[0], 1);
+
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    EXPECT_EQ(trace->count, 2);
+}
+
+TEST_F(LatencyTrace, TapIsCountedFromItsPress) {
+    TestDriver driver;
+    InSequence s;
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(50);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    // the buffered press is replayed when the release resolves the tap
+    release_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+
+    const latency_trace_t *trace = latency_trace_get();
+    EXPECT_EQ(trace->count, 2);
+    EXPECT_EQ(trace->max, 50);
+    EXPECT_EQ(trace->histogram[0], 1);
+    EXPECT_EQ(latency_trace_bucket_floor(11), 48);
+    EXPECT_EQ(trace->histogram[11], 1);
+}
+
+TEST_F(LatencyTrace, LayerKeyIsNotBlamedForLaterReport) {
+    TestDriver driver;
+    InSequence s;
+    press_key(2, 0);
+    // the layer change clears the report
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(100);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)));
+    run_one_scan_loop();
+    EXPECT_EQ(latency_trace_get()->max, 0);
+
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+
+    release_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(LatencyTrace, BucketFloorsAreIncreasing) {
+    for (uint8_t bucket = 1; bucket < LATENCY_TRACE_BUCKETS; bucket++) {
+        EXPECT_GT(latency_trace_bucket_floor(bucket), latency_trace_bucket_floor(bucket - 1));
+    }
+    EXPECT_EQ(latency_trace_bucket_floor(4), 4);
+    EXPECT_EQ(latency_trace_bucket_floor(5), 6);
+    EXPECT_EQ(latency_trace_bucket_floor(LATENCY_TRACE_BUCKETS - 1), 192);
+}
+
+TEST_F(LatencyTrace, QueuedReportCountsUntilItIsSent) {
+    keyevent_t event = {.key = {.col = 0, .row = 0}, .pressed = true, .time = (uint16_t)(timer_read() | 1)};
+    latency_trace_event(event);
+    wait_ms(2);
+
+    // a queueing driver takes the latency when the report is submitted...
+    uint16_t latency = 0;
+    EXPECT_TRUE(latency_trace_take(&latency));
+    EXPECT_EQ(latency, 2);
+    EXPECT_FALSE(latency_trace_take(&latency));
+
+    // ...and adds the time the report waited before it started on the endpoint
+    latency_trace_add(latency + 3);
+    const latency_trace_t *trace = latency_trace_get();
+    EXPECT_EQ(trace->count, 1);
+    EXPECT_EQ(trace->max, 5);
+}
@@ -0,0 +1,107 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "action_layer.h"
+
+extern uint16_t test_keymaps[3][MATRIX_ROWS][MATRIX_COLS];
+extern uint32_t test_keymap_lookups;
+}
+
+using testing::_;
+using testing::AnyNumber;
+
+class LayerCache : public TestFixture {};
+
+TEST_F(LayerCache, TransparentKeysResolveThroughActiveLayers) {
+    TestDriver driver;
+
+    press_key(2, 0);
+    // layer changes only resend the empty report
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(AnyNumber());
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    run_one_scan_loop();
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X, KC_A)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    release_key(0, 0);
+    release_key(1, 0);
+    release_key(2, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    idle_for(3);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    press_key(1, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    run_one_scan_loop();
+}
+
+TEST_F(LayerCache, RepeatedLookupsAreServedFromCache) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    keypos_t key = {.col = 0, .row = 0};
+
+    layer_on(1);
+    layer_on(2);
+    EXPECT_EQ(layer_switch_get_layer(key), 2);
+    uint32_t lookups = test_keymap_lookups;
+    EXPECT_EQ(layer_switch_get_layer(key), 2);
+    EXPECT_EQ(test_keymap_lookups, lookups);
+
+    key.col = 1;
+    EXPECT_EQ(layer_switch_get_layer(key), 1);
+    lookups = test_keymap_lookups;
+    EXPECT_EQ(layer_switch_get_layer(key), 1);
+    EXPECT_EQ(test_keymap_lookups, lookups);
+}
+
+TEST_F(LayerCache, LayerStateChangesAreDetected) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    keypos_t key = {.col = 0, .row = 0};
+
+    EXPECT_EQ(layer_switch_get_layer(key), 0);
+    layer_on(2);
+    EXPECT_EQ(layer_switch_get_layer(key), 2);
+    // written without layer_state_set, like process_dynamic_macro does
+    layer_state = 0;
+    EXPECT_EQ(layer_switch_get_layer(key), 0);
+}
+
+TEST_F(LayerCache, ClearPicksUpKeymapChanges) {
+    TestDriver driver;
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(AnyNumber());
+    keypos_t key = {.col = 1, .row = 0};
+
+    layer_on(2);
+    EXPECT_EQ(layer_switch_get_layer(key), 0);
+
+    test_keymaps[2][0][1] = KC_Y;
+    EXPECT_EQ(layer_switch_get_layer(key), 0);
+    layer_resolution_cache_clear();
+    EXPECT_EQ(layer_switch_get_layer(key), 2);
+
+    test_keymaps[2][0][1] = KC_TRNS;
+    layer_resolution_cache_clear();
+}
@@ -0,0 +1,160 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <vector>
+#include "test_common.hpp"
+
+extern "C" {
+#include "rgb_matrix.h"
+}
+
+static bool master = true;
+static bool left   = true;
+
+extern "C" bool is_keyboard_master(void) { return master; }
+extern "C" bool is_keyboard_left(void) { return left; }
+
+// rows of the key presses the reactive effects were given, in order
+static std::vector<uint8_t> reacted;
+
+extern "C" uint8_t rgb_matrix_map_row_column_to_led_kb(uint8_t row, uint8_t column, uint8_t *led_i) {
+    reacted.push_back(row);
+    return 0;
+}
+
+class RgbMatrixSplitHits : public TestFixture {
+   protected:
+    void SetUp() override {
+        master = true;
+        left   = true;
+        reacted.clear();
+    }
+
+    // what the master would send next, with the given hit as the newest one
+    rgb_matrix_split_hits_t next_hits(uint8_t row, bool pressed) {
+        rgb_matrix_split_hits_t hits;
+        rgb_matrix_get_split_hits(&hits);
+        memmove(&hits.hits[0], &hits.hits[1], sizeof(hits.hits) - sizeof(hits.hits[0]));
+        hits.hits[RGB_MATRIX_SPLIT_HITS - 1] = (rgb_matrix_split_hit_t){.row = row, .pressed = pressed, .col = 0};
+        hits.count++;
+        return hits;
+    }
+
+    // on the slave, start from a known count
+    void sync_slave(uint8_t count) {
+        rgb_matrix_split_hits_t hits = {.count = count};
+        rgb_matrix_update_split_hits(&hits);
+        reacted.clear();
+    }
+};
+
+TEST_F(RgbMatrixSplitHits, MasterOnlySendsItsOwnHalf) {
+    rgb_matrix_split_hits_t before, after;
+    rgb_matrix_get_split_hits(&before);
+
+    process_rgb_matrix(0, 0, true);
+    process_rgb_matrix(2, 0, true);
+    process_rgb_matrix(3, 0, false);
+    process_rgb_matrix(1, 0, false);
+
+    rgb_matrix_get_split_hits(&after);
+    EXPECT_EQ((uint8_t)(after.count - before.count), 2);
+    EXPECT_EQ(after.hits[RGB_MATRIX_SPLIT_HITS - 2].row, 0);
+    EXPECT_TRUE(after.hits[RGB_MATRIX_SPLIT_HITS - 2].pressed);
+    EXPECT_EQ(after.hits[RGB_MATRIX_SPLIT_HITS - 1].row, 1);
+    EXPECT_FALSE(after.hits[RGB_MATRIX_SPLIT_HITS - 1].pressed);
+
+    // as the right half, the master sends the other rows
+    left = false;
+    process_rgb_matrix(0, 0, true);
+    process_rgb_matrix(3, 0, true);
+    rgb_matrix_get_split_hits(&before);
+    EXPECT_EQ((uint8_t)(before.count - after.count), 1);
+    EXPECT_EQ(before.hits[RGB_MATRIX_SPLIT_HITS - 1].row, 3);
+}
+
+TEST_F(RgbMatrixSplitHits, MasterCountWrapsAround) {
+    rgb_matrix_split_hits_t before, after;
+    rgb_matrix_get_split_hits(&before);
+    for (int i = 0; i < 300; i++) {
+        process_rgb_matrix(i & 1, 0, i % 3 == 0);
+    }
+    rgb_matrix_get_split_hits(&after);
+    EXPECT_EQ(after.count, (uint8_t)(before.count + 300));
+    for (int i = 0; i < RGB_MATRIX_SPLIT_HITS; i++) {
+        int hit = 300 - RGB_MATRIX_SPLIT_HITS + i;
+        EXPECT_EQ(after.hits[i].row, hit & 1);
+        EXPECT_EQ(after.hits[i].pressed, hit % 3 == 0);
+    }
+}
+
+TEST_F(RgbMatrixSplitHits, SlaveReplaysNewHitsAcrossWrap) {
+    master = false;
+    left   = false;
+    sync_slave(254);
+
+    rgb_matrix_split_hits_t hits = {.count = 1};
+    hits.hits[0]                 = (rgb_matrix_split_hit_t){.row = 1, .pressed = true, .col = 0};  // 254, already seen
+    hits.hits[1]                 = (rgb_matrix_split_hit_t){.row = 0, .pressed = true, .col = 0};  // 255
+    hits.hits[2]                 = (rgb_matrix_split_hit_t){.row = 1, .pressed = true, .col = 0};  // 0
+    hits.hits[3]                 = (rgb_matrix_split_hit_t){.row = 0, .pressed = true, .col = 0};  // 1
+    rgb_matrix_update_split_hits(&hits);
+
+    EXPECT_EQ(reacted, std::vector<uint8_t>({0, 1, 0}));
+
+    // the same transfer again changes nothing
+    rgb_matrix_update_split_hits(&hits);
+    EXPECT_EQ(reacted.size(), 3u);
+}
+
+TEST_F(RgbMatrixSplitHits, SlaveReactsToBothHalves) {
+    master = false;
+    left   = false;
+    sync_slave(10);
+    rgb_matrix_split_hits_t seen;
+    rgb_matrix_get_split_hits(&seen);
+
+    // a key on the slave's own half is handled locally, and not counted as a master hit
+    process_rgb_matrix(3, 0, true);
+    rgb_matrix_split_hits_t hits;
+    rgb_matrix_get_split_hits(&hits);
+    EXPECT_EQ(hits.count, seen.count);
+
+    hits = next_hits(0, true);
+    rgb_matrix_update_split_hits(&hits);
+    process_rgb_matrix(2, 0, true);
+
+    EXPECT_EQ(reacted, std::vector<uint8_t>({3, 0, 2}));
+}
+
+TEST_F(RgbMatrixSplitHits, SlaveSkipsHitsItCannotHaveSeen) {
+    master = false;
+    left   = false;
+    sync_slave(0);
+
+    // more hits than fit, e.g. after the master was reset
+    rgb_matrix_split_hits_t hits = {.count = RGB_MATRIX_SPLIT_HITS + 1};
+    for (int i = 0; i < RGB_MATRIX_SPLIT_HITS; i++) {
+        hits.hits[i] = (rgb_matrix_split_hit_t){.row = 0, .pressed = true, .col = 0};
+    }
+    rgb_matrix_update_split_hits(&hits);
+    EXPECT_TRUE(reacted.empty());
+
+    // and picks up from there
+    hits = next_hits(1, true);
+    rgb_matrix_update_split_hits(&hits);
+    EXPECT_EQ(reacted, std::vector<uint8_t>({1}));
+}
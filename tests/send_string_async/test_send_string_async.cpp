@@ -0,0 +1,127 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "dynamic_keymap.h"
+}
+
+using testing::_;
+using testing::InSequence;
+
+class SendStringAsync : public TestFixture {};
+
+TEST_F(SendStringAsync, SendsOneReportPerScan) {
+    TestDriver driver;
+    InSequence s;
+    SEND_STRING("ab");
+    EXPECT_TRUE(send_string_is_active());
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(3);
+    EXPECT_FALSE(send_string_is_active());
+}
+
+TEST_F(SendStringAsync, ShiftedCharacters) {
+    TestDriver driver;
+    InSequence s;
+    SEND_STRING("A");
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT, KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_LSFT)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(4);
+}
+
+TEST_F(SendStringAsync, DelaysDoNotBlockScanning) {
+    TestDriver driver;
+    InSequence s;
+    SEND_STRING("a" SS_DELAY(20) "b");
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(2);
+
+    // a key pressed while the string waits is sent right away
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_C)));
+    run_one_scan_loop();
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(_)).Times(0);
+    idle_for(16);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(4);
+}
+
+TEST_F(SendStringAsync, StringsFromRamWaitForQueuedOnes) {
+    TestDriver driver;
+    InSequence s;
+    SEND_STRING("a");
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    send_string("b");
+    EXPECT_FALSE(send_string_is_active());
+}
+
+TEST_F(SendStringAsync, DynamicMacrosAreQueued) {
+    TestDriver driver;
+    InSequence s;
+    uint8_t macros[] = {'x', SS_TAP_CODE, KC_ENTER, 0, 'y', 0};
+    dynamic_keymap_macro_set_buffer(0, sizeof(macros), macros);
+
+    dynamic_keymap_macro_send(0);
+    EXPECT_TRUE(send_string_is_active());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_X)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_ENTER)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(4);
+    EXPECT_FALSE(send_string_is_active());
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    dynamic_keymap_macro_send(1);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_Y)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    idle_for(2);
+}
+
+TEST_F(SendStringAsync, ResetSendsQueuedStrings) {
+    TestDriver driver;
+    InSequence s;
+    SEND_STRING("ab");
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport())).Times(testing::AnyNumber());
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_B)));
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    reset_keyboard();
+    EXPECT_FALSE(send_string_is_active());
+}
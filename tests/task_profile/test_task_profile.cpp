@@ -0,0 +1,92 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+extern "C" {
+#include "task_profile.h"
+
+void advance_time(uint32_t ms);
+}
+
+class TaskProfile : public TestFixture {
+   protected:
+    void SetUp() override { task_profile_init(); }
+};
+
+TEST_F(TaskProfile, SummaryCoversLastInterval) {
+    for (int i = 0; i < 99; i++) {
+        task_profile_record(TASK_PROFILE_DEBOUNCE, 3);
+    }
+    task_profile_record(TASK_PROFILE_DEBOUNCE, 1000);
+
+    // nothing is published before the interval ends
+    task_profile_task();
+    EXPECT_EQ(task_profile_get(TASK_PROFILE_DEBOUNCE)->count, 0);
+
+    advance_time(TASK_PROFILE_INTERVAL);
+    task_profile_task();
+    const task_profile_summary_t *summary = task_profile_get(TASK_PROFILE_DEBOUNCE);
+    EXPECT_EQ(summary->count, 100);
+    EXPECT_EQ(summary->min, 3);
+    EXPECT_EQ(summary->avg, (99 * 3 + 1000) / 100);
+    EXPECT_EQ(summary->max, 1000);
+    // the one slow sample is outside the 99th percentile
+    EXPECT_EQ(summary->p99, 3);
+}
+
+TEST_F(TaskProfile, PercentileIsCappedAtMax) {
+    for (int i = 0; i < 10; i++) {
+        task_profile_record(TASK_PROFILE_OLED, 40 + i);
+    }
+    advance_time(TASK_PROFILE_INTERVAL);
+    task_profile_task();
+    const task_profile_summary_t *summary = task_profile_get(TASK_PROFILE_OLED);
+    EXPECT_EQ(summary->p99, 49);
+}
+
+TEST_F(TaskProfile, IntervalRestartsCollection) {
+    task_profile_record(TASK_PROFILE_DEBOUNCE, 5);
+    advance_time(TASK_PROFILE_INTERVAL);
+    task_profile_task();
+    EXPECT_EQ(task_profile_get(TASK_PROFILE_DEBOUNCE)->count, 1);
+
+    advance_time(TASK_PROFILE_INTERVAL);
+    task_profile_task();
+    EXPECT_EQ(task_profile_get(TASK_PROFILE_DEBOUNCE)->count, 0);
+}
+
+TEST_F(TaskProfile, KeyboardTaskStagesAreCounted) {
+    TestDriver driver;
+    press_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport(KC_A)));
+    // the last scan of the interval closes it
+    idle_for(TASK_PROFILE_INTERVAL + 1);
+    testing::Mock::VerifyAndClearExpectations(&driver);
+
+    EXPECT_EQ(task_profile_get(TASK_PROFILE_KEYBOARD_TASK)->count, TASK_PROFILE_INTERVAL + 1);
+    EXPECT_EQ(task_profile_get(TASK_PROFILE_MATRIX_SCAN)->count, TASK_PROFILE_INTERVAL + 1);
+    EXPECT_EQ(task_profile_get(TASK_PROFILE_ACTION)->count, TASK_PROFILE_INTERVAL + 1);
+    EXPECT_EQ(task_profile_get(TASK_PROFILE_USB_SEND)->count, 1);
+    // the host build counts milliseconds
+    EXPECT_EQ(task_profile_ticks_per_ms(), 1);
+
+    release_key(0, 0);
+    EXPECT_CALL(driver, send_keyboard_mock(KeyboardReport()));
+    run_one_scan_loop();
+}
+
+TEST_F(TaskProfile, UnknownStageHasNoSummary) { EXPECT_EQ(task_profile_get(TASK_PROFILE_STAGE_COUNT), nullptr); }
@@ -0,0 +1,175 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "test_common.hpp"
+
+#include <vector>
+
+extern "C" {
+#include "via.h"
+#include "raw_hid.h"
+#include "dynamic_keymap.h"
+#include "eeprom.h"
+
+extern uint8_t raw_hid_reply[32];
+}
+
+#define KEYMAP_SIZE (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2)
+#define PACKET_SIZE 32
+
+class ViaBulkTransfer : public TestFixture {
+   protected:
+    void SetUp() override {
+        dynamic_keymap_reset();
+        for (uint16_t i = 0; i < KEYMAP_SIZE; i++) {
+            image.push_back((i * 7 + 3) & 0xFF);
+        }
+    }
+
+    void TearDown() override { dynamic_keymap_reset(); }
+
+    uint8_t send(std::vector<uint8_t> packet) {
+        uint8_t data[PACKET_SIZE] = {0};
+        std::copy(packet.begin(), packet.end(), data);
+        raw_hid_receive(data, PACKET_SIZE);
+        return raw_hid_reply[0];
+    }
+
+    uint8_t begin(uint16_t offset, uint16_t size) {
+        send({id_dynamic_keymap_bulk_begin, (uint8_t)(offset >> 8), (uint8_t)offset, (uint8_t)(size >> 8), (uint8_t)size});
+        return raw_hid_reply[1];
+    }
+
+    uint8_t write(uint16_t sequence, const uint8_t *data, uint8_t count) {
+        std::vector<uint8_t> packet = {id_dynamic_keymap_bulk_write, (uint8_t)(sequence >> 8), (uint8_t)sequence};
+        packet.insert(packet.end(), data, data + count);
+        send(packet);
+        return raw_hid_reply[3];
+    }
+
+    uint8_t commit(uint16_t crc) {
+        send({id_dynamic_keymap_bulk_commit, (uint8_t)(crc >> 8), (uint8_t)crc});
+        return raw_hid_reply[3];
+    }
+
+    // Streams image[offset, offset + size), returns the status of the last write
+    uint8_t stream(uint16_t offset, uint16_t size) {
+        uint8_t  status   = bulk_status_ok;
+        uint16_t sequence = 0;
+        for (uint16_t sent = 0; sent < size && status == bulk_status_ok; sent += chunk, sequence++) {
+            status = write(sequence, &image[offset + sent], std::min<uint16_t>(chunk, size - sent));
+        }
+        return status;
+    }
+
+    uint16_t crc(uint16_t offset, uint16_t size) {
+        uint16_t crc = 0xFFFF;
+        for (uint16_t i = offset; i < offset + size; i++) {
+            crc ^= image[i] << 8;
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+            }
+        }
+        return crc;
+    }
+
+    uint8_t eeprom_byte(uint16_t offset) { return eeprom_read_byte((uint8_t *)dynamic_keymap_key_to_eeprom_address(0, 0, 0) + offset); }
+
+    std::vector<uint8_t> image;
+    const uint8_t        chunk = PACKET_SIZE - 3;
+};
+
+TEST_F(ViaBulkTransfer, WholeKeymapIsWrittenOnCommit) {
+    TestDriver driver;
+    EXPECT_EQ(begin(0, KEYMAP_SIZE), bulk_status_ok);
+    EXPECT_EQ(raw_hid_reply[2], chunk);
+    EXPECT_EQ(stream(0, KEYMAP_SIZE), bulk_status_ok);
+    // nothing reaches EEPROM before the commit, however long it takes
+    idle_for(1000);
+    EXPECT_EQ(eeprom_byte(0), 0x00);
+    EXPECT_EQ(eeprom_byte(1), KC_A);
+
+    EXPECT_EQ(commit(crc(0, KEYMAP_SIZE)), bulk_status_ok);
+    for (uint16_t i = 0; i < KEYMAP_SIZE; i++) {
+        EXPECT_EQ(eeprom_byte(i), image[i]) << "offset " << i;
+    }
+}
+
+TEST_F(ViaBulkTransfer, CrcMismatchDropsTheTransfer) {
+    TestDriver driver;
+    EXPECT_EQ(begin(20, 40), bulk_status_ok);
+    EXPECT_EQ(stream(20, 40), bulk_status_ok);
+    // the keymap in use never runs a transfer that was not checked yet
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 1, 0), KC_NO);
+    EXPECT_EQ(commit(crc(20, 40) ^ 1), bulk_status_crc);
+    EXPECT_EQ((raw_hid_reply[4] << 8) | raw_hid_reply[5], crc(20, 40));
+
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 1, 0), KC_NO);
+    idle_for(1000);
+    EXPECT_EQ(eeprom_byte(21), KC_NO);
+}
+
+TEST_F(ViaBulkTransfer, FailedTransferKeepsEarlierEdits) {
+    TestDriver driver;
+    // acknowledged to the host, but not written back yet
+    dynamic_keymap_set_keycode(1, 0, 0, KC_Z);
+    EXPECT_EQ(begin(0, 100), bulk_status_ok);
+    EXPECT_EQ(stream(0, 100), bulk_status_ok);
+    dynamic_keymap_set_keycode(1, 0, 1, KC_X);
+    EXPECT_EQ(commit(crc(0, 100) ^ 1), bulk_status_crc);
+
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 0, 0), KC_Z);
+    EXPECT_EQ(dynamic_keymap_get_keycode(1, 0, 1), KC_X);
+    idle_for(1000);
+    EXPECT_EQ(eeprom_byte(KEYMAP_SIZE / 2 + 1), KC_Z);
+    EXPECT_EQ(eeprom_byte(KEYMAP_SIZE / 2 + 3), KC_X);
+}
+
+TEST_F(ViaBulkTransfer, LostPacketAbortsTheTransfer) {
+    EXPECT_EQ(begin(0, 100), bulk_status_ok);
+    EXPECT_EQ(write(0, &image[0], chunk), bulk_status_ok);
+    EXPECT_EQ(write(2, &image[chunk], chunk), bulk_status_sequence);
+    EXPECT_EQ(write(1, &image[chunk], chunk), bulk_status_not_active);
+    EXPECT_EQ(commit(crc(0, 100)), bulk_status_not_active);
+}
+
+TEST_F(ViaBulkTransfer, IncompleteTransferIsRejected) {
+    EXPECT_EQ(begin(0, 100), bulk_status_ok);
+    EXPECT_EQ(write(0, &image[0], chunk), bulk_status_ok);
+    EXPECT_EQ(commit(crc(0, 100)), bulk_status_incomplete);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_A);
+}
+
+TEST_F(ViaBulkTransfer, OutOfRangeIsRejected) {
+    EXPECT_EQ(begin(0, KEYMAP_SIZE + 1), bulk_status_range);
+    EXPECT_EQ(begin(KEYMAP_SIZE, 1), bulk_status_range);
+    EXPECT_EQ(begin(0, 0), bulk_status_range);
+}
+
+TEST_F(ViaBulkTransfer, AbandonedTransferLeavesKeymapAlone) {
+    TestDriver driver;
+    EXPECT_EQ(begin(0, 100), bulk_status_ok);
+    EXPECT_EQ(write(0, &image[0], chunk), bulk_status_ok);
+    EXPECT_EQ(dynamic_keymap_get_keycode(0, 0, 0), KC_A);
+    idle_for(1000);
+    EXPECT_EQ(eeprom_byte(1), KC_A);
+
+    // a new transfer replaces the abandoned one
+    EXPECT_EQ(begin(0, 100), bulk_status_ok);
+    EXPECT_EQ(stream(0, 100), bulk_status_ok);
+    EXPECT_EQ(commit(crc(0, 100)), bulk_status_ok);
+    EXPECT_EQ(eeprom_byte(1), image[1]);
+}
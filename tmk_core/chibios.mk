@@ -313,6 +313,12 @@ LDSYMBOLS =,--defsym=__process_stack_size__=$(USE_PROCESS_STACKSIZE)
 LDSYMBOLS :=$(LDSYMBOLS),--defsym=__main_stack_size__=$(USE_EXCEPTIONS_STACKSIZE)
 LDFLAGS += -Wl,--script=$(LDSCRIPT)$(LDSYMBOLS)
 LDFLAGS += --specs=nano.specs
+ifneq ($(filter -DSTM32_EEPROM_ENABLE,$(OPT_DEFS)),)
+    # Pages reserved for the emulated EEPROM at the end of flash, eeprom_stm32.ld fails the link when the firmware runs into them
+    OPT_DEFS += -DFEE_DENSITY_PAGES=$(FEE_DENSITY_PAGES)
+    LDFLAGS += -Wl,--defsym=__eeprom_emu_size__=$(FEE_DENSITY_PAGES)*$(EEPROM_EMU_PAGE_SIZE)
+    LDFLAGS += $(TMK_PATH)/common/chibios/eeprom_stm32.ld
+endif
 
 OPT_DEFS += -DPROTOCOL_CHIBIOS
 
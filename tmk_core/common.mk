@@ -97,6 +97,16 @@ ifeq ($(strip $(USB_6KRO_ENABLE)), yes)
     TMK_COMMON_DEFS += -DUSB_6KRO_ENABLE
 endif
 
+ifeq ($(strip $(TASK_PROFILE_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/task_profile.c
+    TMK_COMMON_DEFS += -DTASK_PROFILE_ENABLE
+endif
+
+ifeq ($(strip $(LATENCY_TRACE_ENABLE)), yes)
+    TMK_COMMON_SRC += $(COMMON_DIR)/latency_trace.c
+    TMK_COMMON_DEFS += -DLATENCY_TRACE_ENABLE
+endif
+
 ifeq ($(strip $(SLEEP_LED_ENABLE)), yes)
     TMK_COMMON_SRC += $(PLATFORM_COMMON_DIR)/sleep_led.c
     TMK_COMMON_DEFS += -DSLEEP_LED_ENABLE
@@ -41,6 +41,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #    include "pointing_device.h"
 #endif
 
+#ifdef LATENCY_TRACE_ENABLE
+#    include "latency_trace.h"
+#endif
+
 int tp_buttons;
 
 #if defined(RETRO_TAPPING) || defined(RETRO_TAPPING_PER_KEY)
@@ -73,6 +77,9 @@ void action_exec(keyevent_t event) {
         dprintln();
 #if defined(RETRO_TAPPING) || defined(RETRO_TAPPING_PER_KEY)
         retro_tapping_counter++;
+#endif
+#ifdef LATENCY_TRACE_ENABLE
+        latency_trace_event(event);
 #endif
     }
 
@@ -191,17 +198,25 @@ void process_record(keyrecord_t *record) {
         return;
     }
 
+#ifdef LATENCY_TRACE_ENABLE
+    // reports sent from here on are caused by this record
+    uint16_t outer_time = latency_trace_record(record->event.time);
+#endif
+
     if (!process_record_quantum(record)) {
 #ifndef NO_ACTION_ONESHOT
         if (is_oneshot_layer_active() && record->event.pressed) {
             clear_oneshot_layer_state(ONESHOT_OTHER_KEY_PRESSED);
         }
 #endif
-        return;
+    } else {
+        process_record_handler(record);
+        post_process_record_quantum(record);
     }
 
-    process_record_handler(record);
-    post_process_record_quantum(record);
+#ifdef LATENCY_TRACE_ENABLE
+    latency_trace_record(outer_time);
+#endif
 }
 
 void process_record_handler(keyrecord_t *record) {
@@ -1,4 +1,5 @@
 #include <stdint.h>
+#include <string.h>
 #include "keyboard.h"
 #include "action.h"
 #include "util.h"
@@ -246,6 +247,24 @@ action_t store_or_get_action(bool pressed, keypos_t key) {
 #endif
 }
 
+#if !defined(NO_ACTION_LAYER) && defined(LAYER_RESOLUTION_CACHE)
+/** \brief layer resolution cache
+ *
+ * Topmost non-transparent layer of each key, resolved against layer_resolution_cache_state
+ */
+#    define LAYER_RESOLUTION_UNKNOWN 0xFF
+
+static uint8_t       layer_resolution_cache[MATRIX_ROWS][MATRIX_COLS];
+static layer_state_t layer_resolution_cache_state = 0;
+static bool          layer_resolution_cache_valid = false;
+
+/** \brief clear layer resolution cache
+ *
+ * Forgets every resolved key, call this whenever the keymap contents change
+ */
+void layer_resolution_cache_clear(void) { layer_resolution_cache_valid = false; }
+#endif
+
 /** \brief Layer switch get layer
  *
  * Gets the layer based on key info
@@ -256,16 +275,37 @@ uint8_t layer_switch_get_layer(keypos_t key) {
     action.code = ACTION_TRANSPARENT;
 
     layer_state_t layers = layer_state | default_layer_state;
+#    ifdef LAYER_RESOLUTION_CACHE
+    uint8_t *cached = NULL;
+    if (key.row < MATRIX_ROWS && key.col < MATRIX_COLS) {
+        // layer state changes are picked up here, so direct writes to layer_state are covered too
+        if (!layer_resolution_cache_valid || layers != layer_resolution_cache_state) {
+            memset(layer_resolution_cache, LAYER_RESOLUTION_UNKNOWN, sizeof(layer_resolution_cache));
+            layer_resolution_cache_state = layers;
+            layer_resolution_cache_valid = true;
+        }
+        cached = &layer_resolution_cache[key.row][key.col];
+        if (*cached != LAYER_RESOLUTION_UNKNOWN) {
+            return *cached;
+        }
+    }
+#    endif
     /* check top layer first */
     for (int8_t i = MAX_LAYER - 1; i >= 0; i--) {
         if (layers & (1UL << i)) {
             action = action_for_key(i, key);
             if (action.code != ACTION_TRANSPARENT) {
+#    ifdef LAYER_RESOLUTION_CACHE
+                if (cached) *cached = i;
+#    endif
                 return i;
             }
         }
     }
     /* fall back to layer 0 */
+#    ifdef LAYER_RESOLUTION_CACHE
+    if (cached) *cached = 0;
+#    endif
     return 0;
 #else
     return get_highest_layer(default_layer_state);
@@ -19,6 +19,8 @@
 #include "pin_defs.h"
 
 typedef uint8_t pin_t;
+typedef uint8_t port_t;
+typedef uint8_t port_data_t;
 
 #define setPinInput(pin) (DDRx_ADDRESS(pin) &= ~_BV((pin)&0xF), PORTx_ADDRESS(pin) &= ~_BV((pin)&0xF))
 #define setPinInputHigh(pin) (DDRx_ADDRESS(pin) &= ~_BV((pin)&0xF), PORTx_ADDRESS(pin) |= _BV((pin)&0xF))
@@ -32,3 +34,7 @@ typedef uint8_t pin_t;
 #define readPin(pin) ((bool)(PINx_ADDRESS(pin) & _BV((pin)&0xF)))
 
 #define togglePin(pin) (PORTx_ADDRESS(pin) ^= _BV((pin)&0xF))
+
+#define getPinPort(pin) ((port_t)((pin) >> PORT_SHIFTER))
+#define getPinMask(pin) ((port_data_t)_BV((pin)&0xF))
+#define readPort(port) ((port_data_t)PINx_ADDRESS((pin_t)(port) << PORT_SHIFTER))
@@ -156,6 +156,11 @@ void suspend_power_down(void) {
     rgblight_suspend();
 #    endif
 
+#    ifdef MATRIX_IDLE_TIMEOUT
+    // Only sample the matrix sense lines until a key is pressed
+    matrix_idle_enter();
+#    endif
+
     // Enter sleep state if possible (ie, the MCU has a watchdog timeout interrupt)
 #    if defined(WDT_vect)
     power_down(WDTO_15MS);
@@ -17,6 +17,7 @@
  */
 
 #include <stdio.h>
+#include <stdbool.h>
 #include <string.h>
 #include "eeprom_stm32.h"
 /*****************************************************************************
@@ -24,16 +25,168 @@
  * the functionality use the EEPROM_Init() function. Be sure that by reprogramming
  * of the controller just affected pages will be deleted. In other case the non
  * volatile data will be lost.
+ *
+ * Flash is used as an append-only log, so changing a value costs two half-word
+ * writes instead of a page erase. Reads are served from a RAM copy that is
+ * rebuilt from the log by EEPROM_Init().
  ******************************************************************************/
 
 /* Private macro -------------------------------------------------------------*/
+// Bank header: state half-word followed by FEE_BANK_MAGIC.
+// States only ever clear bits, so each one can be programmed over the previous one.
+#define FEE_BANK_ERASED ((uint16_t)0xFFFF)
+#define FEE_BANK_RECEIVING ((uint16_t)0xEEEE)
+#define FEE_BANK_ACTIVE ((uint16_t)0x0000)
+#define FEE_BANK_MAGIC ((uint16_t)0xFEE1)
+
+// Layout used before the banks: byte n in the low byte of the n-th half-word of the last
+// FEE_LEGACY_PAGES pages of flash. FEE_BANK_MAGIC can never show up in it.
+#if FEE_PAGE_SIZE == 0x400
+#    define FEE_LEGACY_PAGES 2
+#else
+#    define FEE_LEGACY_PAGES 4
+#endif
+#define FEE_LEGACY_OFFSET ((FEE_DENSITY_PAGES - FEE_LEGACY_PAGES) * FEE_PAGE_SIZE)
+#define FEE_LEGACY_BYTES (FEE_LEGACY_PAGES * FEE_PAGE_SIZE / 2 < FEE_DENSITY_BYTES ? FEE_LEGACY_PAGES * FEE_PAGE_SIZE / 2 : FEE_DENSITY_BYTES)
+
+#ifdef FLASH_STM32_MOCKED
+extern uint8_t FlashBuf[];
+#    define FEE_FLASH_HALF_WORD(Address) (*(__IO uint16_t *)(FlashBuf + ((Address)-FEE_PAGE_BASE_ADDRESS)))
+#else
+#    define FEE_FLASH_HALF_WORD(Address) (*(__IO uint16_t *)(Address))
+#endif
+
 /* Private variables ---------------------------------------------------------*/
+uint8_t         DataBuf[FEE_DENSITY_BYTES];
+static uint8_t  ActiveBank;
+static uint32_t WriteAddress;
+
 /* Functions -----------------------------------------------------------------*/
 
-uint8_t DataBuf[FEE_PAGE_SIZE];
+static FLASH_Status FEE_EraseBank(uint8_t Bank) {
+    FLASH_Status FlashStatus = FLASH_COMPLETE;
+    for (int page_num = 0; page_num < FEE_BANK_PAGES && FlashStatus == FLASH_COMPLETE; page_num++) {
+        uint32_t page = FEE_BANK_ADDRESS(Bank) + (page_num * FEE_PAGE_SIZE);
+        // skip pages that are still blank
+        for (uint32_t i = 0; i < FEE_PAGE_SIZE; i += 2) {
+            if (FEE_FLASH_HALF_WORD(page + i) != FEE_EMPTY_WORD) {
+                FlashStatus = FLASH_ErasePage(page);
+                break;
+            }
+        }
+    }
+    return FlashStatus;
+}
+
+static FLASH_Status FEE_ProgramRecord(uint32_t Address, uint16_t Index, uint16_t Data) {
+    // Data goes first: a record cut short by a reset still has an empty index and is skipped
+    FLASH_Status FlashStatus = FLASH_ProgramHalfWord(Address, Data);
+    if (FlashStatus == FLASH_COMPLETE) {
+        FlashStatus = FLASH_ProgramHalfWord(Address + 2, Index);
+    }
+    return FlashStatus;
+}
+
+static uint16_t FEE_CachedHalfWord(uint16_t Index) { return DataBuf[Index * 2] | (DataBuf[Index * 2 + 1] << 8); }
+
+/*****************************************************************************
+ *  Copy the RAM contents into the other bank, leaving out erased half-words,
+ *  and make it the active one. The new bank is only marked receiving once the
+ *  copy is complete, and the old bank is erased before the new one is marked
+ *  active, so a reset at any point leaves exactly one usable bank.
+ *******************************************************************************/
+static FLASH_Status FEE_Compact(void) {
+    uint8_t      bank        = ActiveBank ^ 1;
+    uint32_t     address     = FEE_BANK_ADDRESS(bank) + FEE_RECORD_SIZE;
+    FLASH_Status FlashStatus = FEE_EraseBank(bank);
+
+    if (FlashStatus == FLASH_COMPLETE) FlashStatus = FLASH_ProgramHalfWord(FEE_BANK_ADDRESS(bank) + 2, FEE_BANK_MAGIC);
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES / 2 && FlashStatus == FLASH_COMPLETE; i++) {
+        uint16_t data = FEE_CachedHalfWord(i);
+        if (data != FEE_EMPTY_WORD) {
+            FlashStatus = FEE_ProgramRecord(address, i, data);
+            address += FEE_RECORD_SIZE;
+        }
+    }
+    if (FlashStatus == FLASH_COMPLETE) FlashStatus = FLASH_ProgramHalfWord(FEE_BANK_ADDRESS(bank), FEE_BANK_RECEIVING);
+    if (FlashStatus != FLASH_COMPLETE) {
+        return FlashStatus;
+    }
+
+    FlashStatus = FEE_EraseBank(ActiveBank);
+    if (FlashStatus == FLASH_COMPLETE) FlashStatus = FLASH_ProgramHalfWord(FEE_BANK_ADDRESS(bank), FEE_BANK_ACTIVE);
+    ActiveBank   = bank;
+    WriteAddress = address;
+    return FlashStatus;
+}
+
 /*****************************************************************************
- *  Delete Flash Space used for user Data, deletes the whole space between
- *  RW_PAGE_BASE_ADDRESS and the last uC Flash Page
+ *  Store the half-word Index of the RAM copy, compacting the bank if it is full
+ *******************************************************************************/
+static FLASH_Status FEE_WriteHalfWord(uint16_t Index) {
+    if (WriteAddress + FEE_RECORD_SIZE > FEE_BANK_ADDRESS(ActiveBank) + FEE_BANK_SIZE) {
+        // the RAM copy already holds the new value
+        return FEE_Compact();
+    }
+    FLASH_Status FlashStatus = FEE_ProgramRecord(WriteAddress, Index, FEE_CachedHalfWord(Index));
+    WriteAddress += FEE_RECORD_SIZE;
+    return FlashStatus;
+}
+
+/*****************************************************************************
+ *  Rebuild the RAM copy from the records of the active bank
+ *******************************************************************************/
+static void FEE_LoadBank(uint8_t Bank) {
+    uint32_t address = FEE_BANK_ADDRESS(Bank) + FEE_RECORD_SIZE;
+    uint32_t end     = FEE_BANK_ADDRESS(Bank) + FEE_BANK_SIZE;
+
+    memset(DataBuf, 0xFF, sizeof(DataBuf));
+    for (; address < end; address += FEE_RECORD_SIZE) {
+        uint16_t data  = FEE_FLASH_HALF_WORD(address);
+        uint16_t index = FEE_FLASH_HALF_WORD(address + 2);
+        if (data == FEE_EMPTY_WORD && index == FEE_EMPTY_WORD) {
+            break;
+        }
+        if (index < FEE_DENSITY_BYTES / 2) {
+            DataBuf[index * 2]     = (uint8_t)data;
+            DataBuf[index * 2 + 1] = (uint8_t)(data >> 8);
+        }
+    }
+    ActiveBank   = Bank;
+    WriteAddress = address;
+}
+
+/*****************************************************************************
+ *  Load data stored in the layout used before the banks, and compact it into
+ *  the bank that does not hold it. Unless the old data spans both banks, a
+ *  reset before the copy is complete leaves it in place to be migrated again.
+ *******************************************************************************/
+static bool FEE_MigrateLegacy(void) {
+#if FEE_DENSITY_PAGES >= FEE_LEGACY_PAGES
+    bool found = false;
+
+    memset(DataBuf, 0xFF, sizeof(DataBuf));
+    for (uint16_t i = 0; i < FEE_LEGACY_BYTES; i++) {
+        uint16_t data = FEE_FLASH_HALF_WORD(FEE_PAGE_BASE_ADDRESS + FEE_LEGACY_OFFSET + i * 2);
+        if (data != FEE_EMPTY_WORD) {
+            DataBuf[i] = (uint8_t)data;
+            found      = true;
+        }
+    }
+    if (found) {
+        ActiveBank = FEE_LEGACY_OFFSET + FEE_LEGACY_BYTES * 2 <= FEE_BANK_SIZE ? 0 : 1;
+        FEE_Compact();
+    }
+    return found;
+#else
+    return false;
+#endif
+}
+
+/*****************************************************************************
+ *  Unlock the flash and load the active bank. Recovers from a reset during
+ *  compaction, migrates the old layout, and formats the pages if they hold
+ *  no valid bank.
  ******************************************************************************/
 uint16_t EEPROM_Init(void) {
     // unlock flash
@@ -42,74 +195,90 @@ uint16_t EEPROM_Init(void) {
     // Clear Flags
     // FLASH_ClearFlag(FLASH_SR_EOP|FLASH_SR_PGERR|FLASH_SR_WRPERR);
 
+    uint16_t state[2];
+    for (uint8_t bank = 0; bank < 2; bank++) {
+        state[bank] = FEE_FLASH_HALF_WORD(FEE_BANK_ADDRESS(bank) + 2) == FEE_BANK_MAGIC ? FEE_FLASH_HALF_WORD(FEE_BANK_ADDRESS(bank)) : FEE_BANK_ERASED;
+    }
+
+    if (state[0] == FEE_BANK_ACTIVE || state[1] == FEE_BANK_ACTIVE) {
+        uint8_t bank = state[0] == FEE_BANK_ACTIVE ? 0 : 1;
+        // anything in the other bank is an unfinished compaction
+        FEE_EraseBank(bank ^ 1);
+        FEE_LoadBank(bank);
+    } else if (state[0] == FEE_BANK_RECEIVING || state[1] == FEE_BANK_RECEIVING) {
+        // the copy was complete, the old bank had already been erased
+        uint8_t bank = state[0] == FEE_BANK_RECEIVING ? 0 : 1;
+        FLASH_ProgramHalfWord(FEE_BANK_ADDRESS(bank), FEE_BANK_ACTIVE);
+        FEE_LoadBank(bank);
+    } else if (!FEE_MigrateLegacy()) {
+        EEPROM_Erase();
+    }
+
     return FEE_DENSITY_BYTES;
 }
 /*****************************************************************************
  *  Erase the whole reserved Flash Space used for user Data
  ******************************************************************************/
 void EEPROM_Erase(void) {
-    int page_num = 0;
+    // delete all pages that are not blank already
+    FEE_EraseBank(0);
+    FEE_EraseBank(1);
 
-    // delete all pages from specified start page to the last page
-    do {
-        FLASH_ErasePage(FEE_PAGE_BASE_ADDRESS + (page_num * FEE_PAGE_SIZE));
-        page_num++;
-    } while (page_num < FEE_DENSITY_PAGES);
+    FLASH_ProgramHalfWord(FEE_BANK_ADDRESS(0) + 2, FEE_BANK_MAGIC);
+    FLASH_ProgramHalfWord(FEE_BANK_ADDRESS(0), FEE_BANK_ACTIVE);
+    memset(DataBuf, 0xFF, sizeof(DataBuf));
+    ActiveBank   = 0;
+    WriteAddress = FEE_BANK_ADDRESS(0) + FEE_RECORD_SIZE;
 }
 /*****************************************************************************
- *  Writes once data byte to flash on specified address. If a byte is already
- *  written, the whole page must be copied to a buffer, the byte changed and
- *  the manipulated buffer written after PageErase.
+ *  Writes Length bytes starting at Address. Only the half-words that actually
+ *  change are appended to flash.
  *******************************************************************************/
-uint16_t EEPROM_WriteDataByte(uint16_t Address, uint8_t DataByte) {
+uint16_t EEPROM_WriteDataBlock(uint16_t Address, const uint8_t *Data, uint16_t Length) {
     FLASH_Status FlashStatus = FLASH_COMPLETE;
 
-    uint32_t page;
-    int      i;
-
-    // exit if desired address is above the limit (e.G. under 2048 Bytes for 4 pages)
-    if (Address > FEE_DENSITY_BYTES) {
+    // exit if desired address is above the limit
+    if (Address >= FEE_DENSITY_BYTES) {
         return 0;
     }
+    if (Length > FEE_DENSITY_BYTES - Address) {
+        Length = FEE_DENSITY_BYTES - Address;
+    }
 
-    // calculate which page is affected (Pagenum1/Pagenum2...PagenumN)
-    page = FEE_ADDR_OFFSET(Address) / FEE_PAGE_SIZE;
-
-    // if current data is 0xFF, the byte is empty, just overwrite with the new one
-    if ((*(__IO uint16_t *)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address))) == FEE_EMPTY_WORD) {
-        FlashStatus = FLASH_ProgramHalfWord(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address), (uint16_t)(0x00FF & DataByte));
-    } else {
-        // Copy Page to a buffer
-        memcpy(DataBuf, (uint8_t *)FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE), FEE_PAGE_SIZE);  // !!! Calculate base address for the desired page
-
-        // check if new data is differ to current data, return if not, proceed if yes
-        if (DataByte == *(__IO uint8_t *)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address))) {
-            return 0;
-        }
-
-        // manipulate desired data byte in temp data array if new byte is differ to the current
-        DataBuf[FEE_ADDR_OFFSET(Address) % FEE_PAGE_SIZE] = DataByte;
-
-        // Erase Page
-        FlashStatus = FLASH_ErasePage(FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE));
-
-        // Write new data (whole page) to flash if data has been changed
-        for (i = 0; i < (FEE_PAGE_SIZE / 2); i++) {
-            if ((__IO uint16_t)(0xFF00 | DataBuf[FEE_ADDR_OFFSET(i)]) != 0xFFFF) {
-                FlashStatus = FLASH_ProgramHalfWord((FEE_PAGE_BASE_ADDRESS + (page * FEE_PAGE_SIZE)) + (i * 2), (uint16_t)(0xFF00 | DataBuf[FEE_ADDR_OFFSET(i)]));
+    while (Length > 0 && FlashStatus == FLASH_COMPLETE) {
+        uint16_t index   = Address / 2;
+        bool     changed = false;
+        // fill in both bytes of the half-word if they are covered
+        do {
+            if (DataBuf[Address] != *Data) {
+                DataBuf[Address] = *Data;
+                changed          = true;
             }
+            Address++;
+            Data++;
+            Length--;
+        } while (Length > 0 && Address % 2 != 0);
+
+        if (changed) {
+            FlashStatus = FEE_WriteHalfWord(index);
         }
     }
     return FlashStatus;
 }
+/*****************************************************************************
+ *  Writes once data byte to flash on specified address.
+ *******************************************************************************/
+uint16_t EEPROM_WriteDataByte(uint16_t Address, uint8_t DataByte) { return EEPROM_WriteDataBlock(Address, &DataByte, 1); }
 /*****************************************************************************
  *  Read once data byte from a specified address.
  *******************************************************************************/
 uint8_t EEPROM_ReadDataByte(uint16_t Address) {
     uint8_t DataByte = 0xFF;
 
-    // Get Byte from specified address
-    DataByte = (*(__IO uint8_t *)(FEE_PAGE_BASE_ADDRESS + FEE_ADDR_OFFSET(Address)));
+    // Get Byte from the RAM copy
+    if (Address < FEE_DENSITY_BYTES) {
+        DataByte = DataBuf[Address];
+    }
 
     return DataByte;
 }
@@ -118,81 +287,60 @@ uint8_t EEPROM_ReadDataByte(uint16_t Address) {
  *  Wrap library in AVR style functions.
  *******************************************************************************/
 uint8_t eeprom_read_byte(const uint8_t *Address) {
-    const uint16_t p = (const uint32_t)Address;
+    const uint16_t p = (const uintptr_t)Address;
     return EEPROM_ReadDataByte(p);
 }
 
 void eeprom_write_byte(uint8_t *Address, uint8_t Value) {
-    uint16_t p = (uint32_t)Address;
+    uint16_t p = (uintptr_t)Address;
     EEPROM_WriteDataByte(p, Value);
 }
 
 void eeprom_update_byte(uint8_t *Address, uint8_t Value) {
-    uint16_t p = (uint32_t)Address;
+    uint16_t p = (uintptr_t)Address;
     EEPROM_WriteDataByte(p, Value);
 }
 
 uint16_t eeprom_read_word(const uint16_t *Address) {
-    const uint16_t p = (const uint32_t)Address;
+    const uint16_t p = (const uintptr_t)Address;
     return EEPROM_ReadDataByte(p) | (EEPROM_ReadDataByte(p + 1) << 8);
 }
 
 void eeprom_write_word(uint16_t *Address, uint16_t Value) {
-    uint16_t p = (uint32_t)Address;
-    EEPROM_WriteDataByte(p, (uint8_t)Value);
-    EEPROM_WriteDataByte(p + 1, (uint8_t)(Value >> 8));
+    uint16_t p       = (uintptr_t)Address;
+    uint8_t  data[2] = {(uint8_t)Value, (uint8_t)(Value >> 8)};
+    EEPROM_WriteDataBlock(p, data, sizeof(data));
 }
 
-void eeprom_update_word(uint16_t *Address, uint16_t Value) {
-    uint16_t p = (uint32_t)Address;
-    EEPROM_WriteDataByte(p, (uint8_t)Value);
-    EEPROM_WriteDataByte(p + 1, (uint8_t)(Value >> 8));
-}
+void eeprom_update_word(uint16_t *Address, uint16_t Value) { eeprom_write_word(Address, Value); }
 
 uint32_t eeprom_read_dword(const uint32_t *Address) {
-    const uint16_t p = (const uint32_t)Address;
-    return EEPROM_ReadDataByte(p) | (EEPROM_ReadDataByte(p + 1) << 8) | (EEPROM_ReadDataByte(p + 2) << 16) | (EEPROM_ReadDataByte(p + 3) << 24);
+    const uint16_t p = (const uintptr_t)Address;
+    return EEPROM_ReadDataByte(p) | (EEPROM_ReadDataByte(p + 1) << 8) | (EEPROM_ReadDataByte(p + 2) << 16) | ((uint32_t)EEPROM_ReadDataByte(p + 3) << 24);
 }
 
 void eeprom_write_dword(uint32_t *Address, uint32_t Value) {
-    uint16_t p = (const uint32_t)Address;
-    EEPROM_WriteDataByte(p, (uint8_t)Value);
-    EEPROM_WriteDataByte(p + 1, (uint8_t)(Value >> 8));
-    EEPROM_WriteDataByte(p + 2, (uint8_t)(Value >> 16));
-    EEPROM_WriteDataByte(p + 3, (uint8_t)(Value >> 24));
-}
-
-void eeprom_update_dword(uint32_t *Address, uint32_t Value) {
-    uint16_t p             = (const uint32_t)Address;
-    uint32_t existingValue = EEPROM_ReadDataByte(p) | (EEPROM_ReadDataByte(p + 1) << 8) | (EEPROM_ReadDataByte(p + 2) << 16) | (EEPROM_ReadDataByte(p + 3) << 24);
-    if (Value != existingValue) {
-        EEPROM_WriteDataByte(p, (uint8_t)Value);
-        EEPROM_WriteDataByte(p + 1, (uint8_t)(Value >> 8));
-        EEPROM_WriteDataByte(p + 2, (uint8_t)(Value >> 16));
-        EEPROM_WriteDataByte(p + 3, (uint8_t)(Value >> 24));
-    }
+    uint16_t p       = (uintptr_t)Address;
+    uint8_t  data[4] = {(uint8_t)Value, (uint8_t)(Value >> 8), (uint8_t)(Value >> 16), (uint8_t)(Value >> 24)};
+    EEPROM_WriteDataBlock(p, data, sizeof(data));
 }
 
+void eeprom_update_dword(uint32_t *Address, uint32_t Value) { eeprom_write_dword(Address, Value); }
+
 void eeprom_read_block(void *buf, const void *addr, size_t len) {
-    const uint8_t *p    = (const uint8_t *)addr;
-    uint8_t *      dest = (uint8_t *)buf;
-    while (len--) {
-        *dest++ = eeprom_read_byte(p++);
+    const uint16_t p = (const uintptr_t)addr;
+    if (p < FEE_DENSITY_BYTES) {
+        size_t cached = len < (size_t)(FEE_DENSITY_BYTES - p) ? len : (size_t)(FEE_DENSITY_BYTES - p);
+        memcpy(buf, &DataBuf[p], cached);
+        buf = (uint8_t *)buf + cached;
+        len -= cached;
     }
+    memset(buf, 0xFF, len);
 }
 
 void eeprom_write_block(const void *buf, void *addr, size_t len) {
-    uint8_t *      p   = (uint8_t *)addr;
-    const uint8_t *src = (const uint8_t *)buf;
-    while (len--) {
-        eeprom_write_byte(p++, *src++);
-    }
+    uint16_t p = (uintptr_t)addr;
+    EEPROM_WriteDataBlock(p, (const uint8_t *)buf, len);
 }
 
-void eeprom_update_block(const void *buf, void *addr, size_t len) {
-    uint8_t *      p   = (uint8_t *)addr;
-    const uint8_t *src = (const uint8_t *)buf;
-    while (len--) {
-        eeprom_write_byte(p++, *src++);
-    }
-}
+void eeprom_update_block(const void *buf, void *addr, size_t len) { eeprom_write_block(buf, addr, len); }
@@ -17,14 +17,16 @@
  *
  * This library assumes 8-bit data locations. To add a new MCU, please provide the flash
  * page size and the total flash size in Kb. The number of available pages must be a multiple
- * of 2. Only half of the pages account for the total EEPROM size.
+ * of 2. The pages are split into two banks, only one of which holds data at any time.
  * This library also assumes that the pages are not used by the firmware.
  */
 
 #pragma once
 
-#include <ch.h>
-#include <hal.h>
+#ifndef FLASH_STM32_MOCKED
+#    include <ch.h>
+#    include <hal.h>
+#endif
 #include "flash_stm32.h"
 
 // HACK ALERT. This definition may not match your processor
@@ -37,23 +39,28 @@
 #    define MCU_STM32F072CB
 #elif defined(EEPROM_EMU_STM32F042x6)
 #    define MCU_STM32F042K6
-#else
+#elif !defined(FLASH_STM32_MOCKED)
 #    error "not implemented."
 #endif
 
-#ifndef EEPROM_PAGE_SIZE
+#if !defined(EEPROM_PAGE_SIZE) && !defined(FEE_PAGE_SIZE)
 #    if defined(MCU_STM32F103RB) || defined(MCU_STM32F042K6)
-#        define FEE_PAGE_SIZE (uint16_t)0x400  // Page size = 1KByte
-#        define FEE_DENSITY_PAGES 2            // How many pages are used
+#        define FEE_PAGE_SIZE 0x400             // Page size = 1KByte
+#        define FEE_DEFAULT_DENSITY_BYTES 1024  // How many bytes are emulated
 #    elif defined(MCU_STM32F103ZE) || defined(MCU_STM32F103RE) || defined(MCU_STM32F103RD) || defined(MCU_STM32F303CC) || defined(MCU_STM32F072CB)
-#        define FEE_PAGE_SIZE (uint16_t)0x800  // Page size = 2KByte
-#        define FEE_DENSITY_PAGES 4            // How many pages are used
+#        define FEE_PAGE_SIZE 0x800             // Page size = 2KByte
+#        define FEE_DEFAULT_DENSITY_BYTES 4096  // How many bytes are emulated
 #    else
 #        error "No MCU type specified. Add something like -DMCU_STM32F103RB to your compiler arguments (probably in a Makefile)."
 #    endif
 #endif
 
-#ifndef EEPROM_START_ADDRESS
+// The number of pages is set in rules.mk, the linker needs it to keep the firmware out of them
+#ifndef FEE_DENSITY_PAGES
+#    error "FEE_DENSITY_PAGES is not set, it is passed in by chibios.mk."
+#endif
+
+#if !defined(EEPROM_START_ADDRESS) && !defined(FEE_MCU_FLASH_SIZE)
 #    if defined(MCU_STM32F103RB) || defined(MCU_STM32F072CB)
 #        define FEE_MCU_FLASH_SIZE 128  // Size in Kb
 #    elif defined(MCU_STM32F042K6)
@@ -72,13 +79,41 @@
 // DONT CHANGE
 // Choose location for the first EEPROM Page address on the top of flash
 #define FEE_PAGE_BASE_ADDRESS ((uint32_t)(0x8000000 + FEE_MCU_FLASH_SIZE * 1024 - FEE_DENSITY_PAGES * FEE_PAGE_SIZE))
-#define FEE_DENSITY_BYTES ((FEE_PAGE_SIZE / 2) * FEE_DENSITY_PAGES - 1)
 #define FEE_LAST_PAGE_ADDRESS (FEE_PAGE_BASE_ADDRESS + (FEE_PAGE_SIZE * FEE_DENSITY_PAGES))
 #define FEE_EMPTY_WORD ((uint16_t)0xFFFF)
-#define FEE_ADDR_OFFSET(Address) (Address * 2)  // 1Byte per Word will be saved to preserve Flash
+
+// Writes are appended to the active bank as 4 byte records: the data half-word, then the
+// half-word index it belongs to. When the bank is full, the current contents are compacted
+// into the other bank and the old one is erased.
+#define FEE_BANK_PAGES (FEE_DENSITY_PAGES / 2)
+#define FEE_BANK_SIZE (FEE_PAGE_SIZE * FEE_BANK_PAGES)
+#define FEE_BANK_ADDRESS(Bank) (FEE_PAGE_BASE_ADDRESS + (Bank)*FEE_BANK_SIZE)
+#define FEE_RECORD_SIZE 4
+
+// Size of the emulated EEPROM. Half of a compacted bank stays free for new writes
+// even when every half-word is in use. The known MCUs keep the capacity they had
+// before the bank layout if the reserved pages can hold it, otherwise they get as
+// much as fits.
+#ifndef FEE_DENSITY_BYTES
+#    if defined(FEE_DEFAULT_DENSITY_BYTES) && FEE_DEFAULT_DENSITY_BYTES <= (FEE_BANK_SIZE - FEE_RECORD_SIZE) / 2
+#        define FEE_DENSITY_BYTES FEE_DEFAULT_DENSITY_BYTES
+#    elif defined(FEE_DEFAULT_DENSITY_BYTES)
+#        define FEE_DENSITY_BYTES ((FEE_BANK_SIZE - FEE_RECORD_SIZE) / 2)
+#    else
+#        define FEE_DENSITY_BYTES (FEE_BANK_SIZE / 4)
+#    endif
+#endif
+
+#if FEE_DENSITY_PAGES < 2 || FEE_DENSITY_PAGES % 2 != 0
+#    error "FEE_DENSITY_PAGES must be a multiple of 2."
+#endif
+#if FEE_DENSITY_BYTES % 2 != 0 || FEE_DENSITY_BYTES > (FEE_BANK_SIZE - FEE_RECORD_SIZE) / 2
+#    error "FEE_DENSITY_BYTES must be even and fit into a compacted bank."
+#endif
 
 // Use this function to initialize the functionality
 uint16_t EEPROM_Init(void);
 void     EEPROM_Erase(void);
 uint16_t EEPROM_WriteDataByte(uint16_t Address, uint8_t DataByte);
+uint16_t EEPROM_WriteDataBlock(uint16_t Address, const uint8_t *Data, uint16_t Length);
 uint8_t  EEPROM_ReadDataByte(uint16_t Address);
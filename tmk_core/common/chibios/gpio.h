@@ -18,7 +18,9 @@
 #include <hal.h>
 #include "pin_defs.h"
 
-typedef ioline_t pin_t;
+typedef ioline_t     pin_t;
+typedef ioportid_t   port_t;
+typedef ioportmask_t port_data_t;
 
 #define setPinInput(pin) palSetLineMode(pin, PAL_MODE_INPUT)
 #define setPinInputHigh(pin) palSetLineMode(pin, PAL_MODE_INPUT_PULLUP)
@@ -32,3 +34,7 @@ typedef ioline_t pin_t;
 #define readPin(pin) palReadLine(pin)
 
 #define togglePin(pin) palToggleLine(pin)
+
+#define getPinPort(pin) PAL_PORT(pin)
+#define getPinMask(pin) ((port_data_t)PAL_PORT_BIT(PAL_PAD(pin)))
+#define readPort(port) palReadPort(port)
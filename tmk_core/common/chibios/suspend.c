@@ -73,6 +73,11 @@ void suspend_power_down(void) {
     stop_all_notes();
 #endif /* AUDIO_ENABLE */
 
+#ifdef MATRIX_IDLE_TIMEOUT
+    // Only sample the matrix sense lines until a key is pressed
+    matrix_idle_enter();
+#endif
+
     suspend_power_down_kb();
     // on AVR, this enables the watchdog for 15ms (max), and goes to
     // SLEEP_MODE_PWR_DOWN
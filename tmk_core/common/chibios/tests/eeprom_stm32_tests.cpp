@@ -0,0 +1,206 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gtest/gtest.h"
+
+extern "C" {
+#include "flash_stm32_mock.h"
+#include "eeprom_stm32.h"
+#include "eeprom.h"
+}
+
+// records that fit into a bank after its header
+#define BANK_RECORDS ((FEE_BANK_SIZE - FEE_RECORD_SIZE) / FEE_RECORD_SIZE)
+
+class EepromStm32 : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        flash_mock_reset();
+        EEPROM_Init();
+    }
+
+    uint32_t bank_erases(uint8_t bank) {
+        uint32_t erases = 0;
+        for (int i = 0; i < FEE_BANK_PAGES; i++) {
+            erases += FlashEraseCount[bank * FEE_BANK_PAGES + i];
+        }
+        return erases;
+    }
+
+    uint32_t total_erases(void) { return bank_erases(0) + bank_erases(1); }
+};
+
+TEST_F(EepromStm32, BlankFlashReadsAsErased) {
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES; i++) {
+        EXPECT_EQ(EEPROM_ReadDataByte(i), 0xFF);
+    }
+}
+
+TEST_F(EepromStm32, WritesSurviveReinit) {
+    eeprom_write_byte((uint8_t *)3, 0x42);
+    eeprom_write_word((uint16_t *)10, 0x1234);
+    eeprom_write_dword((uint32_t *)21, 0xDEADBEEF);
+    EEPROM_Init();
+    EXPECT_EQ(eeprom_read_byte((uint8_t *)3), 0x42);
+    EXPECT_EQ(eeprom_read_word((uint16_t *)10), 0x1234);
+    EXPECT_EQ(eeprom_read_dword((uint32_t *)21), 0xDEADBEEF);
+}
+
+TEST_F(EepromStm32, RewritesDoNotEraseUntilBankIsFull) {
+    uint32_t erases = total_erases();
+    for (uint32_t i = 0; i < BANK_RECORDS; i++) {
+        EEPROM_WriteDataByte(0, i & 1 ? 0x55 : 0xAA);
+    }
+    EXPECT_EQ(total_erases(), erases);
+
+    EEPROM_WriteDataByte(0, 0x11);
+    EXPECT_EQ(total_erases(), erases + FEE_BANK_PAGES);
+    EXPECT_EQ(EEPROM_ReadDataByte(0), 0x11);
+    EEPROM_Init();
+    EXPECT_EQ(EEPROM_ReadDataByte(0), 0x11);
+}
+
+TEST_F(EepromStm32, UnchangedWritesAreSkipped) {
+    uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    eeprom_update_block(data, (void *)5, sizeof(data));
+    uint32_t programs = FlashProgramCount;
+    eeprom_update_block(data, (void *)5, sizeof(data));
+    eeprom_update_byte((uint8_t *)7, 3);
+    EXPECT_EQ(FlashProgramCount, programs);
+}
+
+TEST_F(EepromStm32, BlockWritesProgramOneRecordPerHalfWord) {
+    uint8_t data[6] = {1, 2, 3, 4, 5, 6};
+    uint32_t programs = FlashProgramCount;
+    // unaligned, touches half-words 1, 2, 3 and 4
+    eeprom_write_block(data, (void *)3, sizeof(data));
+    EXPECT_EQ(FlashProgramCount - programs, 4 * 2);
+
+    uint8_t read[8];
+    eeprom_read_block(read, (void *)2, sizeof(read));
+    uint8_t expected[8] = {0xFF, 1, 2, 3, 4, 5, 6, 0xFF};
+    EXPECT_EQ(memcmp(read, expected, sizeof(read)), 0);
+}
+
+TEST_F(EepromStm32, OutOfRangeAccessIsIgnored) {
+    uint32_t programs = FlashProgramCount;
+    EEPROM_WriteDataByte(FEE_DENSITY_BYTES, 0x00);
+    EXPECT_EQ(FlashProgramCount, programs);
+    EXPECT_EQ(EEPROM_ReadDataByte(FEE_DENSITY_BYTES), 0xFF);
+
+    uint8_t data[4] = {1, 2, 3, 4};
+    eeprom_write_block(data, (void *)(FEE_DENSITY_BYTES - 2), sizeof(data));
+    eeprom_read_block(data, (void *)(FEE_DENSITY_BYTES - 2), sizeof(data));
+    uint8_t expected[4] = {1, 2, 0xFF, 0xFF};
+    EXPECT_EQ(memcmp(data, expected, sizeof(data)), 0);
+}
+
+TEST_F(EepromStm32, CompactionKeepsEverythingAndAlternatesBanks) {
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES; i++) {
+        EEPROM_WriteDataByte(i, (uint8_t)i);
+    }
+    for (uint32_t i = 0; i < 4 * BANK_RECORDS; i++) {
+        EEPROM_WriteDataByte(0, (uint8_t)i);
+    }
+    EXPECT_GT(bank_erases(0), 0u);
+    EXPECT_GT(bank_erases(1), 0u);
+    EXPECT_LE(bank_erases(0) > bank_erases(1) ? bank_erases(0) - bank_erases(1) : bank_erases(1) - bank_erases(0), (uint32_t)FEE_BANK_PAGES);
+
+    EEPROM_Init();
+    EXPECT_EQ(EEPROM_ReadDataByte(0), (uint8_t)(4 * BANK_RECORDS - 1));
+    for (uint16_t i = 1; i < FEE_DENSITY_BYTES; i++) {
+        EXPECT_EQ(EEPROM_ReadDataByte(i), (uint8_t)i);
+    }
+}
+
+TEST_F(EepromStm32, PowerLossDuringCompactionKeepsData) {
+    for (int32_t budget = 0; budget < 2 * FEE_BANK_PAGES + FEE_DENSITY_BYTES + 8; budget++) {
+        flash_mock_reset();
+        EEPROM_Init();
+        for (uint16_t i = 0; i < FEE_DENSITY_BYTES / 2; i++) {
+            EEPROM_WriteDataByte(i, (uint8_t)(i + 1));
+        }
+        // fill the rest of the bank so the next write compacts
+        uint32_t used = FEE_DENSITY_BYTES / 2;
+        for (; used < BANK_RECORDS; used++) {
+            EEPROM_WriteDataByte(0, used & 1 ? 0xA0 : 0x01);
+        }
+        uint8_t before = EEPROM_ReadDataByte(0);
+
+        FlashOperationsLeft = budget;
+        EEPROM_WriteDataByte(0, 0x77);
+        FlashOperationsLeft = -1;
+
+        EEPROM_Init();
+        uint8_t first = EEPROM_ReadDataByte(0);
+        EXPECT_TRUE(first == before || first == 0x77) << "budget " << budget;
+        for (uint16_t i = 1; i < FEE_DENSITY_BYTES / 2; i++) {
+            ASSERT_EQ(EEPROM_ReadDataByte(i), (uint8_t)(i + 1)) << "budget " << budget;
+        }
+        // and the log is still usable
+        EEPROM_WriteDataByte(1, 0x99);
+        EEPROM_Init();
+        EXPECT_EQ(EEPROM_ReadDataByte(1), 0x99) << "budget " << budget;
+    }
+}
+
+TEST_F(EepromStm32, EraseClearsEverything) {
+    EEPROM_WriteDataByte(100, 0x12);
+    EEPROM_Erase();
+    EXPECT_EQ(EEPROM_ReadDataByte(100), 0xFF);
+    EEPROM_Init();
+    EXPECT_EQ(EEPROM_ReadDataByte(100), 0xFF);
+}
+
+// Write byte n the way the driver did before the banks, programming the half-word
+// either once from blank or again after a page rewrite
+static void write_legacy(uint16_t n, uint8_t value) {
+    uint16_t *legacy = (uint16_t *)(FlashBuf + (FEE_DENSITY_PAGES - 2) * FEE_PAGE_SIZE);
+    legacy[n]        = n & 1 ? (0xFF00 | value) : value;
+}
+
+TEST_F(EepromStm32, OldLayoutIsMigrated) {
+    flash_mock_reset();
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES; i += 3) {
+        write_legacy(i, (uint8_t)(i + 1));
+    }
+    EEPROM_Init();
+    EEPROM_Init();
+    for (uint16_t i = 0; i < FEE_DENSITY_BYTES; i++) {
+        ASSERT_EQ(EEPROM_ReadDataByte(i), i % 3 ? 0xFF : (uint8_t)(i + 1)) << "byte " << i;
+    }
+    EEPROM_WriteDataByte(1, 0x42);
+    EEPROM_Init();
+    EXPECT_EQ(EEPROM_ReadDataByte(1), 0x42);
+    EXPECT_EQ(EEPROM_ReadDataByte(0), 1);
+}
+
+TEST_F(EepromStm32, PowerLossDuringMigrationKeepsData) {
+    for (int32_t budget = 0; budget < 2 * FEE_BANK_PAGES + FEE_DENSITY_BYTES + 8; budget++) {
+        flash_mock_reset();
+        for (uint16_t i = 0; i < FEE_DENSITY_BYTES; i++) {
+            write_legacy(i, (uint8_t)(i ^ 0x5A));
+        }
+        FlashOperationsLeft = budget;
+        EEPROM_Init();
+        FlashOperationsLeft = -1;
+
+        EEPROM_Init();
+        for (uint16_t i = 0; i < FEE_DENSITY_BYTES; i++) {
+            ASSERT_EQ(EEPROM_ReadDataByte(i), (uint8_t)(i ^ 0x5A)) << "budget " << budget;
+        }
+    }
+}
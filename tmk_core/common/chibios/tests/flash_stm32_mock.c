@@ -0,0 +1,75 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "flash_stm32_mock.h"
+#include "eeprom_stm32.h"
+
+uint8_t  FlashBuf[FEE_DENSITY_PAGES * FEE_PAGE_SIZE];
+uint32_t FlashEraseCount[FEE_DENSITY_PAGES];
+uint32_t FlashProgramCount;
+int32_t  FlashOperationsLeft = -1;
+
+void flash_mock_reset(void) {
+    memset(FlashBuf, 0xFF, sizeof(FlashBuf));
+    memset(FlashEraseCount, 0, sizeof(FlashEraseCount));
+    FlashProgramCount   = 0;
+    FlashOperationsLeft = -1;
+}
+
+// Once FlashOperationsLeft runs out the device is considered powered off
+static bool flash_mock_powered(void) {
+    if (FlashOperationsLeft == 0) {
+        return false;
+    }
+    if (FlashOperationsLeft > 0) {
+        FlashOperationsLeft--;
+    }
+    return true;
+}
+
+FLASH_Status FLASH_ErasePage(uint32_t Page_Address) {
+    if (Page_Address < FEE_PAGE_BASE_ADDRESS || Page_Address >= FEE_LAST_PAGE_ADDRESS || (Page_Address - FEE_PAGE_BASE_ADDRESS) % FEE_PAGE_SIZE != 0) {
+        return FLASH_BAD_ADDRESS;
+    }
+    if (!flash_mock_powered()) {
+        return FLASH_TIMEOUT;
+    }
+    uint32_t page = (Page_Address - FEE_PAGE_BASE_ADDRESS) / FEE_PAGE_SIZE;
+    memset(&FlashBuf[page * FEE_PAGE_SIZE], 0xFF, FEE_PAGE_SIZE);
+    FlashEraseCount[page]++;
+    return FLASH_COMPLETE;
+}
+
+FLASH_Status FLASH_ProgramHalfWord(uint32_t Address, uint16_t Data) {
+    if (Address < FEE_PAGE_BASE_ADDRESS || Address >= FEE_LAST_PAGE_ADDRESS || Address % 2 != 0) {
+        return FLASH_BAD_ADDRESS;
+    }
+    if (!flash_mock_powered()) {
+        return FLASH_TIMEOUT;
+    }
+    uint16_t *cell = (uint16_t *)&FlashBuf[Address - FEE_PAGE_BASE_ADDRESS];
+    // like the hardware, only erased cells can be programmed, except with zero
+    if (*cell != FEE_EMPTY_WORD && Data != 0x0000) {
+        return FLASH_ERROR_PG;
+    }
+    *cell = Data;
+    FlashProgramCount++;
+    return FLASH_COMPLETE;
+}
+
+void FLASH_Unlock(void) {}
+void FLASH_Lock(void) {}
@@ -0,0 +1,6 @@
+eeprom_stm32_DEFS := -DFLASH_STM32_MOCKED -DNO_PRINT -DFEE_PAGE_SIZE=0x400 -DFEE_DENSITY_PAGES=4 -DFEE_MCU_FLASH_SIZE=32
+eeprom_stm32_INC := $(TMK_PATH)/common/chibios
+eeprom_stm32_SRC := \
+	$(TMK_PATH)/common/chibios/tests/flash_stm32_mock.c \
+	$(TMK_PATH)/common/chibios/tests/eeprom_stm32_tests.cpp \
+	$(TMK_PATH)/common/chibios/eeprom_stm32.c
@@ -0,0 +1 @@
+TEST_LIST += eeprom_stm32
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "host.h"
 #include "util.h"
 #include "debug.h"
+#include "task_profile.h"
 
 #ifdef NKRO_ENABLE
 #    include "keycode_config.h"
@@ -62,7 +63,9 @@ void host_keyboard_send(report_keyboard_t *report) {
         report->report_id = REPORT_ID_KEYBOARD;
 #endif
     }
+    TASK_PROFILE_BEGIN(TASK_PROFILE_USB_SEND);
     (*driver->send_keyboard)(report);
+    TASK_PROFILE_END(TASK_PROFILE_USB_SEND);
 
     if (debug_keyboard) {
         dprint("keyboard_report: ");
@@ -78,7 +81,9 @@ void host_mouse_send(report_mouse_t *report) {
 #ifdef MOUSE_SHARED_EP
     report->report_id = REPORT_ID_MOUSE;
 #endif
+    TASK_PROFILE_BEGIN(TASK_PROFILE_USB_SEND);
     (*driver->send_mouse)(report);
+    TASK_PROFILE_END(TASK_PROFILE_USB_SEND);
 }
 
 void host_system_send(uint16_t report) {
@@ -86,7 +91,9 @@ void host_system_send(uint16_t report) {
     last_system_report = report;
 
     if (!driver) return;
+    TASK_PROFILE_BEGIN(TASK_PROFILE_USB_SEND);
     (*driver->send_system)(report);
+    TASK_PROFILE_END(TASK_PROFILE_USB_SEND);
 }
 
 void host_consumer_send(uint16_t report) {
@@ -94,7 +101,9 @@ void host_consumer_send(uint16_t report) {
     last_consumer_report = report;
 
     if (!driver) return;
+    TASK_PROFILE_BEGIN(TASK_PROFILE_USB_SEND);
     (*driver->send_consumer)(report);
+    TASK_PROFILE_END(TASK_PROFILE_USB_SEND);
 }
 
 uint16_t host_last_system_report(void) { return last_system_report; }
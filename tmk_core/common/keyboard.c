@@ -31,6 +31,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "sendchar.h"
 #include "eeconfig.h"
 #include "action_layer.h"
+#include "task_profile.h"
 #ifdef BACKLIGHT_ENABLE
 #    include "backlight.h"
 #endif
@@ -136,6 +137,27 @@ uint32_t get_matrix_scan_rate(void) { return last_matrix_scan_count; }
 #    define matrix_scan_perf_task()
 #endif
 
+#ifdef KEYEVENT_QUEUE_SIZE
+#    if KEYEVENT_QUEUE_SIZE > 128 || (KEYEVENT_QUEUE_SIZE & (KEYEVENT_QUEUE_SIZE - 1))
+#        error "KEYEVENT_QUEUE_SIZE must be a power of two no larger than 128"
+#    endif
+/* Matrix changes waiting for the action pipeline.
+ * Every change seen by a scan is queued with the time it was detected, and the
+ * queue is drained in bulk afterwards, so a chord is delivered in a single
+ * keyboard_task() call instead of one scan per key.
+ */
+static keyevent_t keyevent_queue[KEYEVENT_QUEUE_SIZE];
+static uint8_t    keyevent_queue_head = 0;
+static uint8_t    keyevent_queue_tail = 0;
+
+static inline bool keyevent_queue_is_empty(void) { return keyevent_queue_head == keyevent_queue_tail; }
+static inline bool keyevent_queue_is_full(void) { return (uint8_t)(keyevent_queue_head - keyevent_queue_tail) >= KEYEVENT_QUEUE_SIZE; }
+
+static inline void keyevent_queue_push(keyevent_t event) { keyevent_queue[keyevent_queue_head++ & (KEYEVENT_QUEUE_SIZE - 1)] = event; }
+
+static inline keyevent_t keyevent_queue_pop(void) { return keyevent_queue[keyevent_queue_tail++ & (KEYEVENT_QUEUE_SIZE - 1)]; }
+#endif
+
 #ifdef MATRIX_HAS_GHOST
 extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
 static matrix_row_t   get_real_keys(uint8_t row, matrix_row_t rowdata) {
@@ -277,6 +299,9 @@ __attribute__((weak)) void housekeeping_task_user(void) {}
 void keyboard_init(void) {
     timer_init();
     sync_timer_init();
+#ifdef TASK_PROFILE_ENABLE
+    task_profile_init();
+#endif
     matrix_init();
 #ifdef VIA_ENABLE
     via_init();
@@ -366,21 +391,73 @@ void keyboard_task(void) {
     bool encoders_changed = false;
 #endif
 
+    TASK_PROFILE_BEGIN(TASK_PROFILE_KEYBOARD_TASK);
+
     housekeeping_task_kb();
     housekeeping_task_user();
 
+    TASK_PROFILE_BEGIN(TASK_PROFILE_MATRIX_SCAN);
     uint8_t matrix_changed = matrix_scan();
+    TASK_PROFILE_END(TASK_PROFILE_MATRIX_SCAN);
     if (matrix_changed) last_matrix_activity_trigger();
 
+    TASK_PROFILE_BEGIN(TASK_PROFILE_ACTION);
+
+#ifdef KEYEVENT_QUEUE_SIZE
+    // all changes found by this scan share its detection time
+    uint16_t detection_time = timer_read() | 1; /* time should not be 0 */
+    bool     process_keys   = should_process_keypress();
+
     for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
         matrix_row    = matrix_get_row(r);
         matrix_change = matrix_row ^ matrix_prev[r];
         if (matrix_change) {
-#ifdef MATRIX_HAS_GHOST
+#    ifdef MATRIX_HAS_GHOST
             if (has_ghost_in_row(r, matrix_row)) {
                 continue;
             }
-#endif
+#    endif
+            if (debug_matrix) matrix_print();
+            matrix_row_t col_mask = 1;
+            for (uint8_t c = 0; c < MATRIX_COLS; c++, col_mask <<= 1) {
+                if (matrix_change & col_mask) {
+                    if (process_keys) {
+                        // leave the change unrecorded, it is picked up by a later scan
+                        if (keyevent_queue_is_full()) goto MATRIX_QUEUE_FULL;
+                        keyevent_queue_push((keyevent_t){.key = (keypos_t){.row = r, .col = c}, .pressed = (matrix_row & col_mask), .time = detection_time});
+                    }
+                    // record a queued key
+                    matrix_prev[r] ^= col_mask;
+
+                    switch_events(r, c, (matrix_row & col_mask));
+                }
+            }
+        }
+    }
+MATRIX_QUEUE_FULL:
+
+    if (keyevent_queue_is_empty()) {
+        // call with pseudo tick event when no real key event.
+        action_exec(TICK);
+    } else {
+        do {
+            action_exec(keyevent_queue_pop());
+#    ifdef QMK_KEYS_PER_SCAN
+            // only jump out if we have processed "enough" keys.
+            if (++keys_processed >= QMK_KEYS_PER_SCAN) break;
+#    endif
+        } while (!keyevent_queue_is_empty());
+    }
+#else
+    for (uint8_t r = 0; r < MATRIX_ROWS; r++) {
+        matrix_row    = matrix_get_row(r);
+        matrix_change = matrix_row ^ matrix_prev[r];
+        if (matrix_change) {
+#    ifdef MATRIX_HAS_GHOST
+            if (has_ghost_in_row(r, matrix_row)) {
+                continue;
+            }
+#    endif
             if (debug_matrix) matrix_print();
             matrix_row_t col_mask = 1;
             for (uint8_t c = 0; c < MATRIX_COLS; c++, col_mask <<= 1) {
@@ -395,10 +472,10 @@ void keyboard_task(void) {
 
                     switch_events(r, c, (matrix_row & col_mask));
 
-#ifdef QMK_KEYS_PER_SCAN
+#    ifdef QMK_KEYS_PER_SCAN
                     // only jump out if we have processed "enough" keys.
                     if (++keys_processed >= QMK_KEYS_PER_SCAN)
-#endif
+#    endif
                         // process a key per task call
                         goto MATRIX_LOOP_END;
                 }
@@ -406,13 +483,15 @@ void keyboard_task(void) {
         }
     }
     // call with pseudo tick event when no real key event.
-#ifdef QMK_KEYS_PER_SCAN
+#    ifdef QMK_KEYS_PER_SCAN
     // we can get here with some keys processed now.
     if (!keys_processed)
-#endif
+#    endif
         action_exec(TICK);
 
 MATRIX_LOOP_END:
+#endif
+    TASK_PROFILE_END(TASK_PROFILE_ACTION);
 
 #ifdef DEBUG_MATRIX_SCAN_RATE
     matrix_scan_perf_task();
@@ -423,7 +502,9 @@ MATRIX_LOOP_END:
 #endif
 
 #ifdef RGB_MATRIX_ENABLE
+    TASK_PROFILE_BEGIN(TASK_PROFILE_RGB_MATRIX);
     rgb_matrix_task();
+    TASK_PROFILE_END(TASK_PROFILE_RGB_MATRIX);
 #endif
 
 #if defined(BACKLIGHT_ENABLE)
@@ -442,7 +523,9 @@ MATRIX_LOOP_END:
 #endif
 
 #ifdef OLED_DRIVER_ENABLE
+    TASK_PROFILE_BEGIN(TASK_PROFILE_OLED);
     oled_task();
+    TASK_PROFILE_END(TASK_PROFILE_OLED);
 #    ifndef OLED_DISABLE_TIMEOUT
     // Wake up oled if user is using those fabulous keys or spinning those encoders!
 #        ifdef ENCODER_ENABLE
@@ -501,6 +584,11 @@ MATRIX_LOOP_END:
         led_status = host_keyboard_leds();
         keyboard_set_leds(led_status);
     }
+
+    TASK_PROFILE_END(TASK_PROFILE_KEYBOARD_TASK);
+#ifdef TASK_PROFILE_ENABLE
+    task_profile_task();
+#endif
 }
 
 /** \brief keyboard set leds
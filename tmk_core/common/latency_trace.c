@@ -0,0 +1,97 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "latency_trace.h"
+#include "timer.h"
+
+static latency_trace_t trace;
+
+// detection time of the record being processed
+static uint16_t record_time = 0;
+// detection time of the oldest event that has not produced a report
+static uint16_t pending_time = 0;
+
+// events that never produce a report (layer keys, KC_NO) must not be blamed for a later one
+static bool pending_expired(void) { return TIMER_DIFF_16(timer_read() | 1, pending_time) > LATENCY_TRACE_TIMEOUT; }
+
+void latency_trace_event(keyevent_t event) {
+    if (!IS_NOEVENT(event) && (!pending_time || pending_expired())) {
+        pending_time = event.time;
+    }
+}
+
+uint16_t latency_trace_record(uint16_t time) {
+    uint16_t previous = record_time;
+    record_time       = time;
+    return previous;
+}
+
+static uint8_t bucket_of(uint16_t latency) {
+    if (latency < 4) {
+        return latency;
+    }
+    uint8_t msb = 0;
+    for (uint16_t v = latency; v > 1; v >>= 1) {
+        msb++;
+    }
+    uint8_t bucket = msb * 2 + ((latency >> (msb - 1)) & 1);
+    return bucket < LATENCY_TRACE_BUCKETS ? bucket : LATENCY_TRACE_BUCKETS - 1;
+}
+
+uint16_t latency_trace_bucket_floor(uint8_t bucket) {
+    if (bucket < 4) {
+        return bucket;
+    }
+    uint8_t msb = bucket / 2;
+    return (1 << msb) | ((bucket & 1) << (msb - 1));
+}
+
+bool latency_trace_take(uint16_t *latency) {
+    uint16_t detected = record_time;
+    if (!detected && pending_time && !pending_expired()) {
+        detected = pending_time;
+    }
+    pending_time = 0;
+    if (!detected) {
+        return false;
+    }
+    *latency = TIMER_DIFF_16(timer_read() | 1, detected);
+    return true;
+}
+
+void latency_trace_add(uint16_t latency) {
+    trace.count++;
+    trace.total += latency;
+    if (latency > trace.max) {
+        trace.max = latency;
+    }
+    uint8_t bucket = bucket_of(latency);
+    if (trace.histogram[bucket] < UINT16_MAX) {
+        trace.histogram[bucket]++;
+    }
+}
+
+void latency_trace_report(void) {
+    uint16_t latency;
+    if (latency_trace_take(&latency)) {
+        latency_trace_add(latency);
+    }
+}
+
+const latency_trace_t *latency_trace_get(void) { return &trace; }
+
+void latency_trace_clear(void) { memset(&trace, 0, sizeof(trace)); }
@@ -0,0 +1,75 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "keyboard.h"
+
+/* Key-to-report latency tracer
+ *
+ * Measures the milliseconds between a key event being detected by the matrix
+ * scan (keyevent_t.time) and the keyboard report it causes being handed to
+ * the USB/Bluetooth driver. A report sent while a record is being processed
+ * is attributed to that record, so a tap-hold key replayed from the tapping
+ * buffer counts from its own press. Reports sent outside of record processing
+ * (auto shift or combo timeouts) count from the oldest event that has not
+ * produced a report yet, unless it is older than LATENCY_TRACE_TIMEOUT.
+ *
+ * Latencies are kept in LATENCY_TRACE_BUCKETS buckets: 1 ms wide up to 4 ms,
+ * then two buckets per power of two, the last one being open ended.
+ */
+
+#define LATENCY_TRACE_BUCKETS 16
+
+// Events waiting longer than this for a report are assumed to have caused none
+#ifndef LATENCY_TRACE_TIMEOUT
+#    define LATENCY_TRACE_TIMEOUT 1000
+#endif
+
+typedef struct {
+    uint32_t count;
+    uint32_t total;
+    uint16_t max;
+    uint16_t histogram[LATENCY_TRACE_BUCKETS];
+} latency_trace_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* an event entered action_exec() */
+void latency_trace_event(keyevent_t event);
+/* attribute reports to the record detected at time, 0 for none; returns the previous attribution */
+uint16_t latency_trace_record(uint16_t time);
+/* a keyboard report was submitted to the host */
+void latency_trace_report(void);
+/* For drivers that send a report later than it is submitted: takes the
+ * latency so far of a report submitted now, false if it belongs to no event.
+ * The driver adds the time it held on to the report and hands the total to
+ * latency_trace_add(), which may be called from an interrupt. */
+bool latency_trace_take(uint16_t *latency);
+void latency_trace_add(uint16_t latency);
+
+const latency_trace_t *latency_trace_get(void);
+void                   latency_trace_clear(void);
+/* lowest latency in ms that falls into the bucket */
+uint16_t latency_trace_bucket_floor(uint8_t bucket);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,196 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include "task_profile.h"
+#include "timer.h"
+#include "debug.h"
+
+#if defined(__AVR__)
+#    include <avr/io.h>
+#    include <util/atomic.h>
+#    include "timer_avr.h"
+#elif defined(PROTOCOL_CHIBIOS)
+#    include <ch.h>
+#    include <hal.h>
+#endif
+
+// Durations are binned by bit length, p99 is reported as the upper end of its bin
+#define TASK_PROFILE_BUCKETS 24
+
+typedef struct {
+    uint32_t count;
+    uint32_t total;
+    uint32_t min;
+    uint32_t max;
+    uint16_t histogram[TASK_PROFILE_BUCKETS];
+} task_profile_stats_t;
+
+static task_profile_stats_t   live[TASK_PROFILE_STAGE_COUNT];
+static task_profile_summary_t last[TASK_PROFILE_STAGE_COUNT];
+
+static uint32_t interval_start_time;
+static uint32_t interval_start_ticks;
+static uint32_t ticks_per_ms;
+
+#if defined(__AVR__)
+#    if defined(TIFR0)
+#        define TIMER_FLAGS TIFR0
+#        define TIMER_MATCH_FLAG OCF0A
+#    elif defined(OCF0A)
+#        define TIMER_FLAGS TIFR
+#        define TIMER_MATCH_FLAG OCF0A
+#    else
+#        define TIMER_FLAGS TIFR
+#        define TIMER_MATCH_FLAG OCF0
+#    endif
+
+extern volatile uint32_t timer_count;
+
+uint32_t task_profile_ticks(void) {
+    uint32_t ms;
+    uint8_t  raw;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        ms  = timer_count;
+        raw = TIMER_RAW;
+        // Timer0 may have wrapped without its interrupt having run yet
+        if ((TIMER_FLAGS & _BV(TIMER_MATCH_FLAG)) && raw < TIMER_RAW_TOP / 2) {
+            ms++;
+        }
+    }
+    return ms * (TIMER_RAW_TOP + 1) + raw;
+}
+#elif defined(PROTOCOL_CHIBIOS) && defined(__CORTEX_M) && (__CORTEX_M >= 3)
+#    define TASK_PROFILE_CYCLE_COUNTER
+
+uint32_t task_profile_ticks(void) { return DWT->CYCCNT; }
+#elif defined(PROTOCOL_CHIBIOS)
+uint32_t task_profile_ticks(void) { return (uint32_t)chVTGetSystemTimeX(); }
+#else
+uint32_t task_profile_ticks(void) { return timer_read32(); }
+#endif
+
+uint32_t task_profile_ticks_per_ms(void) { return ticks_per_ms; }
+
+static uint8_t bucket_of(uint32_t ticks) {
+    uint8_t bucket = 0;
+    while (ticks && bucket < TASK_PROFILE_BUCKETS - 1) {
+        ticks >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void task_profile_record(uint8_t stage, uint32_t ticks) {
+    task_profile_stats_t *stats = &live[stage];
+
+    if (stats->count == 0 || ticks < stats->min) {
+        stats->min = ticks;
+    }
+    if (ticks > stats->max) {
+        stats->max = ticks;
+    }
+    stats->total += ticks;
+    stats->count++;
+
+    uint8_t bucket = bucket_of(ticks);
+    if (stats->histogram[bucket] < UINT16_MAX) {
+        stats->histogram[bucket]++;
+    }
+}
+
+static uint32_t percentile_99(const task_profile_stats_t *stats) {
+    // the sample at or above which 1% of the samples lie
+    uint32_t rank = stats->count - stats->count / 100;
+    uint32_t seen = 0;
+    for (uint8_t bucket = 0; bucket < TASK_PROFILE_BUCKETS; bucket++) {
+        seen += stats->histogram[bucket];
+        if (seen >= rank) {
+            uint32_t upper = bucket ? (((uint32_t)1 << bucket) - 1) : 0;
+            return upper < stats->max && bucket < TASK_PROFILE_BUCKETS - 1 ? upper : stats->max;
+        }
+    }
+    return stats->max;
+}
+
+static void summarise(void) {
+    for (uint8_t stage = 0; stage < TASK_PROFILE_STAGE_COUNT; stage++) {
+        task_profile_stats_t *stats = &live[stage];
+
+        last[stage].count = stats->count;
+        last[stage].min   = stats->min;
+        last[stage].avg   = stats->count ? stats->total / stats->count : 0;
+        last[stage].max   = stats->max;
+        last[stage].p99   = stats->count ? percentile_99(stats) : 0;
+    }
+    memset(live, 0, sizeof(live));
+}
+
+#ifdef CONSOLE_ENABLE
+static const char *const stage_names[TASK_PROFILE_STAGE_COUNT] = {
+    [TASK_PROFILE_KEYBOARD_TASK]   = "keyboard_task",
+    [TASK_PROFILE_MATRIX_SCAN]     = "matrix_scan",
+    [TASK_PROFILE_DEBOUNCE]        = "debounce",
+    [TASK_PROFILE_SPLIT_TRANSPORT] = "split_transport",
+    [TASK_PROFILE_ACTION]          = "action_exec",
+    [TASK_PROFILE_USB_SEND]        = "usb_send",
+    [TASK_PROFILE_RGB_MATRIX]      = "rgb_matrix_task",
+    [TASK_PROFILE_OLED]            = "oled_task",
+};
+
+static void print_summary(void) {
+    dprintf("task profile (%lu ticks/ms): stage count min avg max p99\n", ticks_per_ms);
+    for (uint8_t stage = 0; stage < TASK_PROFILE_STAGE_COUNT; stage++) {
+        if (last[stage].count) {
+            dprintf("  %s %lu %lu %lu %lu %lu\n", stage_names[stage], last[stage].count, last[stage].min, last[stage].avg, last[stage].max, last[stage].p99);
+        }
+    }
+}
+#endif
+
+void task_profile_task(void) {
+    uint32_t now     = timer_read32();
+    uint32_t elapsed = TIMER_DIFF_32(now, interval_start_time);
+    if (elapsed < TASK_PROFILE_INTERVAL) {
+        return;
+    }
+
+    uint32_t ticks       = task_profile_ticks();
+    ticks_per_ms         = (ticks - interval_start_ticks) / elapsed;
+    interval_start_time  = now;
+    interval_start_ticks = ticks;
+
+    summarise();
+#ifdef CONSOLE_ENABLE
+    print_summary();
+#endif
+}
+
+void task_profile_init(void) {
+#ifdef TASK_PROFILE_CYCLE_COUNTER
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+#    if (__CORTEX_M == 7)
+    DWT->LAR = 0xC5ACCE55;  // unlock the DWT registers
+#    endif
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+    memset(live, 0, sizeof(live));
+    memset(last, 0, sizeof(last));
+    interval_start_time  = timer_read32();
+    interval_start_ticks = task_profile_ticks();
+}
+
+const task_profile_summary_t *task_profile_get(uint8_t stage) { return stage < TASK_PROFILE_STAGE_COUNT ? &last[stage] : NULL; }
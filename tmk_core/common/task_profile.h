@@ -0,0 +1,82 @@
+/* Copyright 2021 QMK
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Per-stage timing of keyboard_task()
+ *
+ * Stages are timed with the finest counter the platform has: the DWT cycle
+ * counter on Cortex-M3 and up, the ChibiOS system tick elsewhere on ChibiOS,
+ * and Timer0 ticks on AVR. Every TASK_PROFILE_INTERVAL ms the collected
+ * durations are summarised, printed to the console and made available to
+ * task_profile_get(). Stages nest: matrix scan includes debounce and split
+ * transport, action includes USB send.
+ */
+
+#ifndef TASK_PROFILE_INTERVAL
+#    define TASK_PROFILE_INTERVAL 1000
+#endif
+
+enum task_profile_stage {
+    TASK_PROFILE_KEYBOARD_TASK,
+    TASK_PROFILE_MATRIX_SCAN,
+    TASK_PROFILE_DEBOUNCE,
+    TASK_PROFILE_SPLIT_TRANSPORT,
+    TASK_PROFILE_ACTION,
+    TASK_PROFILE_USB_SEND,
+    TASK_PROFILE_RGB_MATRIX,
+    TASK_PROFILE_OLED,
+    TASK_PROFILE_STAGE_COUNT,
+};
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t avg;
+    uint32_t max;
+    uint32_t p99;
+} task_profile_summary_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* current value of the profiling counter */
+uint32_t task_profile_ticks(void);
+/* counter ticks per millisecond, measured over the last interval */
+uint32_t task_profile_ticks_per_ms(void);
+
+void task_profile_record(uint8_t stage, uint32_t ticks);
+void task_profile_task(void);
+void task_profile_init(void);
+
+/* summary of the last complete interval */
+const task_profile_summary_t *task_profile_get(uint8_t stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef TASK_PROFILE_ENABLE
+#    define TASK_PROFILE_BEGIN(stage) uint32_t task_profile_start_##stage = task_profile_ticks()
+#    define TASK_PROFILE_END(stage) task_profile_record(stage, task_profile_ticks() - task_profile_start_##stage)
+#else
+#    define TASK_PROFILE_BEGIN(stage)
+#    define TASK_PROFILE_END(stage)
+#endif
@@ -25,6 +25,7 @@
 #include "host.h"
 #include "host_driver.h"
 #include "keyboard.h"
+#include "matrix.h"
 #include "action.h"
 #include "action_util.h"
 #include "mousekey.h"
@@ -272,5 +273,10 @@ int main(void) {
         // Run housekeeping
         housekeeping_task_kb();
         housekeeping_task_user();
+
+#ifdef MATRIX_IDLE_TIMEOUT
+        // Nothing to scan, sleep until a key is pressed or the next poll
+        matrix_idle_wait();
+#endif
     }
 }
@@ -42,6 +42,10 @@
 #include "usb_descriptor.h"
 #include "usb_driver.h"
 
+#ifdef LATENCY_TRACE_ENABLE
+#    include "latency_trace.h"
+#endif
+
 #ifdef NKRO_ENABLE
 #    include "keycode_config.h"
 
@@ -364,6 +368,141 @@ static usb_driver_configs_t drivers = {
 
 #define NUM_USB_DRIVERS (sizeof(drivers) / sizeof(usb_driver_config_t))
 
+/* ---------------------------------------------------------
+ *                      Report queues
+ * ---------------------------------------------------------
+ */
+
+#ifdef USB_REPORT_QUEUE_SIZE
+/* Reports are copied into a small FIFO per endpoint instead of waiting for
+ * the previous IN transfer to complete; the IN callback of the endpoint
+ * starts the next one. The head of the queue is the report being sent. */
+typedef struct {
+    bool    keyboard;
+    uint8_t size;
+    uint8_t data[sizeof(report_keyboard_t)];
+#    ifdef LATENCY_TRACE_ENABLE
+    uint16_t  lag;     // ms from the key event to being queued, REPORT_UNTRACED if none
+    systime_t queued;  // the trace ends when the report starts on the endpoint
+#    endif
+} usb_report_t;
+
+#    define REPORT_UNTRACED UINT16_MAX
+
+typedef struct {
+    usbep_t            ep;
+    bool               in_flight;
+    uint8_t            head;
+    uint8_t            count;
+    thread_reference_t waiter;
+    usb_report_t       reports[USB_REPORT_QUEUE_SIZE];
+} usb_report_queue_t;
+
+#    ifndef KEYBOARD_SHARED_EP
+static usb_report_queue_t keyboard_queue = {.ep = KEYBOARD_IN_EPNUM};
+#        define KEYBOARD_QUEUE (&keyboard_queue)
+#    endif
+#    ifdef SHARED_EP_ENABLE
+static usb_report_queue_t shared_queue = {.ep = SHARED_IN_EPNUM};
+#        ifdef KEYBOARD_SHARED_EP
+#            define KEYBOARD_QUEUE (&shared_queue)
+#        endif
+#    endif
+
+static void report_queue_startI(usb_report_queue_t *queue) {
+    if (queue->in_flight || queue->count == 0 || usbGetTransmitStatusI(&USB_DRIVER, queue->ep)) {
+        return;
+    }
+    usb_report_t *report = &queue->reports[queue->head];
+    queue->in_flight     = true;
+    usbStartTransmitI(&USB_DRIVER, queue->ep, report->data, report->size);
+#    ifdef LATENCY_TRACE_ENABLE
+    if (report->lag != REPORT_UNTRACED) {
+        latency_trace_add(report->lag + TIME_I2MS(chVTTimeElapsedSinceX(report->queued)));
+    }
+#    endif
+}
+
+/* add a report to the queue and start sending it if the endpoint is idle
+ * lag is the latency so far to trace it with, or REPORT_UNTRACED
+ * returns false if the queue is full */
+static bool report_queue_putI(usb_report_queue_t *queue, bool keyboard, const void *data, uint8_t size, uint16_t lag) {
+    if (keyboard) {
+        /* A keyboard state equal to the newest one queued is superseded by it.
+         * Other pending states are kept: merging them would drop or reorder
+         * key transitions on the host. */
+        for (uint8_t i = queue->count; i > 0; i--) {
+            usb_report_t *report = &queue->reports[(queue->head + i - 1) % USB_REPORT_QUEUE_SIZE];
+            if (report->keyboard) {
+                if (report->size == size && memcmp(report->data, data, size) == 0) {
+                    return true;
+                }
+                break;
+            }
+        }
+    }
+
+    if (queue->count == USB_REPORT_QUEUE_SIZE) {
+        return false;
+    }
+    usb_report_t *report = &queue->reports[(queue->head + queue->count) % USB_REPORT_QUEUE_SIZE];
+    report->keyboard     = keyboard;
+    report->size         = size;
+    memcpy(report->data, data, size);
+#    ifdef LATENCY_TRACE_ENABLE
+    report->lag    = lag;
+    report->queued = chVTGetSystemTimeX();
+#    else
+    (void)lag;
+#    endif
+    queue->count++;
+
+    report_queue_startI(queue);
+    return true;
+}
+
+/* queue a report, waiting for a free slot if needed
+ * not callable from ISR, called in locked state */
+static bool report_queue_sendS(usb_report_queue_t *queue, bool keyboard, const void *data, uint8_t size, uint16_t lag) {
+    while (!report_queue_putI(queue, keyboard, data, size, lag)) {
+        /* every slot is taken, wait for the IN callback to free one */
+        if (osalThreadSuspendS(&queue->waiter) != MSG_OK || usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* the report at the head of the queue has made it IN
+ * called from the IN callback of the endpoint, locked */
+static void report_queue_doneI(usb_report_queue_t *queue) {
+    if (queue->in_flight) {
+        queue->in_flight = false;
+        queue->head      = (queue->head + 1) % USB_REPORT_QUEUE_SIZE;
+        queue->count--;
+        osalThreadResumeI(&queue->waiter, MSG_OK);
+    }
+    report_queue_startI(queue);
+}
+
+static void report_queue_resetI(usb_report_queue_t *queue) {
+    queue->in_flight = false;
+    queue->head      = 0;
+    queue->count     = 0;
+    osalThreadResumeI(&queue->waiter, MSG_RESET);
+}
+
+/* drop every queued report, the endpoints have been (re)initialised */
+static void usb_report_queues_resetI(void) {
+#    ifndef KEYBOARD_SHARED_EP
+    report_queue_resetI(&keyboard_queue);
+#    endif
+#    ifdef SHARED_EP_ENABLE
+    report_queue_resetI(&shared_queue);
+#    endif
+}
+#endif /* USB_REPORT_QUEUE_SIZE */
+
 /* ---------------------------------------------------------
  *                  USB driver functions
  * ---------------------------------------------------------
@@ -463,6 +602,9 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
                 }
                 qmkusbConfigureHookI(&drivers.array[i].driver);
             }
+#ifdef USB_REPORT_QUEUE_SIZE
+            usb_report_queues_resetI();
+#endif
             osalSysUnlockFromISR();
             return;
         case USB_EVENT_SUSPEND:
@@ -477,6 +619,11 @@ static void usb_event_cb(USBDriver *usbp, usbevent_t event) {
                 qmkusbSuspendHookI(&drivers.array[i].driver);
                 chSysUnlockFromISR();
             }
+#ifdef USB_REPORT_QUEUE_SIZE
+            osalSysLockFromISR();
+            usb_report_queues_resetI();
+            osalSysUnlockFromISR();
+#endif
             return;
 
         case USB_EVENT_WAKEUP:
@@ -730,9 +877,13 @@ void restart_usb_driver(USBDriver *usbp) {
 /* keyboard IN callback hander (a kbd report has made it IN) */
 #ifndef KEYBOARD_SHARED_EP
 void kbd_in_cb(USBDriver *usbp, usbep_t ep) {
-    /* STUB */
     (void)usbp;
     (void)ep;
+#    ifdef USB_REPORT_QUEUE_SIZE
+    osalSysLockFromISR();
+    report_queue_doneI(&keyboard_queue);
+    osalSysUnlockFromISR();
+#    endif
 }
 #endif
 
@@ -761,9 +912,15 @@ static void keyboard_idle_timer_cb(void *arg) {
     if (keyboard_idle && keyboard_protocol) {
 #endif /* NKRO_ENABLE */
         /* TODO: are we sure we want the KBD_ENDPOINT? */
+#ifdef USB_REPORT_QUEUE_SIZE
+        if (KEYBOARD_QUEUE->count == 0) {
+            report_queue_putI(KEYBOARD_QUEUE, true, &keyboard_report_sent, KEYBOARD_EPSIZE, REPORT_UNTRACED);
+        }
+#else
         if (!usbGetTransmitStatusI(usbp, KEYBOARD_IN_EPNUM)) {
             usbStartTransmitI(usbp, KEYBOARD_IN_EPNUM, (uint8_t *)&keyboard_report_sent, KEYBOARD_EPSIZE);
         }
+#endif
         /* rearm the timer */
         chVTSetI(&keyboard_idle_timer, 4 * TIME_MS2I(keyboard_idle), keyboard_idle_timer_cb, (void *)usbp);
     }
@@ -779,6 +936,17 @@ uint8_t keyboard_leds(void) { return keyboard_led_state; }
 /* prepare and start sending a report IN
  * not callable from ISR or locked state */
 void send_keyboard(report_keyboard_t *report) {
+#ifdef USB_REPORT_QUEUE_SIZE
+    uint16_t lag = REPORT_UNTRACED;
+#    ifdef LATENCY_TRACE_ENABLE
+    // the tracer reads the system time, which takes the lock
+    if (!latency_trace_take(&lag)) {
+        lag = REPORT_UNTRACED;
+    }
+#    endif
+#elif defined(LATENCY_TRACE_ENABLE)
+    bool sent = false;
+#endif
     osalSysLock();
     if (usbGetDriverStateI(&USB_DRIVER) != USB_ACTIVE) {
         goto unlock;
@@ -786,6 +954,11 @@ void send_keyboard(report_keyboard_t *report) {
 
 #ifdef NKRO_ENABLE
     if (keymap_config.nkro && keyboard_protocol) { /* NKRO protocol */
+#    ifdef USB_REPORT_QUEUE_SIZE
+        if (!report_queue_sendS(&shared_queue, true, report, sizeof(struct nkro_report), lag)) {
+            goto unlock;
+        }
+#    else
         /* need to wait until the previous packet has made it through */
         /* can rewrite this using the synchronous API, then would wait
          * until *after* the packet has been transmitted. I think
@@ -804,9 +977,11 @@ void send_keyboard(report_keyboard_t *report) {
             }
         }
         usbStartTransmitI(&USB_DRIVER, SHARED_IN_EPNUM, (uint8_t *)report, sizeof(struct nkro_report));
+#    endif
     } else
 #endif /* NKRO_ENABLE */
     {  /* regular protocol */
+#ifndef USB_REPORT_QUEUE_SIZE
         /* need to wait until the previous packet has made it through */
         /* busy wait, should be short and not very common */
         if (usbGetTransmitStatusI(&USB_DRIVER, KEYBOARD_IN_EPNUM)) {
@@ -821,6 +996,7 @@ void send_keyboard(report_keyboard_t *report) {
                 goto unlock;
             }
         }
+#endif
         uint8_t *data, size;
         if (keyboard_protocol) {
             data = (uint8_t *)report;
@@ -829,12 +1005,27 @@ void send_keyboard(report_keyboard_t *report) {
             data = &report->mods;
             size = 8;
         }
+#ifdef USB_REPORT_QUEUE_SIZE
+        if (!report_queue_sendS(KEYBOARD_QUEUE, true, data, size, lag)) {
+            goto unlock;
+        }
+#else
         usbStartTransmitI(&USB_DRIVER, KEYBOARD_IN_EPNUM, data, size);
+#endif
     }
     keyboard_report_sent = *report;
+#if defined(LATENCY_TRACE_ENABLE) && !defined(USB_REPORT_QUEUE_SIZE)
+    sent = true;
+#endif
 
 unlock:
     osalSysUnlock();
+#if defined(LATENCY_TRACE_ENABLE) && !defined(USB_REPORT_QUEUE_SIZE)
+    // the tracer reads the system time, which takes the lock
+    if (sent) {
+        latency_trace_report();
+    }
+#endif
 }
 
 /* ---------------------------------------------------------
@@ -859,6 +1050,9 @@ void send_mouse(report_mouse_t *report) {
         return;
     }
 
+#    if defined(USB_REPORT_QUEUE_SIZE) && defined(MOUSE_SHARED_EP)
+    report_queue_sendS(&shared_queue, false, report, sizeof(report_mouse_t), REPORT_UNTRACED);
+#    else
     if (usbGetTransmitStatusI(&USB_DRIVER, MOUSE_IN_EPNUM)) {
         /* Need to either suspend, or loop and call unlock/lock during
          * every iteration - otherwise the system will remain locked,
@@ -870,6 +1064,7 @@ void send_mouse(report_mouse_t *report) {
         }
     }
     usbStartTransmitI(&USB_DRIVER, MOUSE_IN_EPNUM, (uint8_t *)report, sizeof(report_mouse_t));
+#    endif
     osalSysUnlock();
 }
 
@@ -884,9 +1079,13 @@ void send_mouse(report_mouse_t *report) { (void)report; }
 #ifdef SHARED_EP_ENABLE
 /* shared IN callback hander */
 void shared_in_cb(USBDriver *usbp, usbep_t ep) {
-    /* STUB */
     (void)usbp;
     (void)ep;
+#    ifdef USB_REPORT_QUEUE_SIZE
+    osalSysLockFromISR();
+    report_queue_doneI(&shared_queue);
+    osalSysUnlockFromISR();
+#    endif
 }
 #endif
 
@@ -905,7 +1104,11 @@ static void send_extra(uint8_t report_id, uint16_t data) {
 
     report_extra_t report = {.report_id = report_id, .usage = data};
 
+#    ifdef USB_REPORT_QUEUE_SIZE
+    report_queue_sendS(&shared_queue, false, &report, sizeof(report_extra_t), REPORT_UNTRACED);
+#    else
     usbStartTransmitI(&USB_DRIVER, SHARED_IN_EPNUM, (uint8_t *)&report, sizeof(report_extra_t));
+#    endif
     osalSysUnlock();
 }
 #endif
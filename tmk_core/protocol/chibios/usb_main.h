@@ -29,7 +29,14 @@
  */
 
 /* The USB driver to use */
-#define USB_DRIVER USBD1
+#ifndef USB_DRIVER
+#    ifdef USB_HIGH_SPEED
+/* OTG_HS on STM32 */
+#        define USB_DRIVER USBD2
+#    else
+#        define USB_DRIVER USBD1
+#    endif
+#endif
 
 /* Initialize the USB driver and bus */
 void init_usb_driver(USBDriver *usbp);
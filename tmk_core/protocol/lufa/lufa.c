@@ -54,6 +54,10 @@
 #include "quantum.h"
 #include <util/atomic.h>
 
+#ifdef LATENCY_TRACE_ENABLE
+#    include "latency_trace.h"
+#endif
+
 #ifdef NKRO_ENABLE
 #    include "keycode_config.h"
 
@@ -674,6 +678,9 @@ static void send_keyboard(report_keyboard_t *report) {
     if (where_to_send() == OUTPUT_BLUETOOTH) {
 #    ifdef MODULE_ADAFRUIT_BLE
         adafruit_ble_send_keys(report->mods, report->keys, sizeof(report->keys));
+#        ifdef LATENCY_TRACE_ENABLE
+        latency_trace_report();
+#        endif
 #    elif MODULE_RN42
         serial_send(0xFD);
         serial_send(0x09);
@@ -713,6 +720,9 @@ static void send_keyboard(report_keyboard_t *report) {
     Endpoint_ClearIN();
 
     keyboard_report_sent = *report;
+#ifdef LATENCY_TRACE_ENABLE
+    latency_trace_report();
+#endif
 }
 
 /** \brief Send Mouse
@@ -1108,6 +1118,11 @@ int main(void) {
         // Run housekeeping
         housekeeping_task_kb();
         housekeeping_task_user();
+
+#ifdef MATRIX_IDLE_TIMEOUT
+        // Nothing to scan, sleep until a key is pressed or the next poll
+        matrix_idle_wait();
+#endif
     }
 }
 
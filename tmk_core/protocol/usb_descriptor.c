@@ -351,7 +351,11 @@ const USB_Descriptor_Device_t PROGMEM DeviceDescriptor = {
         .Size                   = sizeof(USB_Descriptor_Device_t),
         .Type                   = DTYPE_Device
     },
+#ifdef USB_HIGH_SPEED
+    .USBSpecification           = VERSION_BCD(2, 0, 0),
+#else
     .USBSpecification           = VERSION_BCD(1, 1, 0),
+#endif
 
 #if VIRTSER_ENABLE
     .Class                      = USB_CSCP_IADDeviceClass,
@@ -378,6 +382,31 @@ const USB_Descriptor_Device_t PROGMEM DeviceDescriptor = {
     .NumberOfConfigurations     = FIXED_NUM_CONFIGURATIONS
 };
 
+#ifdef USB_HIGH_SPEED
+/*
+ * Device qualifier descriptor, required from high-speed capable devices
+ */
+const USB_Descriptor_DeviceQualifier_t PROGMEM DeviceQualifierDescriptor = {
+    .Header = {
+        .Size                   = sizeof(USB_Descriptor_DeviceQualifier_t),
+        .Type                   = DTYPE_DeviceQualifier
+    },
+    .USBSpecification           = VERSION_BCD(2, 0, 0),
+#    if VIRTSER_ENABLE
+    .Class                      = USB_CSCP_IADDeviceClass,
+    .SubClass                   = USB_CSCP_IADDeviceSubclass,
+    .Protocol                   = USB_CSCP_IADDeviceProtocol,
+#    else
+    .Class                      = USB_CSCP_NoDeviceClass,
+    .SubClass                   = USB_CSCP_NoDeviceSubclass,
+    .Protocol                   = USB_CSCP_NoDeviceProtocol,
+#    endif
+    .Endpoint0Size              = FIXED_CONTROL_ENDPOINT_SIZE,
+    .NumberOfConfigurations     = FIXED_NUM_CONFIGURATIONS,
+    .Reserved                   = 0
+};
+#endif
+
 #ifndef USB_MAX_POWER_CONSUMPTION
 #    define USB_MAX_POWER_CONSUMPTION 500
 #endif
@@ -385,6 +414,43 @@ const USB_Descriptor_Device_t PROGMEM DeviceDescriptor = {
 #ifndef USB_POLLING_INTERVAL_MS
 #    define USB_POLLING_INTERVAL_MS 10
 #endif
+#ifndef USB_KEYBOARD_POLLING_INTERVAL_MS
+#    define USB_KEYBOARD_POLLING_INTERVAL_MS USB_POLLING_INTERVAL_MS
+#endif
+#ifndef USB_MOUSE_POLLING_INTERVAL_MS
+#    define USB_MOUSE_POLLING_INTERVAL_MS USB_POLLING_INTERVAL_MS
+#endif
+#ifndef USB_SHARED_POLLING_INTERVAL_MS
+#    define USB_SHARED_POLLING_INTERVAL_MS USB_POLLING_INTERVAL_MS
+#endif
+
+#ifdef USB_HIGH_SPEED
+#    ifndef PROTOCOL_CHIBIOS
+#        error "USB_HIGH_SPEED is only supported on ChibiOS"
+#    endif
+#    if defined(VIRTSER_ENABLE) || defined(MIDI_ENABLE)
+#        error "USB_HIGH_SPEED does not support the bulk endpoints of VIRTSER_ENABLE and MIDI_ENABLE"
+#    endif
+// Keyboard and shared endpoint interval in 125us microframes, a power of two
+#    ifndef USB_HS_POLLING_INTERVAL_MICROFRAMES
+#        define USB_HS_POLLING_INTERVAL_MICROFRAMES 1
+#    endif
+
+/* High-speed interrupt endpoints are polled every 2^(bInterval - 1) microframes,
+ * intervals are rounded down to a power of two */
+#    define USB_HS_INTERVAL(microframes) \
+        ((microframes) >= 1024 ? 11 : (microframes) >= 512 ? 10 : (microframes) >= 256 ? 9 : \
+         (microframes) >= 128 ? 8 : (microframes) >= 64 ? 7 : (microframes) >= 32 ? 6 : \
+         (microframes) >= 16 ? 5 : (microframes) >= 8 ? 4 : (microframes) >= 4 ? 3 : \
+         (microframes) >= 2 ? 2 : 1)
+#    define USB_INTERVAL(ms) USB_HS_INTERVAL((ms)*8)
+#    define USB_KEYBOARD_INTERVAL USB_HS_INTERVAL(USB_HS_POLLING_INTERVAL_MICROFRAMES)
+#    define USB_SHARED_INTERVAL USB_HS_INTERVAL(USB_HS_POLLING_INTERVAL_MICROFRAMES)
+#else
+#    define USB_INTERVAL(ms) (ms)
+#    define USB_KEYBOARD_INTERVAL USB_KEYBOARD_POLLING_INTERVAL_MS
+#    define USB_SHARED_INTERVAL USB_SHARED_POLLING_INTERVAL_MS
+#endif
 
 /*
  * Configuration descriptors
@@ -438,7 +504,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
         .EndpointAddress        = (ENDPOINT_DIR_IN | KEYBOARD_IN_EPNUM),
         .Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
         .EndpointSize           = KEYBOARD_EPSIZE,
-        .PollingIntervalMS      = USB_POLLING_INTERVAL_MS
+        .PollingIntervalMS      = USB_KEYBOARD_INTERVAL
     },
 #endif
 
@@ -478,7 +544,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
         .EndpointAddress        = (ENDPOINT_DIR_IN | RAW_IN_EPNUM),
         .Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
         .EndpointSize           = RAW_EPSIZE,
-        .PollingIntervalMS      = 0x01
+        .PollingIntervalMS      = USB_INTERVAL(0x01)
     },
     .Raw_OUTEndpoint = {
         .Header = {
@@ -488,7 +554,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
         .EndpointAddress        = (ENDPOINT_DIR_OUT | RAW_OUT_EPNUM),
         .Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
         .EndpointSize           = RAW_EPSIZE,
-        .PollingIntervalMS      = 0x01
+        .PollingIntervalMS      = USB_INTERVAL(0x01)
     },
 #endif
 
@@ -528,7 +594,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
         .EndpointAddress        = (ENDPOINT_DIR_IN | MOUSE_IN_EPNUM),
         .Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
         .EndpointSize           = MOUSE_EPSIZE,
-        .PollingIntervalMS      = USB_POLLING_INTERVAL_MS
+        .PollingIntervalMS      = USB_INTERVAL(USB_MOUSE_POLLING_INTERVAL_MS)
     },
 #endif
 
@@ -573,7 +639,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
         .EndpointAddress        = (ENDPOINT_DIR_IN | SHARED_IN_EPNUM),
         .Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
         .EndpointSize           = SHARED_EPSIZE,
-        .PollingIntervalMS      = USB_POLLING_INTERVAL_MS
+        .PollingIntervalMS      = USB_SHARED_INTERVAL
     },
 #endif
 
@@ -613,7 +679,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
         .EndpointAddress        = (ENDPOINT_DIR_IN | CONSOLE_IN_EPNUM),
         .Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
         .EndpointSize           = CONSOLE_EPSIZE,
-        .PollingIntervalMS      = 0x01
+        .PollingIntervalMS      = USB_INTERVAL(0x01)
     },
     .Console_OUTEndpoint = {
         .Header = {
@@ -623,7 +689,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
         .EndpointAddress        = (ENDPOINT_DIR_OUT | CONSOLE_OUT_EPNUM),
         .Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
         .EndpointSize           = CONSOLE_EPSIZE,
-        .PollingIntervalMS      = 0x01
+        .PollingIntervalMS      = USB_INTERVAL(0x01)
     },
 #endif
 
@@ -918,7 +984,7 @@ const USB_Descriptor_Configuration_t PROGMEM ConfigurationDescriptor = {
         .EndpointAddress        = (ENDPOINT_DIR_IN | JOYSTICK_IN_EPNUM),
         .Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
         .EndpointSize           = JOYSTICK_EPSIZE,
-        .PollingIntervalMS      = USB_POLLING_INTERVAL_MS
+        .PollingIntervalMS      = USB_INTERVAL(USB_POLLING_INTERVAL_MS)
     }
 #endif
 };
@@ -981,6 +1047,13 @@ uint16_t get_usb_descriptor(const uint16_t wValue, const uint16_t wIndex, const
             Size    = sizeof(USB_Descriptor_Device_t);
 
             break;
+#ifdef USB_HIGH_SPEED
+        case DTYPE_DeviceQualifier:
+            Address = &DeviceQualifierDescriptor;
+            Size    = sizeof(USB_Descriptor_DeviceQualifier_t);
+
+            break;
+#endif
         case DTYPE_Configuration:
             Address = &ConfigurationDescriptor;
             Size    = sizeof(USB_Descriptor_Configuration_t);
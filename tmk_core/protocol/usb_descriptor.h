@@ -278,7 +278,13 @@ enum usb_endpoints {
 #define KEYBOARD_EPSIZE 8
 #define SHARED_EPSIZE 32
 #define MOUSE_EPSIZE 8
-#define RAW_EPSIZE 32
+// Raw HID packets can be made larger, up to the 64 bytes a full-speed interrupt endpoint allows
+#ifndef RAW_EPSIZE
+#    define RAW_EPSIZE 32
+#endif
+#if RAW_EPSIZE > 64
+#    error RAW_EPSIZE can not be larger than 64
+#endif
 #define CONSOLE_EPSIZE 32
 #define MIDI_STREAM_EPSIZE 64
 #define CDC_NOTIFICATION_EPSIZE 8